@@ -0,0 +1,378 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// can_capture.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Compact binary CAN captures
+//
+// A capture is an 8 byte header followed by a stream of records. The first record of a new
+// frame layout (ID, extended, RTR, DLC) defines a dictionary entry, and from then on frames
+// of that layout are written as
+//
+//   [entry index, 1 byte] [timestamp delta, varint] [change mask, 1 byte] [changed bytes]
+//
+// Bit n of the change mask is set when payload byte n differs from the previous frame of the
+// same entry, and only those bytes follow. Most frames on the bus repeat or change one or two
+// bytes, so a typical frame takes 3 to 5 bytes against 35 to 160 bytes of CSV text. Frames
+// with DLC 0 have no mask. Records:
+//
+//   0x00-0xEF  frame of dictionary entry n
+//   0xF0       define the next entry: id (4 bytes LE, bit 31 extended, bit 30 RTR), DLC
+//   0xF1       frame outside the dictionary (once it is full): id, DLC, delta, full payload
+//   0xF2       reset: dictionary emptied and timestamp base back to 0 (a new session)
+//   0xF3       key: a reset followed by the 4 magic bytes of the header (version 2)
+//
+// The price of storing only changed bytes is that a frame can't be decoded without every
+// record of its entry before it: a stream cut at the end decodes up to the cut, but one
+// missing a piece decodes nothing after the hole. So the writer puts a key record every
+// CAN_CAPTURE_KEY_INTERVAL frames. Everything after a key decodes on its own, and the magic
+// makes keys easy to find again (canCaptureFindKey()): a damaged stream loses at most the
+// frames up to the next key, for about 4% more bytes than without keys.
+//
+// Timestamps are micros() of the frame, stored as the unsigned 32 bit difference from the
+// previous frame (LEB128 varint, 1 to 5 bytes), so the micros() wrap costs nothing.
+// Multi-byte fields are little endian.
+//
+// CANCaptureWriter encodes into a buffer the caller provides (at most CAN_CAPTURE_MAX_RECORD
+// bytes per frame), CANCaptureReader decodes from one; neither allocates or does any I/O,
+// so the same code runs in the firmware and in the host tools.
+
+#ifndef __CAN_CAPTURE__
+#define __CAN_CAPTURE__
+
+#include <stdint.h>
+#include <string.h>
+#include <can_common.h>
+
+#define CAN_CAPTURE_VERSION                          2  // 1 had no key records, still read
+#define CAN_CAPTURE_HEADER_SIZE                      8
+#define CAN_CAPTURE_MAX_RECORD                       26 // key (5) + define (6) + frame (1 + 5 + 1 + 8)
+#define CAN_CAPTURE_DICT_SIZE                        240
+#define CAN_CAPTURE_KEY_INTERVAL                     1024 // frames between key records
+#define CAN_CAPTURE_KEY_SIZE                         5
+
+#define CAN_CAPTURE_TAG_DEFINE                       0xF0
+#define CAN_CAPTURE_TAG_LITERAL                      0xF1
+#define CAN_CAPTURE_TAG_RESET                        0xF2
+#define CAN_CAPTURE_TAG_KEY                          0xF3
+
+#define CAN_CAPTURE_ID_EXTENDED                      0x80000000ul
+#define CAN_CAPTURE_ID_RTR                           0x40000000ul
+
+#define CAN_CAPTURE_HASH_SIZE                        512 // power of two, > 2x CAN_CAPTURE_DICT_SIZE
+
+// CANCaptureReader::next() results besides a byte count
+#define CAN_CAPTURE_MORE                             0  // record incomplete, call again with more bytes
+#define CAN_CAPTURE_ERROR                            -1 // not a capture stream
+
+static const uint8_t canCaptureMagic[4] = {'C', 'D', 'C', 'P'};
+
+// Header: magic, version, 3 reserved bytes
+inline size_t canCaptureHeader(uint8_t *out)
+{
+    memcpy(out, canCaptureMagic, 4);
+    out[4] = CAN_CAPTURE_VERSION;
+    out[5] = out[6] = out[7] = 0;
+    return CAN_CAPTURE_HEADER_SIZE;
+}
+
+inline bool canCaptureIsHeader(const uint8_t *in, size_t len)
+{
+    return len >= CAN_CAPTURE_HEADER_SIZE && !memcmp(in, canCaptureMagic, 4) && in[4] >= 1 &&
+           in[4] <= CAN_CAPTURE_VERSION;
+}
+
+// Offset of the first key record in in, len if there is none. Decoding can start there.
+inline size_t canCaptureFindKey(const uint8_t *in, size_t len)
+{
+    for (size_t i = 0; i + CAN_CAPTURE_KEY_SIZE <= len; i++)
+        if (in[i] == CAN_CAPTURE_TAG_KEY && !memcmp(in + i + 1, canCaptureMagic, 4))
+            return i;
+    return len;
+}
+
+inline uint32_t canCaptureKey(const CAN_FRAME &frame)
+{
+    return (frame.id & 0x1FFFFFFFul) | (frame.extended ? CAN_CAPTURE_ID_EXTENDED : 0) |
+           (frame.rtr ? CAN_CAPTURE_ID_RTR : 0);
+}
+
+class CANCaptureWriter
+{
+public:
+    CANCaptureWriter() { clear(); }
+
+    // Starts a new session inside the same stream: writes a reset record
+    size_t reset(uint8_t *out)
+    {
+        clear();
+        out[0] = CAN_CAPTURE_TAG_RESET;
+        return 1;
+    }
+
+    // Encodes frame into out (room for CAN_CAPTURE_MAX_RECORD bytes), returns the bytes used
+    size_t encode(const CAN_FRAME &frame, uint8_t *out)
+    {
+        uint32_t key = canCaptureKey(frame);
+        uint8_t dlc = frame.length > 8 ? 8 : frame.length;
+        uint8_t *p = out;
+
+        if (sinceKey >= CAN_CAPTURE_KEY_INTERVAL)
+        {
+            clear();
+            *p++ = CAN_CAPTURE_TAG_KEY;
+            memcpy(p, canCaptureMagic, 4);
+            p += 4;
+        }
+        sinceKey++;
+
+        int entry = find(key, dlc);
+        if (entry < 0 && count < CAN_CAPTURE_DICT_SIZE)
+        {
+            entry = add(key, dlc);
+            *p++ = CAN_CAPTURE_TAG_DEFINE;
+            p = put32(p, key);
+            *p++ = dlc;
+        }
+        if (entry >= 0)
+            *p++ = (uint8_t)entry;
+        else
+        {
+            *p++ = CAN_CAPTURE_TAG_LITERAL;
+            p = put32(p, key);
+            *p++ = dlc;
+        }
+
+        uint32_t delta = frame.timestamp - lastTimestamp;
+        lastTimestamp = frame.timestamp;
+        while (delta >= 0x80)
+        {
+            *p++ = (uint8_t)(delta | 0x80);
+            delta >>= 7;
+        }
+        *p++ = (uint8_t)delta;
+
+        if (entry < 0)
+        {
+            memcpy(p, frame.data.byte, dlc);
+            return p + dlc - out;
+        }
+        if (dlc == 0)
+            return p - out;
+
+        uint8_t *mask = p++;
+        uint8_t *last = payloads[entry];
+        *mask = 0;
+        for (int i = 0; i < dlc; i++)
+            if (frame.data.byte[i] != last[i])
+            {
+                *mask |= 1 << i;
+                *p++ = last[i] = frame.data.byte[i];
+            }
+        return p - out;
+    }
+
+    int dictionarySize() const { return count; }
+
+private:
+    void clear()
+    {
+        count = 0;
+        lastTimestamp = 0;
+        sinceKey = 0;
+        memset(slots, 0, sizeof(slots));
+    }
+
+    static inline uint32_t hash(uint32_t key, uint8_t dlc)
+    {
+        return ((key ^ dlc) * 2654435761u) >> 23; // top 9 bits index CAN_CAPTURE_HASH_SIZE
+    }
+
+    int find(uint32_t key, uint8_t dlc) const
+    {
+        for (uint32_t pos = hash(key, dlc); slots[pos]; pos = (pos + 1) & (CAN_CAPTURE_HASH_SIZE - 1))
+        {
+            int e = slots[pos] - 1;
+            if (keys[e] == key && dlcs[e] == dlc)
+                return e;
+        }
+        return -1;
+    }
+
+    int add(uint32_t key, uint8_t dlc)
+    {
+        uint32_t pos = hash(key, dlc);
+        while (slots[pos])
+            pos = (pos + 1) & (CAN_CAPTURE_HASH_SIZE - 1);
+        keys[count] = key;
+        dlcs[count] = dlc;
+        memset(payloads[count], 0, 8);
+        slots[pos] = ++count; // entry + 1, 0 marks a free slot
+        return count - 1;
+    }
+
+    static inline uint8_t *put32(uint8_t *p, uint32_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+        return p + 4;
+    }
+
+    uint32_t keys[CAN_CAPTURE_DICT_SIZE];
+    uint8_t dlcs[CAN_CAPTURE_DICT_SIZE];
+    uint8_t payloads[CAN_CAPTURE_DICT_SIZE][8]; // last payload of every entry
+    uint8_t slots[CAN_CAPTURE_HASH_SIZE];
+    int count;
+    uint32_t lastTimestamp;
+    uint32_t sinceKey; // frames since the last reset or key
+};
+
+class CANCaptureReader
+{
+public:
+    CANCaptureReader() { clear(); }
+
+    void clear()
+    {
+        count = 0;
+        lastTimestamp = 0;
+    }
+
+    // Consumes one record from in. Returns the bytes it used (frame is true when the record
+    // was a frame and out holds it), CAN_CAPTURE_MORE if the record continues past len, or
+    // CAN_CAPTURE_ERROR. The header is not a record, skip it with canCaptureIsHeader().
+    int next(const uint8_t *in, size_t len, CAN_FRAME &out, bool &frame)
+    {
+        frame = false;
+        if (len == 0)
+            return CAN_CAPTURE_MORE;
+
+        const uint8_t *p = in, *end = in + len;
+        uint32_t key;
+        uint8_t dlc;
+        uint8_t tag = *p++;
+
+        switch (tag)
+        {
+        case CAN_CAPTURE_TAG_RESET:
+            clear();
+            return 1;
+        case CAN_CAPTURE_TAG_KEY:
+            if (len < CAN_CAPTURE_KEY_SIZE)
+                return CAN_CAPTURE_MORE;
+            if (memcmp(p, canCaptureMagic, 4))
+                return CAN_CAPTURE_ERROR;
+            clear();
+            return CAN_CAPTURE_KEY_SIZE;
+        case CAN_CAPTURE_TAG_DEFINE:
+            if (len < 6)
+                return CAN_CAPTURE_MORE;
+            if (count >= CAN_CAPTURE_DICT_SIZE || in[5] > 8)
+                return CAN_CAPTURE_ERROR;
+            keys[count] = get32(p);
+            dlcs[count] = in[5];
+            memset(payloads[count++], 0, 8);
+            return 6;
+        case CAN_CAPTURE_TAG_LITERAL:
+            if (len < 6)
+                return CAN_CAPTURE_MORE;
+            key = get32(p);
+            dlc = in[5];
+            if (dlc > 8)
+                return CAN_CAPTURE_ERROR;
+            p += 5;
+            break;
+        default:
+            if (tag >= count)
+                return CAN_CAPTURE_ERROR;
+            key = keys[tag];
+            dlc = dlcs[tag];
+            break;
+        }
+
+        uint32_t delta = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            if (p >= end)
+                return CAN_CAPTURE_MORE;
+            if (shift > 28)
+                return CAN_CAPTURE_ERROR;
+            uint8_t b = *p++;
+            delta |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        const uint8_t *payload = p;
+        uint8_t changed = 0;
+        if (tag == CAN_CAPTURE_TAG_LITERAL)
+        {
+            if (end - p < dlc)
+                return CAN_CAPTURE_MORE;
+            p += dlc;
+        }
+        else if (dlc)
+        {
+            if (p >= end)
+                return CAN_CAPTURE_MORE;
+            changed = *p++;
+            if (changed >> dlc)
+                return CAN_CAPTURE_ERROR;
+            if (end - p < __builtin_popcount(changed))
+                return CAN_CAPTURE_MORE;
+            uint8_t *last = payloads[tag];
+            for (int i = 0; i < dlc; i++)
+                if (changed & (1 << i))
+                    last[i] = *p++;
+            payload = last;
+        }
+
+        out = CAN_FRAME();
+        out.id = key & 0x1FFFFFFFul;
+        out.extended = (key & CAN_CAPTURE_ID_EXTENDED) ? 1 : 0;
+        out.rtr = (key & CAN_CAPTURE_ID_RTR) ? 1 : 0;
+        out.length = dlc;
+        memcpy(out.data.byte, payload, dlc);
+        lastTimestamp += delta;
+        out.timestamp = lastTimestamp;
+        frame = true;
+        return p - in;
+    }
+
+private:
+    static inline uint32_t get32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+
+    uint32_t keys[CAN_CAPTURE_DICT_SIZE];
+    uint8_t dlcs[CAN_CAPTURE_DICT_SIZE];
+    uint8_t payloads[CAN_CAPTURE_DICT_SIZE][8];
+    int count;
+    uint32_t lastTimestamp;
+};
+
+#endif
@@ -0,0 +1,188 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// can_signal.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Table driven CAN signal decoding
+//
+// A signal is described once, DBC style: frame ID, start bit, length, byte order,
+// signedness, scale, offset and the value slot it lands in. CAN_SIGNAL_DEF() turns the
+// layout part into its own extractor function at compile time, so decoding a signal is a
+// single 64 bit load, shift and mask with no per-bit loop and no branches on the layout.
+//
+// Multiplexed signals carry the layout of their multiplexor too and are only decoded when the
+// multiplexor holds their value.
+//
+// Start bits follow the DBC convention: for little endian (Intel, @1) signals the start bit
+// is the least significant bit, for big endian (Motorola, @0) signals it is the most
+// significant one, counted bit 7..0 of byte 0, then bit 15..8 of byte 1 and so on.
+//
+// Kept free of Arduino dependencies so the host tools decode with exactly the same code.
+
+#ifndef __CAN_SIGNAL__
+#define __CAN_SIGNAL__
+
+#include <stdint.h>
+#include <string.h>
+#include <can_common.h>
+
+#define CAN_BIG_ENDIAN                               0  // Motorola, DBC @0
+#define CAN_LITTLE_ENDIAN                            1  // Intel, DBC @1
+
+typedef int32_t (*CANSignalExtract)(const uint8_t *data);
+
+struct CAN_SIGNAL
+{
+    uint32_t frameId;
+    bool extended;
+    CANSignalExtract extract; // raw value, already sign extended
+    float scale;
+    float offset;
+    int slot;                 // index in the value store
+    CANSignalExtract mux;     // multiplexor of the frame, NULL if the signal is always present
+    int32_t muxValue;
+};
+
+// Payload as one 64 bit word. ESP32 and the host are both little endian
+inline uint64_t canPayloadLE(const uint8_t *data)
+{
+    uint64_t word;
+    memcpy(&word, data, 8);
+    return word;
+}
+
+inline uint64_t canPayloadBE(const uint8_t *data)
+{
+    return __builtin_bswap64(canPayloadLE(data));
+}
+
+// Where a signal sits in the word returned by canPayloadLE/BE for its byte order
+template <uint8_t Start, uint8_t Length, uint8_t Order>
+struct CANSignalLayout
+{
+    static_assert(Length >= 1 && Length <= 32, "signals are decoded into 32 bits");
+    static_assert(Start < 64, "start bit outside the 8 data bytes");
+
+    static constexpr int shift = Order == CAN_LITTLE_ENDIAN ? Start : (7 - Start / 8) * 8 + Start % 8 - (Length - 1);
+    static constexpr uint64_t mask = (1ull << Length) - 1;
+
+    static_assert(shift >= 0 && shift + Length <= 64, "signal runs past the 8 data bytes");
+};
+
+template <uint8_t Start, uint8_t Length, uint8_t Order, bool Signed>
+int32_t canSignalExtract(const uint8_t *data)
+{
+    typedef CANSignalLayout<Start, Length, Order> Layout;
+    uint64_t word = Order == CAN_LITTLE_ENDIAN ? canPayloadLE(data) : canPayloadBE(data);
+    uint32_t raw = (uint32_t)((word >> Layout::shift) & Layout::mask);
+    if (Signed && Length < 32)
+        return (int32_t)(raw << (32 - Length)) >> (32 - Length);
+    return (int32_t)raw;
+}
+
+#define CAN_SIGNAL_DEF(frameId, extended, start, length, order, isSigned, scale, offset, slot) \
+    {frameId, extended, &canSignalExtract<start, length, order, isSigned>, scale, offset, slot, nullptr, 0}
+
+#define CAN_SIGNAL_MUX_DEF(frameId, extended, start, length, order, isSigned, scale, offset,      \
+                           muxStart, muxLength, muxOrder, muxValue, slot)                         \
+    {frameId, extended, &canSignalExtract<start, length, order, isSigned>, scale, offset, slot, \
+     &canSignalExtract<muxStart, muxLength, muxOrder, false>, muxValue}
+
+// Tables must be sorted by frame ID so canDecodeFrame() can binary search them
+constexpr bool canSignalsSorted(const CAN_SIGNAL *table, int count)
+{
+    return count < 2 || (table[0].frameId <= table[1].frameId && canSignalsSorted(table + 1, count - 1));
+}
+
+// Decodes every signal of the table carried by this frame into values[]. Returns how many
+// signals were written.
+inline int canDecodeFrame(const CAN_SIGNAL *table, int count, const CAN_FRAME &frame, int *values)
+{
+    int lo = 0, hi = count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (table[mid].frameId < frame.id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    int decoded = 0;
+    for (; lo < count && table[lo].frameId == frame.id; lo++)
+    {
+        const CAN_SIGNAL &s = table[lo];
+        if (s.extended != (bool)frame.extended || (s.mux && s.mux(frame.data.byte) != s.muxValue))
+            continue;
+        values[s.slot] = (int)(s.extract(frame.data.byte) * s.scale + s.offset);
+        decoded++;
+    }
+    return decoded;
+}
+
+// ---- Descriptors generated from DBC files (tools/dbc2header.py)
+//
+// Names, units, ranges and value tables for menus and tools. The decoder itself only needs
+// the CAN_SIGNAL entries the generated headers provide as macros.
+
+#define DBC_MUX_NONE                                 0
+#define DBC_MUX_MULTIPLEXOR                          1  // selects which multiplexed signals are present
+#define DBC_MUX_MULTIPLEXED                          2  // present when the multiplexor equals muxValue
+
+struct DBC_VALUE
+{
+    int32_t value;
+    const char *description;
+};
+
+struct DBC_SIGNAL
+{
+    const char *name;
+    uint8_t start;
+    uint8_t length;
+    uint8_t order;
+    bool isSigned;
+    float scale;
+    float offset;
+    float minimum;
+    float maximum;
+    const char *unit;
+    uint8_t muxRole;
+    int32_t muxValue;
+    const DBC_VALUE *values; // value table, NULL if none
+    uint8_t valueCount;
+};
+
+struct DBC_MESSAGE
+{
+    uint32_t id;
+    bool extended;
+    const char *name;
+    uint8_t length;
+    const DBC_SIGNAL *signals;
+    uint8_t signalCount;
+};
+
+#endif
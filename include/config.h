@@ -32,6 +32,22 @@
 #define     SCREEN_TIMEOUT_DELAY     5000               // milliseconds before screen timeout
 #define     USE_EEPROM               false              // use EEPROM for settings storage
 #define     USE_MENU                 true               // use the unified menu system
+#define     CAN_WATCH_ALL            false              // accept every CAN frame, not just the decoded ones
+#define     CAN_MAILBOX_MODE         false              // keep only the newest frame per ID instead of queueing
+#define     OLED_TILE_UPDATES        true               // send only the changed 8x8 tiles of the OLED ('o' on serial)
+#define     OLED_ASYNC_FLUSH         true               // send frames to the OLED from a task on core 0, loop() never waits for I2C
+#define     GLYPH_CACHE              true               // draw the large readout from digits rasterized at boot
+#define     CAN_ID_PROFILER          true               // per-ID frame rate, jitter and payload change stats ('p' on serial, BUS PROFILE menu).
+                                                        // Runs only while the page is open or after 'b' on serial, and the TWAI hardware filter
+                                                        // is off meanwhile (every frame wakes the RX task)
+#define     SHIFT_LIGHT_TABLE        true               // shift light from frames precomputed per RPM bucket, show() only on a change ('w' on serial)
+#define     LATENCY_INSTRUMENTATION  true               // measure CAN frame to shift light latency ('l' on serial)
+#define     BUS_RECORDER             true               // keep the last seconds of CAN traffic, save them to LittleFS on a trigger
+#define     RECORDER_WHOLE_BUS       false              // true: record every frame on the bus, which turns the TWAI hardware filter off for good
+                                                        // (every frame wakes the RX task). false: the frames the hardware filter lets through
+#define     RECORDER_ON_SHIFT        true               // recorder trigger: engine speed reaches MAX RPM
+#define     RECORDER_ON_BUS_ERRORS   true               // recorder trigger: the CAN controller went error passive or bus-off
+#define     RECORDER_ON_LONG_PRESS   true               // recorder trigger: knob held down (a short press still selects)
 
 // Template info (do not change after creating the initial structure)
 #define     BOILERPLATE_VERSION      1.7                // version and date of the boilerplate template 
@@ -0,0 +1,218 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// dbc_abarth500.h
+//
+// Generated by tools/dbc2header.py from dbc/abarth500.dbc. Do not edit, change the DBC instead.
+// ==========================================================================================
+
+#ifndef __DBC_ABARTH500__
+#define __DBC_ABARTH500__
+
+#include "can_signal.h"
+
+// ---- Frame IDs
+
+#define DBC_ABARTH500_ID0010A006_ID 0x0010A006
+#define DBC_ABARTH500_ID0028A006_ID 0x0028A006
+#define DBC_ABARTH500_ID0028A00F_ID 0x0028A00F
+#define DBC_ABARTH500_ID0030A002_ID 0x0030A002
+#define DBC_ABARTH500_ID0210A006_ID 0x0210A006
+#define DBC_ABARTH500_ID0218A006_ID 0x0218A006
+#define DBC_ABARTH500_ID0220A006_ID 0x0220A006
+#define DBC_ABARTH500_ENGINESTATUS_ID 0x0618A001
+#define DBC_ABARTH500_ID0628A001_ID 0x0628A001
+#define DBC_ABARTH500_ID0810A000_ID 0x0810A000
+#define DBC_ABARTH500_ID0815A101_ID 0x0815A101
+#define DBC_ABARTH500_ID0816A101_ID 0x0816A101
+#define DBC_ABARTH500_ID0A18A000_ID 0x0A18A000
+#define DBC_ABARTH500_ID0A18A001_ID 0x0A18A001
+#define DBC_ABARTH500_ID0A18A002_ID 0x0A18A002
+#define DBC_ABARTH500_ID0A18A006_ID 0x0A18A006
+#define DBC_ABARTH500_ID0A1CA001_ID 0x0A1CA001
+#define DBC_ABARTH500_ID0A20A000_ID 0x0A20A000
+#define DBC_ABARTH500_ID0A28A000_ID 0x0A28A000
+#define DBC_ABARTH500_ID0C1CA000_ID 0x0C1CA000
+#define DBC_ABARTH500_OBDRESPONSE_ID 0x18DAF110
+
+// ---- CAN_SIGNAL entries, pass the value slot the signal should be decoded into
+
+// Id0010A006 (0x10A006, extended)
+
+// Id0028A006 (0x28A006, extended)
+#define DBC_ABARTH500_ID0028A006_BYTE1(slot) CAN_SIGNAL_DEF(0x0028A006, true, 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A006_BYTE2(slot) CAN_SIGNAL_DEF(0x0028A006, true, 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A006_BYTE3(slot) CAN_SIGNAL_DEF(0x0028A006, true, 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A006_BYTE4(slot) CAN_SIGNAL_DEF(0x0028A006, true, 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0028A00F (0x28A00F, extended)
+#define DBC_ABARTH500_ID0028A00F_BYTE0(slot) CAN_SIGNAL_DEF(0x0028A00F, true, 0, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A00F_BYTE2(slot) CAN_SIGNAL_DEF(0x0028A00F, true, 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A00F_BYTE3(slot) CAN_SIGNAL_DEF(0x0028A00F, true, 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A00F_BYTE5(slot) CAN_SIGNAL_DEF(0x0028A00F, true, 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0028A00F_BYTE6(slot) CAN_SIGNAL_DEF(0x0028A00F, true, 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0030A002 (0x30A002, extended)
+#define DBC_ABARTH500_ID0030A002_BYTE7(slot) CAN_SIGNAL_DEF(0x0030A002, true, 56, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0210A006 (0x210A006, extended)
+#define DBC_ABARTH500_ID0210A006_BYTE1(slot) CAN_SIGNAL_DEF(0x0210A006, true, 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0210A006_BYTE6(slot) CAN_SIGNAL_DEF(0x0210A006, true, 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0210A006_BYTE7(slot) CAN_SIGNAL_DEF(0x0210A006, true, 56, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0218A006 (0x218A006, extended)
+
+// Id0220A006 (0x220A006, extended)
+#define DBC_ABARTH500_ID0220A006_BYTE1(slot) CAN_SIGNAL_DEF(0x0220A006, true, 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// EngineStatus (0x618A001, extended)
+// Engine speed, bytes 2-3 big endian. The signal the shift light runs on.
+#define DBC_ABARTH500_ENGINESTATUS_ENGINESPEED(slot) CAN_SIGNAL_DEF(0x0618A001, true, 23, 16, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0628A001 (0x628A001, extended)
+#define DBC_ABARTH500_ID0628A001_BYTE3(slot) CAN_SIGNAL_DEF(0x0628A001, true, 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0628A001_BYTE4(slot) CAN_SIGNAL_DEF(0x0628A001, true, 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0628A001_BYTE5(slot) CAN_SIGNAL_DEF(0x0628A001, true, 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0810A000 (0x810A000, extended)
+#define DBC_ABARTH500_ID0810A000_BYTE2(slot) CAN_SIGNAL_DEF(0x0810A000, true, 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0815A101 (0x815A101, extended)
+#define DBC_ABARTH500_ID0815A101_BYTE0(slot) CAN_SIGNAL_DEF(0x0815A101, true, 0, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0815A101_BYTE3(slot) CAN_SIGNAL_DEF(0x0815A101, true, 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0816A101 (0x816A101, extended)
+
+// Id0A18A000 (0xA18A000, extended)
+
+// Id0A18A001 (0xA18A001, extended)
+#define DBC_ABARTH500_ID0A18A001_BYTE4(slot) CAN_SIGNAL_DEF(0x0A18A001, true, 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0A18A001_BYTE5(slot) CAN_SIGNAL_DEF(0x0A18A001, true, 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0A18A001_BYTE6(slot) CAN_SIGNAL_DEF(0x0A18A001, true, 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0A18A002 (0xA18A002, extended)
+
+// Id0A18A006 (0xA18A006, extended)
+
+// Id0A1CA001 (0xA1CA001, extended)
+#define DBC_ABARTH500_ID0A1CA001_BYTE1(slot) CAN_SIGNAL_DEF(0x0A1CA001, true, 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_ID0A1CA001_BYTE2(slot) CAN_SIGNAL_DEF(0x0A1CA001, true, 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// Id0A20A000 (0xA20A000, extended)
+
+// Id0A28A000 (0xA28A000, extended)
+
+// Id0C1CA000 (0xC1CA000, extended)
+#define DBC_ABARTH500_ID0C1CA000_BYTE5(slot) CAN_SIGNAL_DEF(0x0C1CA000, true, 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, slot)
+
+// ObdResponse (0x18DAF110, extended)
+#define DBC_ABARTH500_OBDRESPONSE_LENGTH(slot) CAN_SIGNAL_DEF(0x18DAF110, true, 7, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, slot)
+#define DBC_ABARTH500_OBDRESPONSE_SERVICE(slot) CAN_SIGNAL_DEF(0x18DAF110, true, 15, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, slot)
+// OBD-II mode 01 response (ISO 15765-4, 29 bit) to a request sent to 0x18DB33F1.
+#define DBC_ABARTH500_OBDRESPONSE_PID(slot) CAN_SIGNAL_DEF(0x18DAF110, true, 23, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, slot)
+// PID 0x0C, (256 * A + B) / 4.
+#define DBC_ABARTH500_OBDRESPONSE_ENGINESPEED(slot) CAN_SIGNAL_MUX_DEF(0x18DAF110, true, 31, 16, CAN_BIG_ENDIAN, false, 0.25f, 0.0f, 23, 8, CAN_BIG_ENDIAN, 12, slot)
+// PID 0x0D.
+#define DBC_ABARTH500_OBDRESPONSE_VEHICLESPEED(slot) CAN_SIGNAL_MUX_DEF(0x18DAF110, true, 31, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 23, 8, CAN_BIG_ENDIAN, 13, slot)
+// PID 0x05, A - 40.
+#define DBC_ABARTH500_OBDRESPONSE_COOLANTTEMPERATURE(slot) CAN_SIGNAL_MUX_DEF(0x18DAF110, true, 31, 8, CAN_BIG_ENDIAN, false, 1.0f, -40.0f, 23, 8, CAN_BIG_ENDIAN, 5, slot)
+
+// ---- Value tables
+
+constexpr DBC_VALUE dbcAbarth500Values_ObdResponse_Service[] = {
+    {65, "ShowCurrentData"},
+};
+constexpr DBC_VALUE dbcAbarth500Values_ObdResponse_PID[] = {
+    {5, "CoolantTemperature"},
+    {12, "EngineSpeed"},
+    {13, "VehicleSpeed"},
+};
+
+// ---- Signal and message descriptors
+
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0028A006[] = {
+    {"Byte1", 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte2", 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte3", 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte4", 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0028A00F[] = {
+    {"Byte0", 0, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte2", 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte3", 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte5", 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte6", 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0030A002[] = {
+    {"Byte7", 56, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0210A006[] = {
+    {"Byte1", 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte6", 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte7", 56, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0220A006[] = {
+    {"Byte1", 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_EngineStatus[] = {
+    {"EngineSpeed", 23, 16, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0.0f, 8000.0f, "rpm", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0628A001[] = {
+    {"Byte3", 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte4", 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte5", 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0810A000[] = {
+    {"Byte2", 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0815A101[] = {
+    {"Byte0", 0, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte3", 24, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0A18A001[] = {
+    {"Byte4", 32, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte5", 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte6", 48, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0A1CA001[] = {
+    {"Byte1", 8, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+    {"Byte2", 16, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_Id0C1CA000[] = {
+    {"Byte5", 40, 8, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, nullptr, 0},
+};
+constexpr DBC_SIGNAL dbcAbarth500Signals_ObdResponse[] = {
+    {"Length", 7, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0.0f, 7.0f, "", 0, 0, nullptr, 0},
+    {"Service", 15, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 0, 0, dbcAbarth500Values_ObdResponse_Service, 1},
+    {"PID", 23, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "", 1, 0, dbcAbarth500Values_ObdResponse_PID, 3},
+    {"EngineSpeed", 31, 16, CAN_BIG_ENDIAN, false, 0.25f, 0.0f, 0.0f, 16383.75f, "rpm", 2, 12, nullptr, 0},
+    {"VehicleSpeed", 31, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0.0f, 255.0f, "km/h", 2, 13, nullptr, 0},
+    {"CoolantTemperature", 31, 8, CAN_BIG_ENDIAN, false, 1.0f, -40.0f, -40.0f, 215.0f, "degC", 2, 5, nullptr, 0},
+};
+
+constexpr DBC_MESSAGE dbcAbarth500Messages[] = {
+    {0x0010A006, true, "Id0010A006", 8, nullptr, 0},
+    {0x0028A006, true, "Id0028A006", 8, dbcAbarth500Signals_Id0028A006, 4},
+    {0x0028A00F, true, "Id0028A00F", 8, dbcAbarth500Signals_Id0028A00F, 5},
+    {0x0030A002, true, "Id0030A002", 8, dbcAbarth500Signals_Id0030A002, 1},
+    {0x0210A006, true, "Id0210A006", 8, dbcAbarth500Signals_Id0210A006, 3},
+    {0x0218A006, true, "Id0218A006", 8, nullptr, 0},
+    {0x0220A006, true, "Id0220A006", 8, dbcAbarth500Signals_Id0220A006, 1},
+    {0x0618A001, true, "EngineStatus", 8, dbcAbarth500Signals_EngineStatus, 1},
+    {0x0628A001, true, "Id0628A001", 8, dbcAbarth500Signals_Id0628A001, 3},
+    {0x0810A000, true, "Id0810A000", 8, dbcAbarth500Signals_Id0810A000, 1},
+    {0x0815A101, true, "Id0815A101", 8, dbcAbarth500Signals_Id0815A101, 2},
+    {0x0816A101, true, "Id0816A101", 8, nullptr, 0},
+    {0x0A18A000, true, "Id0A18A000", 8, nullptr, 0},
+    {0x0A18A001, true, "Id0A18A001", 8, dbcAbarth500Signals_Id0A18A001, 3},
+    {0x0A18A002, true, "Id0A18A002", 8, nullptr, 0},
+    {0x0A18A006, true, "Id0A18A006", 8, nullptr, 0},
+    {0x0A1CA001, true, "Id0A1CA001", 8, dbcAbarth500Signals_Id0A1CA001, 2},
+    {0x0A20A000, true, "Id0A20A000", 8, nullptr, 0},
+    {0x0A28A000, true, "Id0A28A000", 8, nullptr, 0},
+    {0x0C1CA000, true, "Id0C1CA000", 8, dbcAbarth500Signals_Id0C1CA000, 1},
+    {0x18DAF110, true, "ObdResponse", 8, dbcAbarth500Signals_ObdResponse, 6},
+};
+
+#define DBC_ABARTH500_MESSAGE_COUNT 21
+
+#endif
@@ -0,0 +1,223 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// display.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- OLED transmission
+//
+// Screens are still drawn from scratch into u8g2's frame buffer, but displaySend() replaces
+// u8g2.sendBuffer(): with OLED_TILE_UPDATES only the tiles that differ from the last frame
+// that went out cross the I2C bus (oled_tiles.h). A redraw with a new RPM value changes a
+// few digits, 100 to 300 bytes instead of 1024, and an unchanged screen sends nothing.
+//
+// With OLED_ASYNC_FLUSH the I2C transfer leaves loop() altogether. displaySend() copies the
+// finished frame into one of three buffers and returns; a task on the other core streams it
+// to the panel while loop() goes on polling the knob, draining CAN0 and driving the strip.
+// The buffers rotate through a single handoff slot swapped with an atomic exchange, no lock:
+//
+//   loop()      renders into u8g2, copies into its back buffer, swaps it into the slot
+//   flush task  swaps the slot with its front buffer when it holds a new frame, sends it
+//
+// If loop() hands over a frame before the task took the previous one, the older frame is
+// dropped and only the latest one is sent. loop() never waits for the display bus.
+//
+// 'o' on serial prints the counters, 'O' clears them.
+
+#include "oled_tiles.h"
+
+#define DISPLAY_TASK_STACK                        3072
+#define DISPLAY_TASK_PRIORITY                        1
+#define DISPLAY_TASK_CORE                            0  // loop() runs on core 1
+#define DISPLAY_FRESH                                4  // handoff slot flag: holds a frame not yet taken
+
+OledTileTracker displayTiles;  // only used by whoever transmits: the flush task, or loop() without it
+uint8_t displayFrames[3][OLED_BUFFER_SIZE];
+int displayBack = 0;           // loop()'s buffer
+int displayReady = 1;          // handoff slot: buffer index, | DISPLAY_FRESH while it holds a new frame
+int displayFront = 2;          // the flush task's buffer
+bool displayResync = true;     // the next transmission repaints the whole panel
+bool displayFlushing = false;  // the flush task is sending a frame
+TaskHandle_t displayTask = NULL;
+
+uint32_t displayHanded = 0;    // frames given to the flush task
+uint32_t displayDropped = 0;   // of which were replaced by a newer one before being sent
+uint32_t displayFullFrames = 0; // frames sent whole because tile updates are off
+uint32_t displaySendLastUs = 0; // time on the I2C bus for the latest frame
+uint32_t displaySendMaxUs = 0;
+
+// Sends one frame buffer to the panel, only the changed tiles with OLED_TILE_UPDATES
+void displayTransmit(uint8_t *frame)
+{
+  u8x8_t *u8x8 = u8g2.getU8x8();
+  uint32_t start = micros();
+
+  if (__atomic_exchange_n(&displayResync, false, __ATOMIC_ACQ_REL))
+    displayTiles.invalidate();
+
+  if (OLED_TILE_UPDATES)
+    displayTiles.flush(frame, [u8x8, frame](int tx, int ty, int tw)
+                       { u8x8_DrawTile(u8x8, tx, ty, tw, frame + (ty * OLED_TILE_COLS + tx) * OLED_TILE_BYTES); });
+  else
+  {
+    for (int ty = 0; ty < OLED_TILE_ROWS; ty++)
+      u8x8_DrawTile(u8x8, 0, ty, OLED_TILE_COLS, frame + ty * OLED_TILE_COLS * OLED_TILE_BYTES);
+    displayFullFrames++;
+  }
+
+  displaySendLastUs = micros() - start;
+  if (displaySendLastUs > displaySendMaxUs)
+    displaySendMaxUs = displaySendLastUs;
+}
+
+void displayFlushTask(void *)
+{
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    __atomic_store_n(&displayFlushing, true, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&displayReady, __ATOMIC_ACQUIRE) & DISPLAY_FRESH)
+    {
+      displayFront = __atomic_exchange_n(&displayReady, displayFront, __ATOMIC_ACQ_REL) & ~DISPLAY_FRESH;
+      displayTransmit(displayFrames[displayFront]);
+    }
+    __atomic_store_n(&displayFlushing, false, __ATOMIC_RELEASE);
+  }
+}
+
+void displaySetup()
+{
+  if (OLED_ASYNC_FLUSH)
+    xTaskCreatePinnedToCore(displayFlushTask, "display", DISPLAY_TASK_STACK, NULL, DISPLAY_TASK_PRIORITY,
+                            &displayTask, DISPLAY_TASK_CORE);
+}
+
+// Hands the frame drawn in u8g2 to the panel: queued for the flush task, or sent right away
+// without it
+void displaySend()
+{
+  if (!displayTask)
+  {
+    displayTransmit(u8g2.getBufferPtr());
+    return;
+  }
+
+  memcpy(displayFrames[displayBack], u8g2.getBufferPtr(), OLED_BUFFER_SIZE);
+  int previous = __atomic_exchange_n(&displayReady, displayBack | DISPLAY_FRESH, __ATOMIC_ACQ_REL);
+  if (previous & DISPLAY_FRESH)
+    displayDropped++;
+  displayBack = previous & ~DISPLAY_FRESH;
+  displayHanded++;
+  xTaskNotifyGive(displayTask);
+}
+
+// The panel lost its content (re-init, power save): the next frame sent repaints it all
+void displayInvalidate()
+{
+  __atomic_store_n(&displayResync, true, __ATOMIC_RELEASE);
+}
+
+// No frame waiting or being sent
+bool displayIdle()
+{
+  return !(__atomic_load_n(&displayReady, __ATOMIC_ACQUIRE) & DISPLAY_FRESH) &&
+         !__atomic_load_n(&displayFlushing, __ATOMIC_ACQUIRE);
+}
+
+void displayPrint()
+{
+  char s[80];
+  const OledTileStats &t = displayTiles.stats;
+
+  if (displayTask)
+  {
+    sprintf(s, "flush task: %u frames handed over, %u dropped for a newer one", (unsigned int)displayHanded,
+            (unsigned int)displayDropped);
+    Serial.println(s);
+  }
+  sprintf(s, "bus time per frame last %u us max %u us", (unsigned int)displaySendLastUs,
+          (unsigned int)displaySendMaxUs);
+  Serial.println(s);
+  if (!OLED_TILE_UPDATES)
+  {
+    sprintf(s, "tile updates off: %u full frames, %u bytes", (unsigned int)displayFullFrames,
+            (unsigned int)(displayFullFrames * OLED_BUFFER_SIZE));
+    Serial.println(s);
+    return;
+  }
+  sprintf(s, "frames %u (%u unchanged) areas %u tiles %u", (unsigned int)t.frames, (unsigned int)t.unchanged,
+          (unsigned int)t.areas, (unsigned int)t.tiles);
+  Serial.println(s);
+  sprintf(s, "bytes %u, per frame avg %u last %u peak %u (full frame %u)", (unsigned int)t.bytes,
+          (unsigned int)(t.frames ? t.bytes / t.frames : 0), (unsigned int)t.lastBytes,
+          (unsigned int)t.peakBytes, OLED_BUFFER_SIZE);
+  Serial.println(s);
+}
+
+void displayResetStats()
+{
+  displayTiles.resetStats();
+  displayHanded = 0;
+  displayDropped = 0;
+  displayFullFrames = 0;
+  displaySendMaxUs = 0;
+}
+
+// ---- Large readout
+//
+// The digits and signs of the large font are rasterized once at boot (glyph_cache.h) and
+// numbers are blitted from there; anything else still goes through drawStr().
+
+#include "glyph_cache.h"
+
+OledGlyphCache displayGlyphs;
+const uint8_t *displayLargeFont = NULL;
+
+// Call after u8g2.begin(), before anything is drawn: uses the frame buffer as scratch
+void displayGlyphsSetup(const uint8_t *font)
+{
+  char s[2] = {0, 0};
+
+  displayLargeFont = font;
+  if (!GLYPH_CACHE)
+    return;
+  u8g2.setFont(font);
+  for (const char *c = GLYPH_CACHE_CHARS; *c; c++)
+  {
+    s[0] = *c;
+    u8g2.clearBuffer();
+    int advance = u8g2.drawStr(0, 63, s); // delta x, getStrWidth() would drop the spacing
+    displayGlyphs.capture(*c, u8g2.getBufferPtr(), 63, advance);
+  }
+  u8g2.clearBuffer();
+}
+
+// Text in the large font at (x, baseline y)
+void displayDrawLarge(int x, int y, const char *s)
+{
+  if (GLYPH_CACHE && displayGlyphs.draw(u8g2.getBufferPtr(), x, y, s) >= 0)
+    return;
+  u8g2.setFont(displayLargeFont);
+  u8g2.drawStr(x, y, s);
+}
@@ -0,0 +1,156 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// glyph_cache.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Pre-rasterized glyphs of the large readout
+//
+// U8g2 fonts are run length coded and drawStr() decodes every glyph pixel run by pixel run
+// on every frame. The large readout only ever shows a few characters, so each of them is
+// drawn once at boot, the columns it covers are copied out of the frame buffer, and from
+// then on a number is drawn by OR-ing those bytes back in: one small copy per page the
+// glyph spans (5 for a 38 pixel font), no decoding.
+//
+// The frame buffer keeps pixels in vertical bytes (8 pages of 128 bytes, bit n of a byte is
+// row 8p + n), so a captured glyph can be put back at any x but only at baselines a whole
+// number of pages from the one it was captured at. draw() refuses anything else and the
+// caller falls back to drawStr().
+//
+// Portable, no Arduino or U8g2 dependency, so the host benchmark runs the same code.
+
+#ifndef __GLYPH_CACHE__
+#define __GLYPH_CACHE__
+
+#include <stdint.h>
+#include <string.h>
+
+#define GLYPH_CACHE_CHARS                "0123456789-.%"
+#define GLYPH_CACHE_BYTES                         2048  // 13 glyphs of a 38 pixel font take ~1.5 KB
+#define GLYPH_CACHE_WIDTH                          128  // frame buffer geometry, as in oled_tiles.h
+#define GLYPH_CACHE_PAGES                            8
+
+class OledGlyphCache
+{
+public:
+    OledGlyphCache() { clear(); }
+
+    void clear()
+    {
+        memset(index, 0xFF, sizeof(index));
+        count = 0;
+        used = 0;
+        baseline = -1;
+    }
+
+    // Takes the glyph of c out of a frame buffer where it was drawn alone, at x = 0 on the
+    // given baseline, into a cleared buffer. advance is its width in pixels including the
+    // spacing (what the font moves x by). All glyphs must share the same baseline.
+    bool capture(char c, const uint8_t *frame, int glyphBaseline, int advance)
+    {
+        uint8_t k = (uint8_t)c;
+        if (k >= 128 || count >= (int)sizeof(glyphs) / (int)sizeof(glyphs[0]) || advance <= 0 ||
+            advance > GLYPH_CACHE_WIDTH || (baseline >= 0 && glyphBaseline != baseline))
+            return false;
+
+        int first = GLYPH_CACHE_PAGES, last = -1;
+        for (int page = 0; page < GLYPH_CACHE_PAGES; page++)
+            for (int x = 0; x < advance; x++)
+                if (frame[page * GLYPH_CACHE_WIDTH + x])
+                {
+                    if (page < first)
+                        first = page;
+                    last = page;
+                    break;
+                }
+        int pages = last < 0 ? 0 : last - first + 1;
+        if (used + pages * advance > GLYPH_CACHE_BYTES)
+            return false;
+
+        Glyph &g = glyphs[count];
+        g.width = advance;
+        g.firstPage = pages ? first : 0;
+        g.pages = pages;
+        g.offset = used;
+        for (int p = 0; p < pages; p++)
+            memcpy(data + used + p * advance, frame + (first + p) * GLYPH_CACHE_WIDTH, advance);
+        used += pages * advance;
+        baseline = glyphBaseline;
+        index[k] = count++;
+        return true;
+    }
+
+    // ORs s into the frame buffer at x on the given baseline, clipped at the right edge.
+    // Returns the x after the text, or -1 without drawing anything when a character isn't
+    // cached or the baseline can't be reached in whole pages.
+    int draw(uint8_t *frame, int x, int textBaseline, const char *s) const
+    {
+        int shift = textBaseline - baseline;
+        if (baseline < 0 || x < 0 || (shift & 7))
+            return -1;
+        shift >>= 3;
+        for (const char *c = s; *c; c++)
+            if ((uint8_t)*c >= 128 || index[(uint8_t)*c] == 0xFF)
+                return -1;
+
+        for (; *s; s++)
+        {
+            const Glyph &g = glyphs[index[(uint8_t)*s]];
+            int width = x + g.width > GLYPH_CACHE_WIDTH ? GLYPH_CACHE_WIDTH - x : g.width;
+            for (int p = 0; p < g.pages && width > 0; p++)
+            {
+                int page = g.firstPage + p + shift;
+                if (page < 0 || page >= GLYPH_CACHE_PAGES)
+                    continue;
+                const uint8_t *from = data + g.offset + p * g.width;
+                uint8_t *to = frame + page * GLYPH_CACHE_WIDTH + x;
+                for (int i = 0; i < width; i++)
+                    to[i] |= from[i];
+            }
+            x += g.width;
+        }
+        return x;
+    }
+
+    int size() const { return count; }       // glyphs cached
+    int bytes() const { return used; }       // of GLYPH_CACHE_BYTES
+
+private:
+    struct Glyph
+    {
+        uint8_t width;
+        uint8_t firstPage;
+        uint8_t pages;
+        uint16_t offset;
+    };
+
+    Glyph glyphs[sizeof(GLYPH_CACHE_CHARS) - 1];
+    uint8_t index[128]; // glyphs[] slot per character, 0xFF when not cached
+    uint8_t data[GLYPH_CACHE_BYTES];
+    int count;
+    int used;
+    int baseline;
+};
+
+#endif
@@ -0,0 +1,165 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// latency.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Frame-to-photon latency of the shift light
+//
+// For every engine speed frame we keep three points in time (all micros()):
+//   rx      - stamped by the CAN driver when twai_receive() returned
+//   update  - v[CURRENT_ENGINE_SPEED] was written from the frame
+//   shown   - the strip.show() that first displays that value has returned
+// and split them into the stages below. A frame that is replaced by a newer one before
+// any show() is counted as superseded, not measured. One whose value leaves the strip's
+// picture as it is needs no show() (shiftlight.h) and is counted as unchanged.
+
+// Log-linear buckets: 1us wide below LATENCY_LINEAR_US, then LATENCY_SUB_BUCKETS per power
+// of two, so every stage is resolved to 1/8 of its size whether it takes 5us or 20ms
+#define LATENCY_LINEAR_US                           16
+#define LATENCY_SUB_BUCKETS                          8
+#define LATENCY_BUCKETS                            144  // up to 2^20us (~1s), the last bucket collects everything above
+
+#define LATENCY_STAGE_QUEUE                          0  // rx -> update (RX task, buffering, loop())
+#define LATENCY_STAGE_WAIT                           1  // update -> start of strip.show()
+#define LATENCY_STAGE_SHOW                           2  // strip.show() itself (WS2812 refresh)
+#define LATENCY_STAGE_TOTAL                          3  // rx -> show() done
+#define LATENCY_STAGES                               4
+
+struct LatencyHistogram
+{
+    uint32_t bucket[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+};
+
+LatencyHistogram latencyStage[LATENCY_STAGES];
+const char *latencyStageName[LATENCY_STAGES] = {"rx->update", "update->show", "show()", "rx->shown"};
+uint32_t latencySuperseded = 0;
+uint32_t latencyUnchanged = 0;
+
+bool latencyPending = false;
+uint32_t latencyPendingRx = 0;
+uint32_t latencyPendingUpdate = 0;
+
+uint32_t latencyBucket(uint32_t us)
+{
+    if (us < LATENCY_LINEAR_US)
+        return us;
+    int e = 31 - __builtin_clz(us); // us is in [2^e, 2^(e+1))
+    uint32_t b = LATENCY_LINEAR_US + (e - 4) * LATENCY_SUB_BUCKETS + ((us >> (e - 3)) & (LATENCY_SUB_BUCKETS - 1));
+    return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+// Largest value bucket b holds
+uint32_t latencyBucketTop(uint32_t b)
+{
+    if (b < LATENCY_LINEAR_US)
+        return b;
+    uint32_t k = b - LATENCY_LINEAR_US;
+    int shift = k / LATENCY_SUB_BUCKETS + 1;
+    return ((LATENCY_SUB_BUCKETS + k % LATENCY_SUB_BUCKETS + 1) << shift) - 1;
+}
+
+void latencyRecord(LatencyHistogram &h, uint32_t us)
+{
+    uint32_t b = latencyBucket(us);
+    h.bucket[b]++;
+    h.count++;
+    if (us > h.max)
+        h.max = us;
+}
+
+// Top of the bucket holding the pct-th percentile (at most 1/8 above the true value), never
+// more than the largest sample
+uint32_t latencyPercentile(const LatencyHistogram &h, int pct)
+{
+    if (h.count == 0)
+        return 0;
+    uint32_t target = (uint32_t)(((uint64_t)h.count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += h.bucket[b];
+        if (seen >= target)
+            return b == LATENCY_BUCKETS - 1 || latencyBucketTop(b) > h.max ? h.max : latencyBucketTop(b);
+    }
+    return h.max;
+}
+
+void latencyReset()
+{
+    memset(latencyStage, 0, sizeof(latencyStage));
+    latencySuperseded = 0;
+    latencyUnchanged = 0;
+    latencyPending = false;
+}
+
+// Call right after v[CURRENT_ENGINE_SPEED] is updated from a frame
+void latencyEngineSpeedUpdated(uint32_t rxTimestamp)
+{
+    if (latencyPending)
+        latencySuperseded++;
+    latencyPendingRx = rxTimestamp;
+    latencyPendingUpdate = micros();
+    latencyPending = true;
+}
+
+// Call around the strip.show() of the regular RPM display
+void latencyStripShown(uint32_t showStart, uint32_t showEnd)
+{
+    if (!latencyPending)
+        return;
+    latencyRecord(latencyStage[LATENCY_STAGE_QUEUE], latencyPendingUpdate - latencyPendingRx);
+    latencyRecord(latencyStage[LATENCY_STAGE_WAIT], showStart - latencyPendingUpdate);
+    latencyRecord(latencyStage[LATENCY_STAGE_SHOW], showEnd - showStart);
+    latencyRecord(latencyStage[LATENCY_STAGE_TOTAL], showEnd - latencyPendingRx);
+    latencyPending = false;
+}
+
+// Call when the strip already shows the latest value, so no show() follows
+void latencyStripUnchanged()
+{
+    if (!latencyPending)
+        return;
+    latencyUnchanged++;
+    latencyPending = false;
+}
+
+void latencyPrint()
+{
+    char s[80];
+    Serial.println("stage            count    p50us    p99us    maxus");
+    for (int i = 0; i < LATENCY_STAGES; i++)
+    {
+        const LatencyHistogram &h = latencyStage[i];
+        sprintf(s, "%-14s %7u %8u %8u %8u", latencyStageName[i], (unsigned int)h.count,
+                (unsigned int)latencyPercentile(h, 50), (unsigned int)latencyPercentile(h, 99), (unsigned int)h.max);
+        Serial.println(s);
+    }
+    sprintf(s, "superseded before show: %u", (unsigned int)latencySuperseded);
+    Serial.println(s);
+    sprintf(s, "picture unchanged, no show: %u", (unsigned int)latencyUnchanged);
+    Serial.println(s);
+}
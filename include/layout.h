@@ -0,0 +1,92 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// layout.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Home screen layouts
+//
+// The home screen is a grid of cells, each a bounding box on the 128x64 panel bound to a
+// value slot and drawn by a widget. Boxes are aligned to the 8 pixel pages, so a cell can be
+// cleared and redrawn on its own without touching its neighbours' tiles: when one value
+// changes only its cell is redrawn and only its tiles go out (display.h).
+//
+// The layout is picked from the DISPLAY menu (v[CURRENT_LAYOUT]). Cells bound to
+// LAYOUT_SLOT_SELECTED show the value chosen there as well (ENG.RPM, SPEED.MPH).
+
+#define LAYOUT_SINGLE                                0  // the value chosen in DISPLAY, large
+#define LAYOUT_DUAL                                  1  // two values one above the other
+#define LAYOUT_QUAD                                  2  // 2x2 values
+#define LAYOUT_BAR                                   3  // engine speed bar over the large number
+#define LAYOUT_COUNT                                 4
+
+#define LAYOUT_MAX_CELLS                             4
+#define LAYOUT_SLOT_SELECTED                        -1  // v[CURRENT_DISPLAY]
+
+#define WIDGET_LARGE                               400  // header label and large number, full screen
+#define WIDGET_NUMBER                              401  // small label over a medium number
+#define WIDGET_LARGE_NUMBER                        402  // large number only
+#define WIDGET_BAR                                 403  // horizontal bar from VALUE_MINRPM to PARAM_MAXRPM
+
+struct LayoutCell
+{
+    uint8_t x, y, w, h; // bounding box in pixels, y and h multiples of 8
+    int slot;
+    int widget;
+};
+
+struct Layout
+{
+    int cellCount;
+    LayoutCell cells[LAYOUT_MAX_CELLS];
+};
+
+const Layout layouts[LAYOUT_COUNT] = {
+    // LAYOUT_SINGLE
+    {1, {{0, 0, 128, 64, LAYOUT_SLOT_SELECTED, WIDGET_LARGE}}},
+    // LAYOUT_DUAL
+    {2, {{0, 0, 128, 32, CURRENT_ENGINE_SPEED, WIDGET_NUMBER},
+         {0, 32, 128, 32, CURRENT_VEHICLE_SPEED, WIDGET_NUMBER}}},
+    // LAYOUT_QUAD
+    {4, {{0, 0, 64, 32, CURRENT_ENGINE_SPEED, WIDGET_NUMBER},
+         {64, 0, 64, 32, CURRENT_VEHICLE_SPEED, WIDGET_NUMBER},
+         {0, 32, 64, 32, CURRENT_LIGHTLEVEL, WIDGET_NUMBER},
+         {64, 32, 64, 32, PARAM_MAXRPM, WIDGET_NUMBER}}},
+    // LAYOUT_BAR
+    {2, {{0, 0, 128, 24, CURRENT_ENGINE_SPEED, WIDGET_BAR},
+         {0, 24, 128, 40, CURRENT_ENGINE_SPEED, WIDGET_LARGE_NUMBER}}},
+};
+
+// The layout in use, falling back to LAYOUT_SINGLE for a bad stored value
+const Layout &layoutCurrent()
+{
+    int n = v[CURRENT_LAYOUT];
+    return layouts[n >= 0 && n < LAYOUT_COUNT ? n : LAYOUT_SINGLE];
+}
+
+// Value slot a cell shows
+int layoutSlot(const LayoutCell &cell)
+{
+    return cell.slot == LAYOUT_SLOT_SELECTED ? v[CURRENT_DISPLAY] : cell.slot;
+}
@@ -33,6 +33,9 @@
 #include "sensor.h"  // Sensor-specific data
 #include "strings.h" // Localized strings
 #include "menu.h"    // Menu library
+#include "layout.h"  // Home screen layouts
+#include "latency.h" // Frame-to-photon latency instrumentation
+#include "signals.h" // CAN signal definitions
 
 /*--------------------------- Libraries ----------------------------------*/
 #include <Wire.h>
@@ -43,6 +46,9 @@
 
 #include <esp32_can.h> // CAN library - collin80/can_common@^0.4.0
 
+#include "recorder.h" // Post-mortem CAN bus recorder
+#include "profiler.h" // Per-ID bus profile
+
 /*--------------------------- Global Variables ---------------------------*/
 // General
 uint32_t DEVICE_ID; // Unique ID from ESP chip ID
@@ -63,8 +69,12 @@ bool SCREEN_ACTIVE = false;
 /*--------------------------- Function Signatures ---------------------------*/
 void sensorUpdateReadings();
 void sensorUpdateReadingsQuick();
+void sensorHandleFrame(CAN_FRAME &can_message);
 void sensorUpdateDisplay();
+void sensorDeclareScreen();
 void sensorSetup();
+void sensorPrintCANStats();
+void sensorSerialCommand(char command);
 
 /*--------------------------- Instantiate Global Objects --------------------*/
 U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0,
@@ -75,6 +85,10 @@ U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0,
 Adafruit_NeoPixel strip = Adafruit_NeoPixel(60, WS2812_PIN,
                                             NEO_GRB + NEO_KHZ800);      // WS2812
 
+#include "display.h" // Changed-tile OLED updates, uses u8g2 above
+#include "refresh.h" // Value-driven display refresh scheduler
+#include "shiftlight.h" // Precomputed shift light frames, uses strip above
+
 /*--------------------------- Utility functions  ----------------------------*/
 
 void log_out(char *component, const char *value)
@@ -275,6 +289,8 @@ void theaterChaseRainbow(uint8_t wait)
 /*--------------------------- Program ---------------------------------------*/
 void setup()
 {
+  Serial.begin(SERIAL_BAUD_RATE);
+
   uint32_t chipId = 0;
   for (int i = 0; i < 17; i = i + 8)
   {
@@ -295,6 +311,7 @@ void setup()
 
   valuesSetup();
   menuSetup();
+  refreshSetup();
   sensorSetup();
 }
 
@@ -322,18 +339,24 @@ void loop()
     delay(10);
     if (digitalRead(KY040_PIN_SW) == 0)
     {
-      KY040_STATUS_CURRENT = KY040_STATUS_PRESSED;
+      unsigned long pressStart = millis();
       while (digitalRead(KY040_PIN_SW) == 0)
         ;
+      if (BUS_RECORDER && RECORDER_ON_LONG_PRESS && millis() - pressStart >= RECORDER_LONG_PRESS_MS)
+        recorderTrigger(RECORDER_TRIGGER_BUTTON);
+      else
+        KY040_STATUS_CURRENT = KY040_STATUS_PRESSED;
     }
   }
 
+  if (Serial.available())
+    sensorSerialCommand(Serial.read()); // diagnostics requested over the serial console
+
   sensorUpdateReadingsQuick(); // get the data from sensors at max speed
 
   if (millis() - previousUpdateTime >= DELAY_MS)
   {
     sensorUpdateReadings();                    // get the data from sensors
-    sensorUpdateDisplay();                     // update the local display, if present
     previousUpdateTime = millis();
   }
 
@@ -349,4 +372,11 @@ void loop()
     screenTimeoutTimer = millis();
   }
 
+  sensorDeclareScreen();
+  if (refreshDue(millis()))                    // only when what the screen shows changed
+  {
+    sensorUpdateDisplay();                     // update the local display, if present
+    refreshDone(millis());
+  }
+
 }
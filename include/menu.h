@@ -29,6 +29,7 @@
 #define MENU_TYPE_MENU                             200
 #define MENU_TYPE_INT                              201
 #define MENU_TYPE_SELECT                           202
+#define MENU_TYPE_LIST                             203  // read-only rows, the knob scrolls intValueCurrent
 
 #define MENU_VALUE_SETFROMVALUE                    300
 #define MENU_VALUE_ACTION                          301
@@ -62,31 +63,7 @@ bool inMenu = true;
 
 // /* --- to be moved in main.h
 
-// --- Menu configuration
-const int MENU_VALUE_MAXRPM = 101;
-const int MENU_VALUE_BRIGHTNESS_DAY = 102;
-const int MENU_VALUE_BRIGHTNESS_NIGHT = 103;
-const int MENU_VALUE_BRIGHTNESS_AUTODIM = 104;
-const int MENU_VALUE_SHOW_INFO = 106;
-const int MENU_VALUE_SHOW_HOME = 107;
-const int MENU_VALUE_DISPLAY = 108;
-const int MENU_VALUE_DISPLAY_ENGINESPEEED = 109;
-const int MENU_VALUE_DISPLAY_VEHICLESPEED = 110;
-
-// --- Dynamic values (derived from CAN readings or other sensors)
-const int CURRENT_ENGINE_SPEED = 0;                      /* From CAN Bus */
-const int CURRENT_VEHICLE_SPEED = 1;                     /* From CAN Bus */
-const int CURRENT_LIGHTLEVEL = 9;                        /* Light level from photoresistor */
-
-// --- Parameter values (to be persisted across power cycles)
-const int PARAM_MAXRPM = 2;
-const int PARAM_BRIGHTNESSDAY = 3;
-const int PARAM_BRIGHTNESSNIGHT = 4;
-const int CURRENT_DISPLAY = 5;
-const int CURRENT_BRIGHTNESS = 6; /* PARAM_BRIGHTNESSDAY or PARAM_BRIGHTNESSNIGHT */
-const int VALUE_MINRPM = 7;                              /* typically 0 */
-const int VALUE_SHOW = 8;                                /* ? */
-const int PARAM_BRIGHTNESSTHRESHOLD = 10;
+#include "values.h" // value slots and menu pages, shared with the host tools
 
 void valuesSetup()
 {
@@ -102,6 +79,7 @@ void valuesSetup()
     strcpy(l[VALUE_SHOW], "SHOW");
     strcpy(l[CURRENT_LIGHTLEVEL], "LIGHT LEVEL");
     strcpy(l[PARAM_BRIGHTNESSTHRESHOLD], "LIGHT THR.");
+    strcpy(l[CURRENT_LAYOUT], "LAYOUT");
 
     // setup values
     v[CURRENT_ENGINE_SPEED] = 0;
@@ -115,6 +93,7 @@ void valuesSetup()
     v[VALUE_SHOW] = getValueFromEEPROM(VALUE_SHOW, MENU_VALUE_SHOW_INFO);
     v[CURRENT_LIGHTLEVEL] = 0;
     v[PARAM_BRIGHTNESSTHRESHOLD] = getValueFromEEPROM(PARAM_BRIGHTNESSTHRESHOLD, 2000);
+    v[CURRENT_LAYOUT] = getValueFromEEPROM(CURRENT_LAYOUT, 0);
 
     for (int i = 0; i < 15; i++)
     {
@@ -129,21 +108,22 @@ void valuesSetup()
 void menuSetup()
 {
     // setup menus
-    strcpy(mi[0].label, "SETTINGS");
-    mi[0].type = MENU_TYPE_MENU;
-    mi[0].menuItemsCount = 4;
-    mi[0].m[0] = 1;
-    mi[0].m[1] = 2;
-    mi[0].m[2] = 9;
-    mi[0].m[3] = 8;
-
-    strcpy(mi[1].label, "MAX RPM");
-    mi[1].type = MENU_TYPE_INT;
-    mi[1].intValueMin = 0;
-    mi[1].intValueMax = 20000;
-    mi[1].intValueDelta = 500;
-    mi[1].intValueCurrent = v[PARAM_MAXRPM];
-    mi[1].setValueID = PARAM_MAXRPM;
+    strcpy(mi[MENU_ITEM_SETTINGS].label, "SETTINGS");
+    mi[MENU_ITEM_SETTINGS].type = MENU_TYPE_MENU;
+    mi[MENU_ITEM_SETTINGS].menuItemsCount = 5;
+    mi[MENU_ITEM_SETTINGS].m[0] = MENU_ITEM_MAXRPM;
+    mi[MENU_ITEM_SETTINGS].m[1] = 2;
+    mi[MENU_ITEM_SETTINGS].m[2] = 9;
+    mi[MENU_ITEM_SETTINGS].m[3] = MENU_ITEM_BUS_PROFILE;
+    mi[MENU_ITEM_SETTINGS].m[4] = 8;
+
+    strcpy(mi[MENU_ITEM_MAXRPM].label, "MAX RPM");
+    mi[MENU_ITEM_MAXRPM].type = MENU_TYPE_INT;
+    mi[MENU_ITEM_MAXRPM].intValueMin = 0;
+    mi[MENU_ITEM_MAXRPM].intValueMax = 20000;
+    mi[MENU_ITEM_MAXRPM].intValueDelta = 500;
+    mi[MENU_ITEM_MAXRPM].intValueCurrent = v[PARAM_MAXRPM];
+    mi[MENU_ITEM_MAXRPM].setValueID = PARAM_MAXRPM;
 
     strcpy(mi[2].label, "BRIGHTNESS");
     mi[2].type = MENU_TYPE_MENU;
@@ -191,10 +171,14 @@ void menuSetup()
 
     strcpy(mi[9].label, "DISPLAY");
     mi[9].type = MENU_TYPE_MENU;
-    mi[9].menuItemsCount = 3;
+    mi[9].menuItemsCount = 7;
     mi[9].m[0] = 10;
     mi[9].m[1] = 11;
-    mi[9].m[2] = 0;
+    mi[9].m[2] = 13;
+    mi[9].m[3] = 14;
+    mi[9].m[4] = 15;
+    mi[9].m[5] = 16;
+    mi[9].m[6] = 0;
 
     strcpy(mi[10].label, "ENG.RPM");
     mi[10].type = MENU_TYPE_SELECT;
@@ -206,7 +190,33 @@ void menuSetup()
     mi[11].setValueID = CURRENT_DISPLAY;
     mi[11].intValueCurrent = CURRENT_VEHICLE_SPEED;
 
-    currentMenu = 0;
+    strcpy(mi[13].label, "1 VALUE");
+    mi[13].type = MENU_TYPE_SELECT;
+    mi[13].setValueID = CURRENT_LAYOUT;
+    mi[13].intValueCurrent = 0; // LAYOUT_SINGLE
+
+    strcpy(mi[14].label, "2 VALUES");
+    mi[14].type = MENU_TYPE_SELECT;
+    mi[14].setValueID = CURRENT_LAYOUT;
+    mi[14].intValueCurrent = 1; // LAYOUT_DUAL
+
+    strcpy(mi[15].label, "4 VALUES");
+    mi[15].type = MENU_TYPE_SELECT;
+    mi[15].setValueID = CURRENT_LAYOUT;
+    mi[15].intValueCurrent = 2; // LAYOUT_QUAD
+
+    strcpy(mi[16].label, "BAR+RPM");
+    mi[16].type = MENU_TYPE_SELECT;
+    mi[16].setValueID = CURRENT_LAYOUT;
+    mi[16].intValueCurrent = 3; // LAYOUT_BAR
+
+    strcpy(mi[MENU_ITEM_BUS_PROFILE].label, "BUS PROFILE");
+    mi[MENU_ITEM_BUS_PROFILE].type = MENU_TYPE_LIST;
+    mi[MENU_ITEM_BUS_PROFILE].intValueMin = 0;
+    mi[MENU_ITEM_BUS_PROFILE].intValueMax = 0; // last row, follows the number of IDs seen
+    mi[MENU_ITEM_BUS_PROFILE].intValueCurrent = 0;
+
+    currentMenu = MENU_ITEM_SETTINGS;
 }
 
 // --- */
\ No newline at end of file
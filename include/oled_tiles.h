@@ -0,0 +1,132 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// oled_tiles.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Tile level dirty tracking of the SSD1306 frame buffer
+//
+// U8g2's full frame buffer is the display's own memory layout: 8 pages of 128 bytes, each
+// byte a column of 8 pixels, so a tile (8x8 pixels) is 8 consecutive bytes and page p holds
+// tile row p. OledTileTracker keeps a copy of what was last transmitted, compares the new
+// frame tile by tile and hands every run of changed tiles in a tile row to the caller (for
+// u8g2.updateDisplayArea()), instead of pushing all 1024 bytes on every redraw.
+//
+// Runs are sent as they are, not merged across unchanged tiles: each area costs a handful of
+// command bytes to set the column and page, less than the 8 bytes of a tile in between.
+//
+// Portable, no Arduino or U8g2 dependency, so the host benchmark runs the same code.
+
+#ifndef __OLED_TILES__
+#define __OLED_TILES__
+
+#include <stdint.h>
+#include <string.h>
+
+#define OLED_TILE_COLS                              16  // 128 pixels
+#define OLED_TILE_ROWS                               8  // 64 pixels
+#define OLED_TILE_BYTES                              8
+#define OLED_BUFFER_SIZE  (OLED_TILE_COLS * OLED_TILE_ROWS * OLED_TILE_BYTES)
+
+struct OledTileStats
+{
+    uint32_t frames;    // flush() calls
+    uint32_t unchanged; // of which had nothing to send
+    uint32_t areas;     // updateDisplayArea() calls
+    uint32_t tiles;
+    uint32_t bytes;     // frame buffer bytes transmitted (8 per tile)
+    uint32_t lastBytes; // of the latest flush()
+    uint32_t peakBytes;
+};
+
+class OledTileTracker
+{
+public:
+    OledTileTracker() : valid(false) { memset(&stats, 0, sizeof(stats)); }
+
+    // The display content is unknown (power up, re-init): the next flush() sends everything
+    void invalidate() { valid = false; }
+
+    // Calls area(tx, ty, tw) for every run of tiles of frame that differ from what was sent
+    // before, in tile units and one tile row high, and remembers frame as sent. Returns the
+    // number of frame buffer bytes those areas carry.
+    template <typename AreaFn>
+    uint32_t flush(const uint8_t *frame, AreaFn area)
+    {
+        uint32_t bytes = 0;
+
+        for (int ty = 0; ty < OLED_TILE_ROWS; ty++)
+        {
+            const uint8_t *row = frame + ty * OLED_TILE_COLS * OLED_TILE_BYTES;
+            uint8_t *sentRow = sent + ty * OLED_TILE_COLS * OLED_TILE_BYTES;
+            int start = -1;
+
+            for (int tx = 0; tx <= OLED_TILE_COLS; tx++)
+            {
+                bool dirty = tx < OLED_TILE_COLS &&
+                             (!valid || !tileEqual(row + tx * OLED_TILE_BYTES, sentRow + tx * OLED_TILE_BYTES));
+                if (dirty && start < 0)
+                    start = tx;
+                else if (!dirty && start >= 0)
+                {
+                    int tw = tx - start;
+                    area(start, ty, tw);
+                    memcpy(sentRow + start * OLED_TILE_BYTES, row + start * OLED_TILE_BYTES, tw * OLED_TILE_BYTES);
+                    stats.areas++;
+                    stats.tiles += tw;
+                    bytes += tw * OLED_TILE_BYTES;
+                    start = -1;
+                }
+            }
+        }
+        valid = true;
+
+        stats.frames++;
+        if (bytes == 0)
+            stats.unchanged++;
+        stats.bytes += bytes;
+        stats.lastBytes = bytes;
+        if (bytes > stats.peakBytes)
+            stats.peakBytes = bytes;
+        return bytes;
+    }
+
+    void resetStats() { memset(&stats, 0, sizeof(stats)); }
+
+    OledTileStats stats;
+
+private:
+    static bool tileEqual(const uint8_t *a, const uint8_t *b)
+    {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        return x == y;
+    }
+
+    uint8_t sent[OLED_BUFFER_SIZE];
+    bool valid;
+};
+
+#endif
@@ -0,0 +1,153 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// profiler.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Per-ID bus profile
+//
+// The CAN driver keeps live statistics for every ID it reads off the controller (frame
+// count, average period and its jitter, last DLC, how often the payload changes) in a
+// fixed table updated by its RX task (can_id_profiler.h). Here they are copied out, sorted
+// by ID, for the BUS PROFILE menu page and for 'p' on serial; 'P' clears them.
+//
+// Profiling has to see the whole bus, so while it runs the TWAI hardware filter is off and
+// every frame wakes the driver's RX task, which is what the filter is there to avoid. So it
+// only runs while the BUS PROFILE page is open or 'b' on serial turned it on, and each switch
+// costs one driver reinstall. The table keeps what it collected in between.
+
+#define PROFILER_MAX_IDS                  CIP_NUM_SLOTS
+#define PROFILER_PAGE_ROWS                           3  // rows of the menu page, the 4th line details the selected one
+
+CAN_ID_PROFILE profilerRows[PROFILER_MAX_IDS];
+int profilerCount = 0;
+uint32_t profilerUntracked = 0;
+
+bool profilerPageOpen = false; // BUS PROFILE on screen
+bool profilerSerialOn = false; // 'b' on serial
+bool profilerActive = false;
+
+void profilerApply()
+{
+  bool active = CAN_ID_PROFILER && (profilerPageOpen || profilerSerialOn);
+  if (active == profilerActive)
+    return;
+  profilerActive = active;
+  CAN0.setIdProfiling(active);
+  CAN0.setHardwareFiltering(!active && !recorderNeedsWholeBus());
+  CAN0.commitFilters();
+}
+
+// Call when the screen changes
+void profilerPageShown(bool open)
+{
+  profilerPageOpen = open;
+  profilerApply();
+}
+
+// 'b' on serial: profile without the page open
+void profilerToggle()
+{
+  profilerSerialOn = !profilerSerialOn;
+  profilerApply();
+  Serial.println(profilerActive ? "Bus profile on, hardware filter off" : "Bus profile off");
+}
+
+// Fresh copy of the driver's table, standard IDs first, then extended, each by ascending ID
+void profilerRefresh()
+{
+  profilerCount = CAN0.getIdProfile(profilerRows, PROFILER_MAX_IDS, &profilerUntracked);
+
+  for (int i = 1; i < profilerCount; i++) // insertion sort, the table is small and mostly in order
+  {
+    CAN_ID_PROFILE row = profilerRows[i];
+    uint64_t key = ((uint64_t)row.extended << 32) | row.id;
+    int j = i - 1;
+    while (j >= 0 && (((uint64_t)profilerRows[j].extended << 32) | profilerRows[j].id) > key)
+    {
+      profilerRows[j + 1] = profilerRows[j];
+      j--;
+    }
+    profilerRows[j + 1] = row;
+  }
+}
+
+// Share of frames whose payload differed from the previous one of the same ID
+int profilerChangePercent(const CAN_ID_PROFILE &row)
+{
+  if (row.frames < 2)
+    return 0;
+  return (int)((uint64_t)row.changes * 100 / (row.frames - 1));
+}
+
+void profilerFormatId(const CAN_ID_PROFILE &row, char *s)
+{
+  sprintf(s, row.extended ? "%08X" : "%03X", (unsigned int)row.id);
+}
+
+// One line of the menu page, 21 characters at most: ID, period in ms, payload change rate
+void profilerFormatRow(const CAN_ID_PROFILE &row, char *s)
+{
+  char id[12];
+
+  profilerFormatId(row, id);
+  sprintf(s, "%-8s%6u.%u %3d%%", id, (unsigned int)(row.periodUs / 1000),
+          (unsigned int)(row.periodUs % 1000 / 100), profilerChangePercent(row));
+}
+
+// Last line of the menu page: frame count, jitter and DLC of the selected row
+void profilerFormatDetail(const CAN_ID_PROFILE &row, char *s)
+{
+  sprintf(s, "n%u j%u.%ums dlc%u", (unsigned int)row.frames, (unsigned int)(row.jitterUs / 1000),
+          (unsigned int)(row.jitterUs % 1000 / 100), row.length);
+}
+
+void profilerPrint()
+{
+  char s[96];
+  char id[12];
+  uint32_t now = micros();
+
+  profilerRefresh();
+  if (!profilerActive)
+    Serial.println("Profiling off, 'b' or the BUS PROFILE page turns it on");
+  sprintf(s, "%d IDs, %u frames untracked (table full)", profilerCount, (unsigned int)profilerUntracked);
+  Serial.println(s);
+  Serial.println("id        dlc     frames  period_us  jitter_us  change%  age_ms");
+  for (int i = 0; i < profilerCount; i++)
+  {
+    const CAN_ID_PROFILE &row = profilerRows[i];
+    profilerFormatId(row, id);
+    sprintf(s, "%-8s  %3u %10u %10u %10u  %7d %7u", id, row.length, (unsigned int)row.frames,
+            (unsigned int)row.periodUs, (unsigned int)row.jitterUs, profilerChangePercent(row),
+            (unsigned int)((now - row.lastSeen) / 1000));
+    Serial.println(s);
+  }
+}
+
+void profilerReset()
+{
+  CAN0.resetIdProfile();
+  profilerCount = 0;
+}
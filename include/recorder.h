@@ -0,0 +1,399 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// recorder.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Post-mortem CAN bus recorder
+//
+// Every frame the CAN driver receives is copied into a ring of raw frames by its RX task (a raw
+// tap ahead of the software filters), so the last RECORDER_PRE_MS of traffic are always at
+// hand (as far back as 3/4 of the ring reaches, the rest is for the post-trigger window).
+// A trigger (shift RPM reached, bus errors, long press of the knob, 'R' on serial) marks the
+// moment; recording goes on for RECORDER_POST_MS, then the window around the trigger is
+// frozen and a background task writes it to LittleFS in the binary capture format
+// (can_capture.h) as /rec<NNNN>-<trigger>-<trigger micros()>.cap. Frames arriving while the
+// task writes are not recorded (counted as skipped); the recorder re-arms when the file is
+// closed.
+//
+// What the driver receives depends on the TWAI hardware filter. It is derived from the watched
+// IDs and keeps the rest of the bus away from the RX task, so by default the recorder sees the
+// watched IDs (and whatever else shares their filter bits), and the whole bus only while the
+// profiler runs. RECORDER_WHOLE_BUS records everything instead, at the price of that filter:
+// it stays off for good.
+//
+// 'r' on serial prints the recorder state and the saved captures, 'd' prints the captures as
+// hex for tools/recdump, which turns them back into CSV.
+
+#include <LittleFS.h>
+#include "can_capture.h"
+
+#define RECORDER_RING_FRAMES                      2048  // power of two, ~48 KB of internal RAM
+#define RECORDER_RING_FRAMES_PSRAM               65536  // power of two, ~1.5 MB on boards with PSRAM
+#define RECORDER_PRE_MS                          10000  // kept before the trigger
+#define RECORDER_POST_MS                          5000  // recorded after the trigger
+#define RECORDER_LONG_PRESS_MS                    1500  // knob held this long triggers instead of selecting
+#define RECORDER_MAX_FILES                           8  // the oldest capture is deleted beyond this
+#define RECORDER_CHUNK                            1024  // bytes per LittleFS write
+#define RECORDER_POLL_MS                            50  // how often the save task looks for work
+#define RECORDER_TASK_STACK                       4096
+#define RECORDER_TASK_PRIORITY                       1
+#define RECORDER_TASK_CORE                           0  // loop() runs on core 1
+#define RECORDER_DUMP_LINE                          32  // bytes per hex line of 'd'
+
+#define RECORDER_TRIGGER_MANUAL                      0
+#define RECORDER_TRIGGER_SHIFT                       1
+#define RECORDER_TRIGGER_BUSERROR                    2
+#define RECORDER_TRIGGER_BUTTON                      3
+#define RECORDER_TRIGGERS                            4
+
+#define RECORDER_OFF                                 0  // no ring or no file system
+#define RECORDER_ARMED                               1  // recording, waiting for a trigger
+#define RECORDER_POST                                2  // triggered, recording the post-trigger window
+#define RECORDER_SAVING                              3  // window frozen, the save task owns the ring
+#define RECORDER_CLOSING                             4  // window being frozen, frames are skipped
+
+const char *recorderTriggerName[RECORDER_TRIGGERS] = {"manual", "shift", "buserror", "button"};
+const char *recorderStateName[5] = {"off", "armed", "post-trigger", "saving", "closing"};
+
+CAN_FRAME *recorderRing = NULL;
+uint32_t recorderMask = 0;        // ring size - 1
+uint32_t recorderHead = 0;        // frames recorded since boot, the ring index is head & mask
+uint32_t recorderFilled = 0;      // frames in the ring. Both written only by the RX task
+int recorderState = RECORDER_OFF; // handed between the RX task, loop() and the save task with acquire/release
+
+int recorderReason = 0;
+uint32_t recorderTriggerTime = 0; // micros()
+uint32_t recorderWindowStart = 0; // head values delimiting the frozen window
+uint32_t recorderWindowEnd = 0;
+
+uint32_t recorderTriggerCount[RECORDER_TRIGGERS];
+uint32_t recorderIgnored = 0;     // triggers while a window was still open or being saved
+uint32_t recorderSkipped = 0;     // frames not recorded while saving, RX task only
+uint32_t recorderSaved = 0;
+uint32_t recorderFailed = 0;
+int recorderNextNumber = 0;
+bool recorderShiftActive = false;
+uint32_t recorderLastBusErrors = 0;
+
+CANCaptureWriter recorderWriter;  // 3.6 KB, kept off the save task's stack
+uint8_t recorderChunk[RECORDER_CHUNK + CAN_CAPTURE_MAX_RECORD];
+
+// The TWAI hardware filter must stay off
+inline bool recorderNeedsWholeBus()
+{
+    return BUS_RECORDER && RECORDER_WHOLE_BUS;
+}
+
+inline int recorderGetState()
+{
+    return __atomic_load_n(&recorderState, __ATOMIC_ACQUIRE);
+}
+
+inline void recorderSetState(int state)
+{
+    __atomic_store_n(&recorderState, state, __ATOMIC_RELEASE);
+}
+
+// Capture number of a LittleFS file name, -1 if it isn't one of ours
+int recorderFileNumber(const char *name)
+{
+    const char *slash = strrchr(name, '/'); // name() is the full path on older cores
+    if (slash)
+        name = slash + 1;
+    if (strncmp(name, "rec", 3) || name[3] < '0' || name[3] > '9')
+        return -1;
+    return atoi(name + 3);
+}
+
+// Deletes the oldest captures so that one more fits under RECORDER_MAX_FILES
+void recorderPrune()
+{
+    for (;;)
+    {
+        int count = 0, oldest = -1;
+        char oldestPath[48];
+
+        File root = LittleFS.open("/");
+        for (File file = root.openNextFile(); file; file = root.openNextFile())
+        {
+            int n = recorderFileNumber(file.name());
+            if (n < 0)
+                continue;
+            count++;
+            if (oldest < 0 || n < oldest)
+            {
+                oldest = n;
+                const char *name = strrchr(file.name(), '/');
+                snprintf(oldestPath, sizeof(oldestPath), "/%s", name ? name + 1 : file.name());
+            }
+        }
+        if (count < RECORDER_MAX_FILES)
+            return;
+        LittleFS.remove(oldestPath);
+    }
+}
+
+// Encodes the frozen window into a new file. Runs in the save task.
+bool recorderSave()
+{
+    char path[48];
+    snprintf(path, sizeof(path), "/rec%04d-%s-%u.cap", recorderNextNumber++, recorderTriggerName[recorderReason],
+             (unsigned int)recorderTriggerTime);
+
+    recorderPrune();
+    File file = LittleFS.open(path, "w");
+    if (!file)
+        return false;
+
+    bool ok = true;
+    size_t used = canCaptureHeader(recorderChunk);
+    used += recorderWriter.reset(recorderChunk + used); // fresh dictionary and time base for every file
+    for (uint32_t i = recorderWindowStart; i != recorderWindowEnd && ok; i++)
+    {
+        used += recorderWriter.encode(recorderRing[i & recorderMask], recorderChunk + used);
+        if (used >= RECORDER_CHUNK)
+        {
+            ok = file.write(recorderChunk, used) == used;
+            used = 0;
+        }
+    }
+    if (ok && used)
+        ok = file.write(recorderChunk, used) == used;
+    file.close();
+    if (!ok)
+        LittleFS.remove(path);
+    return ok;
+}
+
+void recorderTask(void *)
+{
+    for (;;)
+    {
+        if (recorderGetState() == RECORDER_SAVING)
+        {
+            if (recorderSave())
+                recorderSaved++;
+            else
+                recorderFailed++;
+            recorderSetState(RECORDER_ARMED);
+        }
+        vTaskDelay(pdMS_TO_TICKS(RECORDER_POLL_MS));
+    }
+}
+
+// Freezes the window and hands it to the save task. Both loop() (time is up) and the RX task
+// (ring full) may get here at once: only the one that leaves RECORDER_POST does the work.
+void recorderFreeze()
+{
+    int expected = RECORDER_POST;
+    if (!__atomic_compare_exchange_n(&recorderState, &expected, RECORDER_CLOSING, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE))
+        return;
+    recorderWindowEnd = __atomic_load_n(&recorderHead, __ATOMIC_ACQUIRE);
+    recorderSetState(RECORDER_SAVING);
+}
+
+// Raw tap of the CAN driver: runs in its RX task for every frame on the bus
+void recorderRecord(const CAN_FRAME &frame)
+{
+    int state = recorderGetState();
+    if (state == RECORDER_SAVING || state == RECORDER_CLOSING)
+    {
+        recorderSkipped++;
+        return;
+    }
+    if (state == RECORDER_OFF)
+        return;
+    if (state == RECORDER_POST && recorderHead - recorderWindowStart > recorderMask)
+    {
+        recorderFreeze(); // the ring is full of the window, one more frame would overwrite its start
+        recorderSkipped++;
+        return;
+    }
+    recorderRing[recorderHead & recorderMask] = frame;
+    __atomic_store_n(&recorderHead, recorderHead + 1, __ATOMIC_RELEASE); // the frame is in before loop() sees it
+    if (recorderFilled <= recorderMask)
+        __atomic_store_n(&recorderFilled, recorderFilled + 1, __ATOMIC_RELEASE);
+}
+
+void recorderSetup()
+{
+    if (!LittleFS.begin(true)) // format on first use
+    {
+        Serial.println("Recorder: LittleFS not available");
+        return;
+    }
+
+    uint32_t frames = RECORDER_RING_FRAMES;
+    if (psramFound())
+    {
+        recorderRing = (CAN_FRAME *)ps_malloc(RECORDER_RING_FRAMES_PSRAM * sizeof(CAN_FRAME));
+        frames = RECORDER_RING_FRAMES_PSRAM;
+    }
+    if (!recorderRing)
+    {
+        recorderRing = (CAN_FRAME *)malloc(RECORDER_RING_FRAMES * sizeof(CAN_FRAME));
+        frames = RECORDER_RING_FRAMES;
+    }
+    if (!recorderRing)
+    {
+        Serial.println("Recorder: no memory for the ring");
+        return;
+    }
+    recorderMask = frames - 1;
+
+    File root = LittleFS.open("/");
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        int n = recorderFileNumber(file.name());
+        if (n >= recorderNextNumber)
+            recorderNextNumber = n + 1;
+    }
+
+    xTaskCreatePinnedToCore(recorderTask, "recorder", RECORDER_TASK_STACK, NULL, RECORDER_TASK_PRIORITY, NULL,
+                            RECORDER_TASK_CORE);
+    recorderSetState(RECORDER_ARMED);
+    CAN0.setRawTap(recorderRecord);
+}
+
+// Opens a window around now. Returns false if the recorder is off or busy with one.
+bool recorderTrigger(int reason)
+{
+    int state = recorderGetState();
+    if (state != RECORDER_ARMED)
+    {
+        if (state != RECORDER_OFF)
+            recorderIgnored++;
+        return false;
+    }
+
+    recorderReason = reason;
+    recorderTriggerCount[reason]++;
+    recorderTriggerTime = micros();
+
+    // the window starts at the oldest frame that is at most RECORDER_PRE_MS old, reaching back
+    // over no more than 3/4 of the ring so the post-trigger window has room too. The RX task
+    // keeps recording meanwhile, the quarter left over is far more than it fills in that time.
+    uint32_t reach = (recorderMask + 1) / 4 * 3;
+    uint32_t head = __atomic_load_n(&recorderHead, __ATOMIC_ACQUIRE);
+    uint32_t filled = __atomic_load_n(&recorderFilled, __ATOMIC_ACQUIRE);
+    uint32_t start = head;
+    uint32_t oldest = head - (filled < reach ? filled : reach);
+    while (start != oldest &&
+           recorderTriggerTime - recorderRing[(start - 1) & recorderMask].timestamp <= RECORDER_PRE_MS * 1000ul)
+        start--;
+    recorderWindowStart = start;
+    recorderSetState(RECORDER_POST);
+    return true;
+}
+
+// Call on every loop() pass: shift trigger and the end of the post-trigger window
+void recorderUpdate()
+{
+    bool shift = v[CURRENT_ENGINE_SPEED] >= v[PARAM_MAXRPM];
+    if (RECORDER_ON_SHIFT && shift && !recorderShiftActive)
+        recorderTrigger(RECORDER_TRIGGER_SHIFT);
+    recorderShiftActive = shift;
+
+    // timed here rather than per frame, so the window also closes when the bus has gone quiet
+    if (recorderGetState() == RECORDER_POST && micros() - recorderTriggerTime >= RECORDER_POST_MS * 1000ul)
+        recorderFreeze();
+}
+
+// Call with the driver's statistics ('S' on serial may have cleared them). The app listens
+// only, so the controller never goes bus-off: what a bad bus shows is the RX error counter
+// climbing into error passive. Both count.
+void recorderCheckBusErrors(const CAN_DRIVER_STATS &stats)
+{
+    uint32_t errors = stats.errorPassives + stats.busOffRecoveries;
+    if (RECORDER_ON_BUS_ERRORS && errors > recorderLastBusErrors)
+        recorderTrigger(RECORDER_TRIGGER_BUSERROR);
+    recorderLastBusErrors = errors;
+}
+
+void recorderPrint()
+{
+    char s[80];
+    int state = recorderGetState();
+
+    sprintf(s, "state %s, ring %u/%u frames", recorderStateName[state],
+            (unsigned int)__atomic_load_n(&recorderFilled, __ATOMIC_ACQUIRE),
+            recorderRing ? (unsigned int)(recorderMask + 1) : 0);
+    Serial.println(s);
+    sprintf(s, "triggers manual %u shift %u buserror %u button %u ignored %u",
+            (unsigned int)recorderTriggerCount[RECORDER_TRIGGER_MANUAL],
+            (unsigned int)recorderTriggerCount[RECORDER_TRIGGER_SHIFT],
+            (unsigned int)recorderTriggerCount[RECORDER_TRIGGER_BUSERROR],
+            (unsigned int)recorderTriggerCount[RECORDER_TRIGGER_BUTTON], (unsigned int)recorderIgnored);
+    Serial.println(s);
+    sprintf(s, "saved %u failed %u skipped frames %u", (unsigned int)recorderSaved, (unsigned int)recorderFailed,
+            (unsigned int)recorderSkipped);
+    Serial.println(s);
+    if (state == RECORDER_OFF)
+        return;
+
+    File root = LittleFS.open("/");
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+        if (recorderFileNumber(file.name()) >= 0)
+        {
+            sprintf(s, "  %-34s %7u bytes", file.name(), (unsigned int)file.size());
+            Serial.println(s);
+        }
+}
+
+// Prints every saved capture as hex between REC BEGIN / REC END lines for tools/recdump
+void recorderDump()
+{
+    char s[80];
+    uint8_t buffer[RECORDER_DUMP_LINE];
+    int state = recorderGetState();
+
+    if (state == RECORDER_OFF || state == RECORDER_SAVING || state == RECORDER_CLOSING)
+    {
+        Serial.println("Recorder busy or off, try again");
+        return;
+    }
+
+    File root = LittleFS.open("/");
+    for (File file = root.openNextFile(); file; file = root.openNextFile())
+    {
+        if (recorderFileNumber(file.name()) < 0)
+            continue;
+        const char *name = strrchr(file.name(), '/');
+        name = name ? name + 1 : file.name();
+
+        sprintf(s, "REC BEGIN %s %u", name, (unsigned int)file.size());
+        Serial.println(s);
+        int n;
+        while ((n = file.read(buffer, sizeof(buffer))) > 0)
+        {
+            for (int i = 0; i < n; i++)
+                sprintf(s + 2 * i, "%02X", buffer[i]);
+            Serial.println(s);
+        }
+        sprintf(s, "REC END %s", name);
+        Serial.println(s);
+    }
+}
@@ -0,0 +1,207 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// refresh.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Display refresh scheduler
+//
+// Instead of redrawing on a timer or on every knob event, each screen declares the values
+// it shows (refreshBegin() + refreshWatch()) and loop() asks refreshDue() on every pass.
+// A redraw is due when
+//
+//   - the screen changed, or refreshRequest() was called
+//   - a watched value moved beyond its deadband since it was last drawn
+//   - a watched value differs at all and has been shown stale for REFRESH_SETTLE_MS, so the
+//     readout still settles on the exact value inside the deadband
+//   - the screen's own period elapsed (live pages like the bus profile)
+//
+// and at most REFRESH_MAX_FPS redraws happen per second: a change inside the minimum
+// interval is drawn when it ends, with whatever the value is by then.
+//
+// Deadbands are per value slot (refreshDeadband[], set in refreshSetup()).
+//
+// Screens made of independent regions (the home screen layouts) can redraw only what
+// changed: unless refreshFullRedraw(), just the regions of the signals refreshSignalDirty()
+// reports, in the order they were watched. The others keep the value they were drawn with.
+
+#define REFRESH_MAX_FPS                             20
+#define REFRESH_SETTLE_MS                     DELAY_MS
+#define REFRESH_MAX_SIGNALS                          4
+#define REFRESH_DEADBAND_RPM                        25  // engine speed readout, in RPM
+
+struct RefreshSignal
+{
+  const int *value;
+  int deadband;
+  int shown; // value when last drawn
+  bool dirty; // to be drawn by the redraw refreshDue() just allowed
+};
+
+RefreshSignal refreshSignals[REFRESH_MAX_SIGNALS];
+int refreshSignalCount = 0;
+int refreshDeadband[VALUE_COUNT];
+int refreshScreen = -1;          // key of the screen being shown, -1 before the first
+uint32_t refreshPeriodMs = 0;    // redraw at least this often, 0 for never
+bool refreshForced = true;
+bool refreshFull = true;         // the redraw due covers the whole screen
+uint32_t refreshLastDraw = 0;
+uint32_t refreshStaleSince = 0;  // first pass a watched value differed from what's shown, 0 if none
+
+uint32_t refreshRedraws = 0;
+uint32_t refreshOnChange = 0;    // of which for a value beyond its deadband
+uint32_t refreshOnSettle = 0;    // for a value that stayed inside its deadband
+uint32_t refreshOnPeriod = 0;
+uint32_t refreshDeferred = 0;    // redraws that had to wait for the frame rate cap
+bool refreshWaiting = false;
+
+void refreshSetup()
+{
+  for (int i = 0; i < VALUE_COUNT; i++)
+    refreshDeadband[i] = 0;
+  refreshDeadband[CURRENT_ENGINE_SPEED] = REFRESH_DEADBAND_RPM;
+}
+
+// A new screen (key) is on: forget the old signals and draw it. periodMs for screens that
+// show live data not held in a watched value
+void refreshBegin(int screen, uint32_t periodMs)
+{
+  refreshScreen = screen;
+  refreshPeriodMs = periodMs;
+  refreshSignalCount = 0;
+  refreshForced = true;
+}
+
+void refreshWatch(const int *value, int deadband)
+{
+  if (refreshSignalCount >= REFRESH_MAX_SIGNALS)
+    return;
+  refreshSignals[refreshSignalCount++] = {value, deadband, *value, true};
+}
+
+// Watch v[slot] with the slot's deadband
+void refreshWatchValue(int slot)
+{
+  refreshWatch(&v[slot], refreshDeadband[slot]);
+}
+
+void refreshRequest()
+{
+  refreshForced = true;
+}
+
+bool refreshDue(uint32_t now)
+{
+  int reason = 0; // 1 forced, 2 beyond deadband, 3 settle, 4 period
+  bool stale = false;
+
+  for (int i = 0; i < refreshSignalCount; i++)
+  {
+    int delta = *refreshSignals[i].value - refreshSignals[i].shown;
+    if (delta < 0)
+      delta = -delta;
+    if (delta > refreshSignals[i].deadband)
+      reason = 2;
+    else if (delta)
+      stale = true;
+  }
+  if (!stale)
+    refreshStaleSince = 0;
+  else if (!refreshStaleSince)
+    refreshStaleSince = now | 1; // 0 means none
+  if (!reason && refreshStaleSince && now - refreshStaleSince >= REFRESH_SETTLE_MS)
+    reason = 3;
+  if (!reason && refreshPeriodMs && now - refreshLastDraw >= refreshPeriodMs)
+    reason = 4;
+  if (refreshForced)
+    reason = 1;
+  if (!reason)
+    return false;
+
+  if (now - refreshLastDraw < 1000 / REFRESH_MAX_FPS)
+  {
+    if (!refreshWaiting)
+      refreshDeferred++;
+    refreshWaiting = true;
+    return false;
+  }
+  refreshFull = reason == 1 || reason == 4;
+  for (int i = 0; i < refreshSignalCount; i++)
+  {
+    int delta = *refreshSignals[i].value - refreshSignals[i].shown;
+    if (delta < 0)
+      delta = -delta;
+    refreshSignals[i].dirty = refreshFull || delta > (reason == 3 ? 0 : refreshSignals[i].deadband);
+  }
+
+  refreshRedraws++;
+  if (reason == 2)
+    refreshOnChange++;
+  else if (reason == 3)
+    refreshOnSettle++;
+  else if (reason == 4)
+    refreshOnPeriod++;
+  return true;
+}
+
+bool refreshFullRedraw()
+{
+  return refreshFull;
+}
+
+bool refreshSignalDirty(int i)
+{
+  return i < refreshSignalCount && refreshSignals[i].dirty;
+}
+
+// The screen was just drawn, the dirty signals with their current values
+void refreshDone(uint32_t now)
+{
+  for (int i = 0; i < refreshSignalCount; i++)
+    if (refreshSignals[i].dirty)
+      refreshSignals[i].shown = *refreshSignals[i].value;
+  refreshForced = false;
+  refreshStaleSince = 0;
+  refreshWaiting = false;
+  refreshLastDraw = now;
+}
+
+void refreshPrint()
+{
+  char s[100];
+
+  sprintf(s, "refresh: %u redraws, %u on change, %u settled, %u periodic, %u deferred by the %d fps cap",
+          (unsigned int)refreshRedraws, (unsigned int)refreshOnChange, (unsigned int)refreshOnSettle,
+          (unsigned int)refreshOnPeriod, (unsigned int)refreshDeferred, REFRESH_MAX_FPS);
+  Serial.println(s);
+}
+
+void refreshResetStats()
+{
+  refreshRedraws = 0;
+  refreshOnChange = 0;
+  refreshOnSettle = 0;
+  refreshOnPeriod = 0;
+  refreshDeferred = 0;
+}
@@ -70,6 +70,7 @@ volatile int     KY040_COUNTER              = 0;
 
 ///////////////////////////////// SN65HVD230 CAN Bus module /////////////////////////////////
 // (add some info)
+#define          CAN_RX_BATCH                 16 // frames taken from the driver per readBatch() call
 
 ///////////////////////////////// GENERIC PHOTORESISTOR /////////////////////////////////////
 // (add some info)
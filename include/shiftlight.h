@@ -0,0 +1,174 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// shiftlight.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Shift light frames
+//
+// The strip only ever shows WS2812_NUMPIXELS + 2 pictures: none to all of its pixels lit in
+// the RPM pattern, and the all blue flash of the shift pattern. They are built once, scaled
+// to the brightness the way the NeoPixel library scales setPixelColor(), and rebuilt only
+// when MAX RPM, the brightness or the pattern change. On every loop() pass
+// shiftLightUpdate() turns the engine speed into one of them with integer math and calls
+// strip.show() only when it differs from the one on the strip: the RPM moved to another
+// bucket, or the shift pattern's blink changed phase. Everything else skips the bit-banged
+// refresh of the whole strip.
+//
+// 'w' on serial prints how many show() calls that leaves per second, 'W' clears the counters.
+
+#define SHIFT_LIGHT_FRAMES           (WS2812_NUMPIXELS + 2)
+#define SHIFT_LIGHT_DARK                             0  // frame n has the first n pixels lit
+#define SHIFT_LIGHT_FLASH       (WS2812_NUMPIXELS + 1)  // on phase of the shift pattern
+#define SHIFT_LIGHT_BLINK_MS                       100  // each phase of the shift pattern
+
+uint32_t shiftLightPattern[WS2812_NUMPIXELS]; // color of each pixel when lit
+uint32_t shiftLightFrames[SHIFT_LIGHT_FRAMES][WS2812_NUMPIXELS];
+int shiftLightMaxRpm = -1;                    // what the frames were built for, -1 to rebuild
+int shiftLightBrightness = -1;
+int shiftLightShown = -1;                     // frame on the strip, -1 for none yet
+
+uint32_t shiftLightPasses = 0;
+uint32_t shiftLightShows = 0;
+uint32_t shiftLightRebuilds = 0;
+uint32_t shiftLightSecondStart = 0;
+uint32_t shiftLightSecondPasses = 0;
+uint32_t shiftLightSecondShows = 0;
+uint32_t shiftLightPassesPerSecond = 0;       // over the last full second
+uint32_t shiftLightShowsPerSecond = 0;
+uint32_t shiftLightPeakShowsPerSecond = 0;
+
+// Green, white and red thirds. Call again after changing shiftLightPattern[]
+void shiftLightSetup()
+{
+  int firstThird = WS2812_NUMPIXELS / 3;
+  int secondThird = WS2812_NUMPIXELS - firstThird; // the last LED still gets red
+
+  for (int i = 0; i < WS2812_NUMPIXELS; i++)
+    shiftLightPattern[i] = i < firstThird    ? Adafruit_NeoPixel::Color(0, 192, 0)
+                           : i < secondThird ? Adafruit_NeoPixel::Color(255, 255, 255)
+                                             : Adafruit_NeoPixel::Color(255, 0, 0);
+  shiftLightMaxRpm = -1;
+}
+
+// What setPixelColor() stores at a given setBrightness()
+uint32_t shiftLightScale(uint32_t color, int brightness)
+{
+  if (brightness >= 255)
+    return color;
+  uint32_t scaled = 0;
+  for (int shift = 0; shift < 24; shift += 8)
+    scaled |= ((((color >> shift) & 0xff) * (brightness + 1)) >> 8) << shift;
+  return scaled;
+}
+
+void shiftLightBuild(int maxRpm, int brightness)
+{
+  for (int f = 0; f <= WS2812_NUMPIXELS; f++)
+    for (int i = 0; i < WS2812_NUMPIXELS; i++)
+      shiftLightFrames[f][i] = i < f ? shiftLightScale(shiftLightPattern[i], brightness) : 0;
+  for (int i = 0; i < WS2812_NUMPIXELS; i++)
+    shiftLightFrames[SHIFT_LIGHT_FLASH][i] = shiftLightScale(Adafruit_NeoPixel::Color(0, 0, 255), brightness);
+
+  strip.setBrightness(255); // the frames are scaled already
+  shiftLightMaxRpm = maxRpm;
+  shiftLightBrightness = brightness;
+  shiftLightShown = -1;
+  shiftLightRebuilds++;
+}
+
+// The frame for the engine speed now: pixels 0 to rpm * WS2812_NUMPIXELS / MAX RPM lit, none
+// at MIN RPM, blinking blue from MAX RPM on
+int shiftLightFrame(uint32_t now)
+{
+  int rpm = v[CURRENT_ENGINE_SPEED];
+  int maxRpm = v[PARAM_MAXRPM];
+
+  if (rpm >= maxRpm)
+    return (now / SHIFT_LIGHT_BLINK_MS) & 1 ? SHIFT_LIGHT_DARK : SHIFT_LIGHT_FLASH;
+  if (rpm == v[VALUE_MINRPM] || maxRpm <= 0)
+    return SHIFT_LIGHT_DARK;
+  int lit = rpm * WS2812_NUMPIXELS / maxRpm + 1;
+  return lit < 0 ? 0 : (lit > WS2812_NUMPIXELS ? WS2812_NUMPIXELS : lit);
+}
+
+void shiftLightUpdate()
+{
+  uint32_t now = millis();
+  int brightness = v[v[CURRENT_BRIGHTNESS]];
+
+  if (v[PARAM_MAXRPM] != shiftLightMaxRpm || brightness != shiftLightBrightness)
+    shiftLightBuild(v[PARAM_MAXRPM], brightness);
+
+  if (now - shiftLightSecondStart >= 1000)
+  {
+    shiftLightPassesPerSecond = shiftLightSecondPasses;
+    shiftLightShowsPerSecond = shiftLightSecondShows;
+    if (shiftLightShowsPerSecond > shiftLightPeakShowsPerSecond)
+      shiftLightPeakShowsPerSecond = shiftLightShowsPerSecond;
+    shiftLightSecondPasses = 0;
+    shiftLightSecondShows = 0;
+    shiftLightSecondStart = now;
+  }
+  shiftLightPasses++;
+  shiftLightSecondPasses++;
+
+  int frame = shiftLightFrame(now);
+  if (frame == shiftLightShown)
+  {
+    if (LATENCY_INSTRUMENTATION)
+      latencyStripUnchanged();
+    return;
+  }
+
+  for (int i = 0; i < WS2812_NUMPIXELS; i++)
+    strip.setPixelColor(i, shiftLightFrames[frame][i]);
+  uint32_t showStart = micros();
+  strip.show();
+  if (LATENCY_INSTRUMENTATION)
+    latencyStripShown(showStart, micros());
+  shiftLightShown = frame;
+  shiftLightShows++;
+  shiftLightSecondShows++;
+}
+
+void shiftLightPrint()
+{
+  char s[80];
+
+  sprintf(s, "show() %u of %u passes, %u frame rebuilds", (unsigned int)shiftLightShows,
+          (unsigned int)shiftLightPasses, (unsigned int)shiftLightRebuilds);
+  Serial.println(s);
+  sprintf(s, "last second %u shows/s of %u passes/s, peak %u shows/s", (unsigned int)shiftLightShowsPerSecond,
+          (unsigned int)shiftLightPassesPerSecond, (unsigned int)shiftLightPeakShowsPerSecond);
+  Serial.println(s);
+}
+
+void shiftLightResetStats()
+{
+  shiftLightPasses = 0;
+  shiftLightShows = 0;
+  shiftLightRebuilds = 0;
+  shiftLightPeakShowsPerSecond = 0;
+}
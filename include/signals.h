@@ -0,0 +1,43 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// signals.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Signals decoded from the CAN bus into v[]
+//
+// One line per signal, sorted by frame ID. The layouts come from dbc/abarth500.dbc through
+// the generated dbc_abarth500.h; to decode a new signal add it to the DBC and pick it here
+// with the value slot it should land in. CAN_SIGNAL_DEF() still works for one-off signals.
+
+#include "can_signal.h"
+#include "dbc_abarth500.h"
+
+constexpr CAN_SIGNAL canSignals[] = {
+    DBC_ABARTH500_ENGINESTATUS_ENGINESPEED(CURRENT_ENGINE_SPEED),
+};
+
+#define CAN_SIGNAL_COUNT (int)(sizeof(canSignals) / sizeof(canSignals[0]))
+
+static_assert(canSignalsSorted(canSignals, CAN_SIGNAL_COUNT), "canSignals[] must be sorted by frame ID");
@@ -87,4 +87,4 @@
 // CANDISPLAY specific strings --------------------------------------------------
 
 #define FRAME_ID_ENGINE_SPEED_HEX                0x0618A001
-#define FRAME_ID_ENGINE_SPEED_DEC                2277121
\ No newline at end of file
+#define FRAME_ID_ENGINE_SPEED_DEC                102277121
\ No newline at end of file
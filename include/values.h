@@ -0,0 +1,69 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// values.h
+//
+// MIT License
+//
+// Copyright (c) 2020-2022 Paolo Marcucci
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+// ==========================================================================================
+
+// ---- Value slots and menu pages
+//
+// Indices into v[] / l[] and into the menu items set up by menuSetup(). Kept apart from
+// menu.h so the host tools (tools/native/render.cpp) can address the same slots and pages
+// without pulling in the menu code.
+
+#ifndef VALUES_H
+#define VALUES_H
+
+// --- Menu configuration
+const int MENU_VALUE_MAXRPM = 101;
+const int MENU_VALUE_BRIGHTNESS_DAY = 102;
+const int MENU_VALUE_BRIGHTNESS_NIGHT = 103;
+const int MENU_VALUE_BRIGHTNESS_AUTODIM = 104;
+const int MENU_VALUE_SHOW_INFO = 106;
+const int MENU_VALUE_SHOW_HOME = 107;
+const int MENU_VALUE_DISPLAY = 108;
+const int MENU_VALUE_DISPLAY_ENGINESPEEED = 109;
+const int MENU_VALUE_DISPLAY_VEHICLESPEED = 110;
+
+// --- Dynamic values (derived from CAN readings or other sensors)
+const int CURRENT_ENGINE_SPEED = 0;                      /* From CAN Bus */
+const int CURRENT_VEHICLE_SPEED = 1;                     /* From CAN Bus */
+const int CURRENT_LIGHTLEVEL = 9;                        /* Light level from photoresistor */
+
+// --- Parameter values (to be persisted across power cycles)
+const int PARAM_MAXRPM = 2;
+const int PARAM_BRIGHTNESSDAY = 3;
+const int PARAM_BRIGHTNESSNIGHT = 4;
+const int CURRENT_DISPLAY = 5;
+const int CURRENT_BRIGHTNESS = 6; /* PARAM_BRIGHTNESSDAY or PARAM_BRIGHTNESSNIGHT */
+const int VALUE_MINRPM = 7;                              /* typically 0 */
+const int VALUE_SHOW = 8;                                /* ? */
+const int PARAM_BRIGHTNESSTHRESHOLD = 10;
+const int CURRENT_LAYOUT = 11;                           /* LAYOUT_xxx of the home screen */
+
+// --- Menu items (mi[]) other code opens directly
+const int MENU_ITEM_SETTINGS = 0;                        /* root of the menu tree */
+const int MENU_ITEM_MAXRPM = 1;
+const int MENU_ITEM_BUS_PROFILE = 12;
+
+#endif
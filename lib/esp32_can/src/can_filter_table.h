@@ -0,0 +1,142 @@
+/*
+  can_filter_table.h - Constant time software acceptance filter lookup
+
+  Filters are compiled into an open addressing hash keyed on (mask bucket, format, id & mask).
+  Every distinct mask gets a bucket; exact-ID filters (full mask for their format) all share
+  one bucket. Classifying a frame therefore costs one probe per distinct mask, no matter how
+  many filters are registered. Masks beyond CFT_MAX_BUCKETS fall back to a short linear list.
+
+  When several filters accept the same frame the lowest filter number wins, the same as the
+  old linear scan.
+*/
+
+#ifndef __CAN_FILTER_TABLE__
+#define __CAN_FILTER_TABLE__
+
+#include <stdint.h>
+#include <string.h>
+
+#define CFT_MAX_FILTERS 32
+#define CFT_HASH_SIZE 128 //power of two, at least 2x CFT_MAX_FILTERS
+#define CFT_MAX_BUCKETS 4 //bucket number goes in the top two bits of the key
+#define CFT_EXACT_MASK 0xFFFFFFFFul
+#define CFT_EMPTY 0xFF
+
+class CANFilterTable
+{
+public:
+    CANFilterTable() { clear(); }
+
+    void clear()
+    {
+        memset(slotFilter, CFT_EMPTY, sizeof(slotFilter));
+        numBuckets = 0;
+        numOverflow = 0;
+    }
+
+    //adds filter number idx. Call in any order; duplicates keep the lowest number
+    bool add(uint8_t idx, uint32_t id, uint32_t mask, bool extended)
+    {
+        const uint32_t fmtMask = extended ? 0x1FFFFFFFul : 0x7FFul;
+        mask &= fmtMask;
+        id &= mask;
+        if (mask == fmtMask) mask = CFT_EXACT_MASK;
+
+        int b = findBucket(mask);
+        if (b < 0)
+        {
+            if (numBuckets < CFT_MAX_BUCKETS)
+            {
+                b = numBuckets++;
+                bucketMask[b] = mask;
+            }
+            else
+            {
+                if (numOverflow >= CFT_MAX_FILTERS) return false;
+                overflow[numOverflow].id = id;
+                overflow[numOverflow].mask = mask;
+                overflow[numOverflow].extended = extended;
+                overflow[numOverflow].idx = idx;
+                numOverflow++;
+                return true;
+            }
+        }
+
+        uint32_t key = makeKey(b, id, extended);
+        uint32_t pos = hash(key);
+        while (slotFilter[pos] != CFT_EMPTY)
+        {
+            if (slotKey[pos] == key)
+            {
+                if (idx < slotFilter[pos]) slotFilter[pos] = idx;
+                return true;
+            }
+            pos = (pos + 1) & (CFT_HASH_SIZE - 1);
+        }
+        slotKey[pos] = key;
+        slotFilter[pos] = idx;
+        return true;
+    }
+
+    //returns the filter number that accepts this frame or -1 if none does
+    inline int match(uint32_t id, bool extended) const
+    {
+        int best = CFT_EMPTY;
+        for (int b = 0; b < numBuckets; b++)
+        {
+            uint32_t key = makeKey(b, id & bucketMask[b], extended);
+            uint32_t pos = hash(key);
+            while (slotFilter[pos] != CFT_EMPTY)
+            {
+                if (slotKey[pos] == key)
+                {
+                    if (slotFilter[pos] < best) best = slotFilter[pos];
+                    break;
+                }
+                pos = (pos + 1) & (CFT_HASH_SIZE - 1);
+            }
+        }
+        for (int i = 0; i < numOverflow; i++)
+        {
+            if ((id & overflow[i].mask) == overflow[i].id && overflow[i].extended == extended && overflow[i].idx < best)
+                best = overflow[i].idx;
+        }
+        return best == CFT_EMPTY ? -1 : best;
+    }
+
+    int bucketCount() const { return numBuckets; }
+
+private:
+    static inline uint32_t makeKey(int bucket, uint32_t maskedId, bool extended)
+    {
+        return ((uint32_t)bucket << 30) | ((uint32_t)extended << 29) | (maskedId & 0x1FFFFFFFul);
+    }
+
+    static inline uint32_t hash(uint32_t key)
+    {
+        return (uint32_t)(key * 2654435761u) >> 25; //Knuth multiplicative hash, top 7 bits index CFT_HASH_SIZE
+    }
+
+    int findBucket(uint32_t mask) const
+    {
+        for (int b = 0; b < numBuckets; b++)
+            if (bucketMask[b] == mask) return b;
+        return -1;
+    }
+
+    uint32_t slotKey[CFT_HASH_SIZE];
+    uint8_t slotFilter[CFT_HASH_SIZE];
+    uint32_t bucketMask[CFT_MAX_BUCKETS];
+    int numBuckets;
+
+    struct
+    {
+        uint32_t id;
+        uint32_t mask;
+        bool extended;
+        uint8_t idx;
+    } overflow[CFT_MAX_FILTERS];
+    int numOverflow;
+};
+
+#endif
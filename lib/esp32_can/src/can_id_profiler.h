@@ -0,0 +1,173 @@
+/*
+  can_id_profiler.h - Live per-ID traffic statistics of the receive path
+
+  Tells cyclic IDs (and their period) apart from event driven ones while the car is running,
+  to budget the RX path and pick filters. Every frame read out of the controller is counted
+  against its ID before the software filters, so IDs nobody watches show up too, as far as
+  the TWAI acceptance filter lets them through: with hardware filtering off (what the app
+  does while its BUS PROFILE page is open) that is the whole bus.
+
+  The table is open addressing with linear probing over a fixed number of slots, so an
+  update is a hash, a short probe and a few adds: no allocation, no lock, constant time.
+  A quarter of the slots always stays free to keep probes short; once the rest is taken
+  new IDs are only counted as untracked.
+
+  Period and jitter are exponential moving averages (weight 1/16, kept in 1/16 us) of the
+  time between frames and of its deviation from the average: they follow what the bus is
+  doing now and never overflow, whatever the uptime.
+
+  One writer (task_LowLevelRX). Readers copy slots out with snapshot(); like CAN_DRIVER_STATS
+  the fields are plain words, so a copy may be a frame out of step between fields. A reader
+  asks for the table to be emptied with requestClear() and the writer does it before the
+  next frame, so the two never write the same slot.
+*/
+
+#ifndef __CAN_ID_PROFILER__
+#define __CAN_ID_PROFILER__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <can_common.h>
+
+#define CIP_NUM_SLOTS 128 //power of two
+#define CIP_EWMA_SHIFT 4  //moving averages weigh a new period 1/16
+#define CIP_MAX_PERIOD_US 60000000ul //longer gaps count as this, so the averages fit 32 bits
+
+#define CIP_KEY_USED     0x80000000ul
+#define CIP_KEY_EXTENDED 0x40000000ul
+
+typedef struct
+{
+    uint32_t id;
+    bool extended;
+    uint8_t length;      //DLC of the last frame
+    uint32_t frames;
+    uint32_t changes;    //frames whose payload differed from the previous one of the ID
+    uint32_t periodUs;   //average time between frames, 0 until two were seen
+    uint32_t jitterUs;   //average deviation from periodUs
+    uint32_t lastSeen;   //timestamp of the last frame
+} CAN_ID_PROFILE;
+
+class CANIdProfiler
+{
+public:
+    CANIdProfiler() { clear(); }
+
+    //writer side, or before the writer runs
+    void clear()
+    {
+        for (int i = 0; i < CIP_NUM_SLOTS; i++)
+        {
+            slots[i].key.store(0, std::memory_order_relaxed);
+            slots[i].frames = 0;
+        }
+        used = 0;
+        overflow = 0;
+        clearRequested.store(false, std::memory_order_release);
+    }
+
+    //any task: the writer empties the table before it counts the next frame
+    void requestClear()
+    {
+        clearRequested.store(true, std::memory_order_release);
+    }
+
+    //writer side, called from the RX task for every frame
+    inline void record(const CAN_FRAME &frame)
+    {
+        if (clearRequested.load(std::memory_order_acquire)) clear();
+
+        uint32_t key = CIP_KEY_USED | (frame.extended ? CIP_KEY_EXTENDED : 0) | (frame.id & 0x1FFFFFFF);
+        uint32_t pos = (key * 2654435761u) >> (32 - CIP_SLOT_BITS);
+        Slot *s;
+        for (;; pos = (pos + 1) & (CIP_NUM_SLOTS - 1))
+        {
+            s = &slots[pos];
+            uint32_t k = s->key.load(std::memory_order_relaxed);
+            if (k == key) break;
+            if (k == 0)
+            {
+                if (used >= CIP_NUM_SLOTS / 4 * 3)
+                {
+                    overflow++;
+                    return;
+                }
+                s->frames = 0;
+                s->changes = 0;
+                s->periodAvg = 0;
+                s->jitterAvg = 0;
+                s->key.store(key, std::memory_order_release);
+                used++;
+                break;
+            }
+        }
+
+        uint64_t payload;
+        memcpy(&payload, frame.data.byte, 8);
+        if (s->frames)
+        {
+            //16x the period, in the same fixed point as the averages
+            uint32_t elapsed = frame.timestamp - s->lastSeen;
+            if (elapsed > CIP_MAX_PERIOD_US) elapsed = CIP_MAX_PERIOD_US;
+            int64_t period = (int64_t)elapsed << CIP_EWMA_SHIFT;
+            if (s->frames == 1) s->periodAvg = (uint32_t)period;
+            int64_t deviation = period - s->periodAvg;
+            s->periodAvg = (uint32_t)(s->periodAvg + (deviation >> CIP_EWMA_SHIFT));
+            if (deviation < 0) deviation = -deviation;
+            s->jitterAvg = (uint32_t)(s->jitterAvg + ((deviation - (int64_t)s->jitterAvg) >> CIP_EWMA_SHIFT));
+            if (payload != s->payload) s->changes++;
+        }
+        s->payload = payload;
+        s->lastSeen = frame.timestamp;
+        s->length = frame.length;
+        s->frames++;
+    }
+
+    //reader side. Copies up to max tracked IDs into out (in no particular order) and returns
+    //how many it copied
+    int snapshot(CAN_ID_PROFILE *out, int max) const
+    {
+        int n = 0;
+        for (int i = 0; i < CIP_NUM_SLOTS && n < max; i++)
+        {
+            const Slot &s = slots[i];
+            uint32_t key = s.key.load(std::memory_order_acquire);
+            if (!key || !s.frames) continue;
+            CAN_ID_PROFILE &p = out[n++];
+            p.id = key & 0x1FFFFFFF;
+            p.extended = (key & CIP_KEY_EXTENDED) != 0;
+            p.length = s.length;
+            p.frames = s.frames;
+            p.changes = s.changes;
+            p.periodUs = s.frames > 1 ? s.periodAvg >> CIP_EWMA_SHIFT : 0;
+            p.jitterUs = s.frames > 1 ? s.jitterAvg >> CIP_EWMA_SHIFT : 0;
+            p.lastSeen = s.lastSeen;
+        }
+        return n;
+    }
+
+    uint32_t untracked() const { return overflow; } //frames of IDs that found no free slot
+
+private:
+    static const int CIP_SLOT_BITS = __builtin_ctz(CIP_NUM_SLOTS);
+
+    typedef struct
+    {
+        std::atomic<uint32_t> key; //CIP_KEY_USED | extended | id, 0 while free
+        uint32_t frames;
+        uint32_t changes;
+        uint32_t periodAvg; //1/16 us
+        uint32_t jitterAvg; //1/16 us
+        uint32_t lastSeen;
+        uint64_t payload;
+        uint8_t length;
+    } Slot;
+
+    Slot slots[CIP_NUM_SLOTS];
+    int used;
+    uint32_t overflow;
+    std::atomic<bool> clearRequested;
+};
+
+#endif
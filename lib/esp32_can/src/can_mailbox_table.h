@@ -0,0 +1,119 @@
+/*
+  can_mailbox_table.h - Latest-value slot per filter, protected by a sequence counter
+
+  For consumers that only care about the newest payload of an ID (gauges, shift lights)
+  the RX task can overwrite a fixed slot instead of queueing every frame. Each slot is a
+  seqlock: the writer makes the counter odd, writes, and makes it even again; a reader
+  copies the slot and retries if the counter moved. Readers never block the writer and
+  the writer never waits for readers.
+
+  One writer (task_LowLevelRX) and one reader per slot. Every slot counts how many frames
+  were written and how many of them were overwritten before a reader got to see them.
+*/
+
+#ifndef __CAN_MAILBOX_TABLE__
+#define __CAN_MAILBOX_TABLE__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <can_common.h>
+
+#define CMT_NUM_SLOTS 32
+#define CMT_READ_RETRIES 4
+
+typedef struct
+{
+    std::atomic<uint32_t> seq;      //odd while the writer is in the slot
+    std::atomic<uint32_t> seqRead;  //last even seq a reader copied out (written by the reader)
+    uint32_t id;
+    uint32_t timestamp;
+    uint8_t length;
+    uint8_t extended;
+    uint8_t rtr;
+    uint8_t data[8];
+    uint32_t writes;      //frames stored in this slot
+    uint32_t overwrites;  //frames replaced before anybody read them
+} CAN_MAILBOX_SLOT;
+
+class CANMailboxTable
+{
+public:
+    CANMailboxTable() { clear(); }
+
+    void clear()
+    {
+        for (int i = 0; i < CMT_NUM_SLOTS; i++) clearSlot(i);
+    }
+
+    void clearSlot(int slot)
+    {
+        CAN_MAILBOX_SLOT &s = slots[slot];
+        s.seq.store(0);
+        s.seqRead.store(0);
+        s.id = 0;
+        s.timestamp = 0;
+        s.length = 0;
+        s.extended = 0;
+        s.rtr = 0;
+        memset(s.data, 0, 8);
+        s.writes = 0;
+        s.overwrites = 0;
+    }
+
+    //writer side, called from the RX task only
+    inline void write(int slot, const CAN_FRAME &frame)
+    {
+        CAN_MAILBOX_SLOT &s = slots[slot];
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        if (seq != 0 && s.seqRead.load(std::memory_order_relaxed) != seq) s.overwrites++;
+
+        s.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.id = frame.id;
+        s.timestamp = frame.timestamp;
+        s.length = frame.length;
+        s.extended = frame.extended;
+        s.rtr = frame.rtr;
+        memcpy(s.data, frame.data.byte, 8);
+        s.writes++;
+        s.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    //reader side. Copies the newest frame of the slot into msg. msg.fid is set to the number
+    //of frames ever written to the slot so the caller can tell whether it has seen this one.
+    //coalesced (optional) receives the running count of frames that were never read.
+    //Returns false if the slot is still empty or the writer kept it busy for every retry.
+    bool read(int slot, CAN_FRAME &msg, uint32_t *coalesced = NULL)
+    {
+        CAN_MAILBOX_SLOT &s = slots[slot];
+        for (int attempt = 0; attempt < CMT_READ_RETRIES; attempt++)
+        {
+            uint32_t before = s.seq.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) continue;
+
+            msg.id = s.id;
+            msg.timestamp = s.timestamp;
+            msg.length = s.length;
+            msg.extended = s.extended;
+            msg.rtr = s.rtr;
+            memcpy(msg.data.byte, s.data, 8);
+            msg.fid = s.writes;
+            uint32_t lost = s.overwrites;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != before) continue;
+
+            s.seqRead.store(before, std::memory_order_relaxed);
+            if (coalesced) *coalesced = lost;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    CAN_MAILBOX_SLOT slots[CMT_NUM_SLOTS];
+};
+
+#endif
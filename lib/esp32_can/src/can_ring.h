@@ -0,0 +1,111 @@
+/*
+  can_ring.h - Lock-free single producer / single consumer ring of CAN frames
+
+  The producer (normally task_LowLevelRX) claims a slot, fills the frame in place and
+  commits it. The consumer peeks the oldest frame in place and releases it when done.
+  Nothing is copied through a kernel queue and no critical section is taken, so this
+  must only ever be used with exactly one producer task and one consumer task.
+
+  Storage is allocated once and the capacity is always a power of two.
+*/
+
+#ifndef __CAN_RING__
+#define __CAN_RING__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <can_common.h>
+
+class CANFrameRing
+{
+public:
+    CANFrameRing() : buf(NULL), mask(0), head(0), tail(0) {}
+
+    //allocates room for at least size frames. Can only be done once.
+    bool allocate(uint32_t size)
+    {
+        if (buf || size > 0x80000000ul) return false;
+        uint32_t cap = 2;
+        while (cap < size) cap <<= 1;
+        buf = (CAN_FRAME *)calloc(cap, sizeof(CAN_FRAME));
+        if (!buf) return false;
+        mask = cap - 1;
+        return true;
+    }
+
+    uint32_t capacity() const { return buf ? mask + 1 : 0; }
+
+    uint32_t count() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    //producer side. Returns the slot to fill or NULL if the ring is full.
+    //Calling claim again before commit returns the same slot.
+    inline CAN_FRAME *claim()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (!buf || h - tail.load(std::memory_order_acquire) > mask) return NULL;
+        return &buf[h & mask];
+    }
+
+    //producer side. Publishes the slot returned by claim()
+    inline void commit()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //consumer side. Returns the oldest frame in place or NULL if the ring is empty
+    inline CAN_FRAME *peek()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (!buf || head.load(std::memory_order_acquire) == t) return NULL;
+        return &buf[t & mask];
+    }
+
+    //consumer side. Hands the slot returned by peek() back to the producer
+    inline void release()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    //copying helpers for callers that can't work in place
+    inline bool push(const CAN_FRAME &frame)
+    {
+        CAN_FRAME *slot = claim();
+        if (!slot) return false;
+        *slot = frame;
+        commit();
+        return true;
+    }
+
+    inline bool pop(CAN_FRAME &frame)
+    {
+        CAN_FRAME *slot = peek();
+        if (!slot) return false;
+        frame = *slot;
+        release();
+        return true;
+    }
+
+    //consumer side. Copies out up to max frames and releases them all with one store
+    uint32_t popBatch(CAN_FRAME *out, size_t max)
+    {
+        if (!buf) return 0;
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t n = head.load(std::memory_order_acquire) - t;
+        if (n > max) n = max;
+        for (uint32_t i = 0; i < n; i++) out[i] = buf[(t + i) & mask];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    CAN_FRAME *buf;
+    uint32_t mask;
+    std::atomic<uint32_t> head; //only written by the producer
+    std::atomic<uint32_t> tail; //only written by the consumer
+};
+
+#endif
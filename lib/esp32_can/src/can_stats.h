@@ -0,0 +1,50 @@
+/*
+  can_stats.h - Counters every driver in this library keeps about its receive path
+
+  Each driver owns one CAN_DRIVER_STATS, updated only by its own RX task, and hands out a
+  copy through getStats(). Counters never wrap back on their own; resetStats() clears them.
+  The values are plain 32 bit words so the application can read them without locking, at
+  the cost of a copy that may be a frame or two out of step between fields.
+
+  Counters a driver has no way of knowing about (the MCP2515 has no software filters, the
+  built-in controller is never reset) simply stay at zero.
+*/
+
+#ifndef __CAN_STATS__
+#define __CAN_STATS__
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct
+{
+    uint32_t framesReceived;    //frames read out of the controller
+    uint32_t framesAccepted;    //frames that passed the software filters
+    uint32_t filterMisses;      //frames no software filter wanted
+    uint32_t rxDropped;         //accepted frames lost because the RX queue was full
+    uint32_t callbackDropped;   //accepted frames lost because the callback queue was full
+    uint32_t criticalDropped;   //frames lost from the critical callback lane (should stay zero)
+    uint32_t callbackCoalesced; //bulk frames replaced by a newer one before their callback ran
+    uint32_t callbacksInline;   //callbacks run straight from the RX task, without a queue
+    uint32_t hardwareOverruns;  //frames the controller itself had no room for
+    uint32_t busOffRecoveries;  //times the controller went bus-off and was brought back
+    uint32_t errorPassives;     //times an error counter reached 128 (error passive). Unlike
+                                //bus-off this also happens in listen-only mode, from RX errors
+    uint32_t hardwareResets;    //times the driver had to reset the controller
+    uint32_t rxHighWater;       //most frames ever waiting in the RX queue
+    uint32_t rxCapacity;
+    uint32_t callbackHighWater; //most frames ever waiting in the callback queue
+    uint32_t callbackCapacity;
+} CAN_DRIVER_STATS;
+
+static inline void canStatsClear(CAN_DRIVER_STATS &stats)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+static inline void canStatsHighWater(uint32_t &mark, uint32_t depth)
+{
+    if (depth > mark) mark = depth;
+}
+
+#endif
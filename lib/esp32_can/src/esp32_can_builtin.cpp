@@ -17,7 +17,11 @@ twai_timing_config_t twai_speed_cfg = TWAI_TIMING_CONFIG_500KBITS();
 twai_filter_config_t twai_filters_cfg = TWAI_FILTER_CONFIG_ACCEPT_ALL();
 
 QueueHandle_t callbackQueue;
-QueueHandle_t rx_queue;
+QueueHandle_t callbackQueueCritical; //frames of critical filters only, so they're never starved by chatter
+QueueHandle_t callbackQueueBulk;
+
+volatile uint32_t biIntsCounter = 0; //frames handed to us by the TWAI driver
+volatile uint32_t biReadFrames = 0;  //frames the application took out of the RX ring or mailboxes
 
 //because of the way the TWAI library works, it's just easier to store the valid timings here and anything not found here
 //is just plain not supported. If you need a different speed then add it here. Be sure to leave the zero record at the end
@@ -50,9 +54,21 @@ ESP32CAN::ESP32CAN(gpio_num_t rxPin, gpio_num_t txPin) : CAN_COMMON(32)
     cyclesSinceTraffic = 0;
     initializedResources = false;
     readyForTraffic = false;
+    driverInstalled = false;
+    hardwareFiltering = true;
+    hardwareFilterPending = false;
+    mailboxMode = false;
+    idProfiling = false;
+    rawTap.store(NULL);
+    activeFilterTable.store(0);
+    filterTableUsers[0].store(0);
+    filterTableUsers[1].store(0);
     twai_general_cfg.tx_queue_len = BI_TX_BUFFER_SIZE;
     twai_general_cfg.rx_queue_len = 6;
     rxBufferSize = BI_RX_BUFFER_SIZE;
+    callbackTask = NULL;
+    bulkPending.store(0);
+    canStatsClear(stats);
 }
 
 ESP32CAN::ESP32CAN() : CAN_COMMON(BI_NUM_FILTERS) 
@@ -68,10 +84,24 @@ ESP32CAN::ESP32CAN() : CAN_COMMON(BI_NUM_FILTERS)
         filters[i].mask = 0;
         filters[i].extended = false;
         filters[i].configured = false;
+        filters[i].priority = BI_PRIORITY_NORMAL;
+        filters[i].inlineCallback = false;
     }
     initializedResources = false;
     readyForTraffic = false;
+    driverInstalled = false;
+    hardwareFiltering = true;
+    hardwareFilterPending = false;
+    mailboxMode = false;
+    idProfiling = false;
+    rawTap.store(NULL);
+    activeFilterTable.store(0);
+    filterTableUsers[0].store(0);
+    filterTableUsers[1].store(0);
     cyclesSinceTraffic = 0;
+    callbackTask = NULL;
+    bulkPending.store(0);
+    canStatsClear(stats);
 }
 
 void ESP32CAN::setCANPins(gpio_num_t rxPin, gpio_num_t txPin)
@@ -80,19 +110,51 @@ void ESP32CAN::setCANPins(gpio_num_t rxPin, gpio_num_t txPin)
     twai_general_cfg.tx_io = txPin;
 }
 
+void ESP32CAN::setHardwareFiltering(bool state)
+{
+    hardwareFiltering = state;
+    applyHardwareFilter();
+}
+
+//Critical filters get a callback lane of their own that task_CAN always empties first.
+//Bulk filters get a lane that, once full, only keeps the newest frame of each filter.
+void ESP32CAN::setFilterPriority(uint8_t mailbox, uint8_t priority)
+{
+    if (mailbox < BI_NUM_FILTERS && priority <= BI_PRIORITY_BULK) filters[mailbox].priority = priority;
+}
+
+//Single hop mode. Callbacks of this filter are called directly from task_LowLevelRX with the
+//frame still sitting in the RX ring slot it was built in: no callback queue, no switch to
+//task_CAN and no extra copies. Only for handlers that are short and never block, since the
+//RX task can't receive anything while they run (and they run on its 4k stack).
+//Frames of this filter still queued in a callback lane when this is switched on may be
+//delivered after newer ones that went inline.
+void ESP32CAN::setInlineCallback(uint8_t mailbox, bool state)
+{
+    if (mailbox < BI_NUM_FILTERS) filters[mailbox].inlineCallback = state;
+}
+
 void CAN_WatchDog_Builtin( void *pvParameters )
 {
     ESP32CAN* espCan = (ESP32CAN*)pvParameters;
     const TickType_t xDelay = 200 / portTICK_PERIOD_MS;
     twai_status_info_t status_info;
+    bool errorPassive = false; //so each stretch of error passive is counted once
 
     for(;;)
     {
         vTaskDelay( xDelay );
         espCan->cyclesSinceTraffic++;
+        espCan->refreshDispatch(); //listeners may have changed their handlers without telling us
 
         if (twai_get_status_info(&status_info) == ESP_OK)
         {
+            //listen-only never goes bus-off, but a noisy bus still drives the RX error counter up
+            bool passive = status_info.state == TWAI_STATE_BUS_OFF || status_info.rx_error_counter >= 128 ||
+                           status_info.tx_error_counter >= 128;
+            if (passive && !errorPassive) espCan->stats.errorPassives++;
+            errorPassive = passive;
+
             if (status_info.state == TWAI_STATE_BUS_OFF)
             {
                 espCan->cyclesSinceTraffic = 0;
@@ -100,6 +162,7 @@ void CAN_WatchDog_Builtin( void *pvParameters )
                 {
                     printf("Could not initiate bus recovery!\n");
                 }
+                else espCan->stats.busOffRecoveries++;
             }
         }
     }
@@ -119,7 +182,9 @@ void task_LowLevelRX(void *pvParameters)
         {
             if (twai_receive(&message, pdMS_TO_TICKS(100)) == ESP_OK)
             {
-                espCan->processFrame(message);
+                //stamp as early as we can, this is what jitter and latency get measured against
+                int64_t rxTime = esp_timer_get_time();
+                espCan->processFrame(message, rxTime);
             }
         }
         else vTaskDelay(pdMS_TO_TICKS(100));
@@ -140,18 +205,50 @@ bits  0-7   - Mailbox number that triggered callback
 void task_CAN( void *pvParameters )
 {
     ESP32CAN* espCan = (ESP32CAN*)pvParameters;
-    CAN_FRAME rxFrame;
 
     while (1)
     {
-        //receive next CAN frame from queue and fire off the callback
-        if(xQueueReceive(callbackQueue, &rxFrame, portMAX_DELAY)==pdTRUE)
-        {
-            espCan->sendCallback(&rxFrame);
-        }
+        //task_LowLevelRX notifies us after every frame it puts in a lane. Taking the
+        //notification before draining means a frame can't arrive unnoticed in between
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (espCan->serviceCallbacks());
     }
 }
 
+//Runs exactly one callback, picking the lanes in priority order, and returns false once all
+//of them are empty. Going back to the critical lane after every callback means a critical
+//frame never waits for more than the one callback that was already running.
+bool ESP32CAN::serviceCallbacks()
+{
+    CAN_FRAME rxFrame;
+
+    if (xQueueReceive(callbackQueueCritical, &rxFrame, 0) == pdTRUE ||
+        xQueueReceive(callbackQueue, &rxFrame, 0) == pdTRUE ||
+        xQueueReceive(callbackQueueBulk, &rxFrame, 0) == pdTRUE)
+    {
+        sendCallback(&rxFrame);
+        return true;
+    }
+
+    //the bulk lane overflowed into the latest-wins slots. The queued frames of a filter are
+    //always older than its slot, so those went first
+    uint32_t pending = bulkPending.load(std::memory_order_acquire);
+    while (pending)
+    {
+        int i = __builtin_ctz(pending);
+        pending &= pending - 1;
+        bulkPending.fetch_and(~(1ul << i), std::memory_order_acq_rel);
+        if (!bulkSlots.read(i, rxFrame)) continue;
+        if (rxFrame.fid == bulkDelivered[i]) continue; //already delivered on an earlier pass
+        bulkDelivered[i] = rxFrame.fid;
+        rxFrame.fid = dispatch[i];
+        if (rxFrame.fid == BI_DISPATCH_QUEUE) continue; //callback went away in the meantime
+        sendCallback(&rxFrame);
+        return true;
+    }
+    return false;
+}
+
 void ESP32CAN::sendCallback(CAN_FRAME *frame)
 {
     //frame buffer
@@ -162,16 +259,17 @@ void ESP32CAN::sendCallback(CAN_FRAME *frame)
     mb = (frame->fid & 0xFF);
     if (mb == 0xFF) mb = -1;
 
+    //the target was resolved when the frame came in: the callback may have gone since
     if (frame->fid & 0x80000000ul) //object callback
     {
         idx = (frame->fid >> 24) & 0x7F;
         thisListener = listener[idx];
-        thisListener->gotFrame(frame, mb);
+        if (thisListener) thisListener->gotFrame(frame, mb);
     }
     else //C function callback
     {
-        if (mb > -1) (*cbCANFrame[mb])(frame);
-        else (*cbGeneral)(frame);
+        void (*cb)(CAN_FRAME *) = mb > -1 ? cbCANFrame[mb] : cbGeneral;
+        if (cb) (*cb)(frame);
     }
 }
 
@@ -193,11 +291,186 @@ int ESP32CAN::_setFilterSpecific(uint8_t mailbox, uint32_t id, uint32_t mask, bo
         filters[mailbox].mask = mask;
         filters[mailbox].extended = extended;
         filters[mailbox].configured = true;
+        mailboxes.clearSlot(mailbox);
+        bulkSlots.clearSlot(mailbox);
+        bulkDelivered[mailbox] = 0;
+        compileFilters();
         return mailbox;
     }
     return -1;
 }
 
+//Rebuilds the constant time lookup used by processFrame and precomputes where frames
+//accepted by each filter get dispatched to. task_LowLevelRX keeps matching on the published
+//table while the other one is rebuilt; the new one then goes live with a single store.
+//Filters are changed from one task at a time.
+void ESP32CAN::compileFilters()
+{
+    int next = 1 - activeFilterTable.load();
+    //a lookup may still be on this table if it started before the last swap
+    while (filterTableUsers[next].load()) vTaskDelay(1);
+
+    CANFilterTable &table = filterTables[next];
+    table.clear();
+    for (int i = 0; i < BI_NUM_FILTERS; i++)
+        if (filters[i].configured) table.add(i, filters[i].id, filters[i].mask, filters[i].extended);
+    activeFilterTable.store(next);
+
+    refreshDispatch();
+    applyHardwareFilter();
+}
+
+//Filter number accepting the frame on the published table, -1 if none. The table is pinned
+//by a user count for the duration, so compileFilters() never rebuilds it under our feet.
+int ESP32CAN::matchFilter(uint32_t id, bool extended)
+{
+    int t;
+    for (;;)
+    {
+        t = activeFilterTable.load();
+        filterTableUsers[t].fetch_add(1);
+        if (activeFilterTable.load() == t) break;
+        filterTableUsers[t].fetch_sub(1); //swapped in between, the old one may be rebuilt now
+    }
+    int slot = filterTables[t].match(id, extended);
+    filterTableUsers[t].fetch_sub(1);
+    return slot;
+}
+
+//Narrows the TWAI acceptance filter down to what the software filters can accept, so the
+//controller throws away traffic nobody asked for before task_LowLevelRX ever wakes up.
+//The driver only takes a filter at install time. Before begin() the filter simply goes in
+//with the install; once installed, the reinstall (a 100ms blind window) waits for
+//commitFilters(), so registering a batch of filters costs one reinstall, not one each.
+void ESP32CAN::applyHardwareFilter()
+{
+    uint32_t ids[BI_NUM_FILTERS], masks[BI_NUM_FILTERS];
+    bool ext[BI_NUM_FILTERS];
+    int count = 0;
+    TWAI_FILTER_COVER cover = TWAI_COVER_ACCEPT_ALL;
+
+    for (int i = 0; i < BI_NUM_FILTERS; i++)
+    {
+        if (!filters[i].configured) continue;
+        ids[count] = filters[i].id;
+        masks[count] = filters[i].mask;
+        ext[count] = filters[i].extended;
+        count++;
+    }
+    if (hardwareFiltering) twaiCoverFilters(ids, masks, ext, count, cover);
+
+    if (cover.acceptance_code == twai_filters_cfg.acceptance_code &&
+        cover.acceptance_mask == twai_filters_cfg.acceptance_mask &&
+        cover.single_filter == twai_filters_cfg.single_filter) return;
+
+    twai_filters_cfg.acceptance_code = cover.acceptance_code;
+    twai_filters_cfg.acceptance_mask = cover.acceptance_mask;
+    twai_filters_cfg.single_filter = cover.single_filter;
+    if (debuggingMode) printf("TWAI filter code %08X mask %08X %s\n", cover.acceptance_code, cover.acceptance_mask,
+                              cover.single_filter ? "single" : "dual");
+
+    if (driverInstalled) hardwareFilterPending = true;
+}
+
+//Call once after a batch of filter changes made after begin(). Until then the controller
+//keeps the old TWAI filter, which may reject frames of filters added since.
+void ESP32CAN::commitFilters()
+{
+    if (!hardwareFilterPending || !driverInstalled) return;
+    disable();
+    enable();
+}
+
+//Works out which callback (if any) a frame accepted by this mailbox goes to. The result
+//is the fid value task_CAN expects, or BI_DISPATCH_QUEUE if no callback wants the frame.
+uint32_t ESP32CAN::resolveDispatch(int mailbox)
+{
+    CANListener *thisListener;
+
+    if (cbCANFrame[mailbox]) return mailbox;
+    if (cbGeneral) return 0xFF;
+    for (int listenerPos = 0; listenerPos < SIZE_LISTENERS; listenerPos++)
+    {
+        thisListener = listener[listenerPos];
+        if (thisListener != NULL)
+        {
+            if (thisListener->isCallbackActive(mailbox)) return 0x80000000ul + (listenerPos << 24ul) + mailbox;
+            else if (thisListener->isCallbackActive(numFilters)) return 0x80000000ul + (listenerPos << 24ul) + 0xFF; //global catch-all
+        }
+    }
+    return BI_DISPATCH_QUEUE;
+}
+
+//processFrame() takes the target from dispatch[] as is, so it has to be redone whenever
+//callbacks or listeners change: the CAN_COMMON setters below do it, and so does the watchdog
+//for listeners that changed their handlers on their own. Each entry is a single word store,
+//task_LowLevelRX sees either the old target or the new one.
+void ESP32CAN::refreshDispatch()
+{
+    for (int i = 0; i < BI_NUM_FILTERS; i++) dispatch[i] = resolveDispatch(i);
+}
+
+void ESP32CAN::setCallback(uint8_t mailbox, void (*cb)(CAN_FRAME *))
+{
+    CAN_COMMON::setCallback(mailbox, cb);
+    refreshDispatch();
+}
+
+void ESP32CAN::setGeneralCallback(void (*cb)(CAN_FRAME *))
+{
+    CAN_COMMON::setGeneralCallback(cb);
+    refreshDispatch();
+}
+
+void ESP32CAN::attachCANInterrupt(void (*cb)(CAN_FRAME *))
+{
+    setGeneralCallback(cb);
+}
+
+void ESP32CAN::attachCANInterrupt(uint8_t mailBox, void (*cb)(CAN_FRAME *))
+{
+    CAN_COMMON::attachCANInterrupt(mailBox, cb);
+    refreshDispatch();
+}
+
+void ESP32CAN::detachCANInterrupt(uint8_t mailBox)
+{
+    CAN_COMMON::detachCANInterrupt(mailBox);
+    refreshDispatch();
+}
+
+void ESP32CAN::removeCallback()
+{
+    CAN_COMMON::removeCallback();
+    refreshDispatch();
+}
+
+void ESP32CAN::removeCallback(uint8_t mailbox)
+{
+    CAN_COMMON::removeCallback(mailbox);
+    refreshDispatch();
+}
+
+void ESP32CAN::removeGeneralCallback()
+{
+    CAN_COMMON::removeGeneralCallback();
+    refreshDispatch();
+}
+
+bool ESP32CAN::attachObj(CANListener *listener)
+{
+    bool ok = CAN_COMMON::attachObj(listener);
+    refreshDispatch();
+    return ok;
+}
+
+bool ESP32CAN::detachObj(CANListener *listener)
+{
+    bool ok = CAN_COMMON::detachObj(listener);
+    refreshDispatch();
+    return ok;
+}
+
 int ESP32CAN::_setFilter(uint32_t id, uint32_t mask, bool extended)
 {
     for (int i = 0; i < BI_NUM_FILTERS; i++)
@@ -221,19 +494,27 @@ void ESP32CAN::_init()
         filters[i].mask = 0;
         filters[i].extended = false;
         filters[i].configured = false;
+        filters[i].priority = BI_PRIORITY_NORMAL;
+        filters[i].inlineCallback = false;
+        bulkDelivered[i] = 0;
     }
+    bulkSlots.clear();
+    bulkPending.store(0);
+    compileFilters();
 
     if (!initializedResources)
     {
         if (debuggingMode) printf("Initializing resources for built-in CAN\n");
 
                                  //Queue size, item size
-        callbackQueue = xQueueCreate(16, sizeof(CAN_FRAME));
-        rx_queue = xQueueCreate(rxBufferSize, sizeof(CAN_FRAME));
+        callbackQueue = xQueueCreate(BI_CALLBACK_BUFFER_SIZE, sizeof(CAN_FRAME));
+        callbackQueueCritical = xQueueCreate(BI_CRITICAL_BUFFER_SIZE, sizeof(CAN_FRAME));
+        callbackQueueBulk = xQueueCreate(BI_BULK_BUFFER_SIZE, sizeof(CAN_FRAME));
+        rxRing.allocate(rxBufferSize);
         if (debuggingMode) Serial.println("Created queues.");
 
                   //func        desc    stack, params, priority, handle to task
-        xTaskCreate(&task_CAN, "CAN_RX", 8192, this, 15, NULL);
+        xTaskCreate(&task_CAN, "CAN_RX", 8192, this, 15, &callbackTask);
         if (debuggingMode) Serial.println("task rx created.");
         if (debuggingMode) Serial.println("task low level rx created.");
         xTaskCreatePinnedToCore(&CAN_WatchDog_Builtin, "CAN_WD_BI", 2048, this, 10, NULL, 1);
@@ -335,6 +616,8 @@ void ESP32CAN::enable()
     if (twai_driver_install(&twai_general_cfg, &twai_speed_cfg, &twai_filters_cfg) == ESP_OK)
     {
         //printf("TWAI Driver installed\n");
+        driverInstalled = true;
+        hardwareFilterPending = false; //installed with the current filter
     }
     else
     {
@@ -360,70 +643,99 @@ void ESP32CAN::disable()
     twai_stop();
     vTaskDelay(pdMS_TO_TICKS(100)); //a bit of delay here seems to fix a race condition triggered by task_LowLevelRX
     twai_driver_uninstall();
+    driverInstalled = false;
 }
 
 //This function is too big to be running in interrupt context. Refactored so it doesn't.
-bool ESP32CAN::processFrame(twai_message_t &frame)
+//The frame is built directly in the next free slot of the RX ring so that frames headed
+//for the application are written exactly once. If it ends up going to a callback instead
+//the slot is simply not committed.
+bool ESP32CAN::processFrame(twai_message_t &frame, int64_t rxTime)
 {
-    CANListener *thisListener;
-    CAN_FRAME msg;
+    CAN_FRAME overflow;
+    CAN_FRAME *msg = mailboxMode ? NULL : rxRing.claim();
+    bool ringFull = (msg == NULL);
 
-    cyclesSinceTraffic = 0; //reset counter to show that we are receiving traffic
+    if (ringFull) msg = &overflow;
 
-    msg.id = frame.identifier;
-    msg.length = frame.data_length_code;
-    msg.rtr = frame.rtr;
-    msg.extended = frame.extd;
-    for (int i = 0; i < 8; i++) msg.data.byte[i] = frame.data[i];
+    cyclesSinceTraffic = 0; //reset counter to show that we are receiving traffic
+    stats.framesReceived++;
+    biIntsCounter++;
+
+    msg->id = frame.identifier;
+    msg->length = frame.data_length_code;
+    msg->rtr = frame.rtr;
+    msg->extended = frame.extd;
+    msg->timestamp = (uint32_t)rxTime; //microseconds, same clock as micros(). Wraps after ~71 minutes
+    for (int i = 0; i < 8; i++) msg->data.byte[i] = frame.data[i];
+    if (idProfiling) idProfiler.record(*msg);
+    void (*tap)(const CAN_FRAME &) = rawTap.load();
+    if (tap) tap(*msg);
     
-    for (int i = 0; i < BI_NUM_FILTERS; i++)
+    int i = matchFilter(msg->id, msg->extended);
+    if (i < 0)
     {
-        if (!filters[i].configured) continue;
-        if ((msg.id & filters[i].mask) == filters[i].id && (filters[i].extended == msg.extended))
+        stats.filterMisses++;
+        return false;
+    }
+    stats.framesAccepted++;
+
+    //frame is accepted, lets see if it goes to a callback
+    uint32_t target = dispatch[i];
+    if (target != BI_DISPATCH_QUEUE)
+    {
+        msg->fid = target;
+        if (filters[i].inlineCallback)
         {
-            //frame is accepted, lets see if it matches a mailbox callback
-            if (cbCANFrame[i])
-            {
-                msg.fid = i;
-                xQueueSend(callbackQueue, &msg, 0);
-                return true;
-            }
-            else if (cbGeneral)
-            {
-                msg.fid = 0xFF;
-                xQueueSend(callbackQueue, &msg, 0);
-                return true;
-            }
-            else
-            {
-                for (int listenerPos = 0; listenerPos < SIZE_LISTENERS; listenerPos++)
-                {
-                    thisListener = listener[listenerPos];
-                    if (thisListener != NULL)
-                    {
-                        if (thisListener->isCallbackActive(i)) 
-				        {
-					        msg.fid = 0x80000000ul + (listenerPos << 24ul) + i;
-                            xQueueSend(callbackQueue, &msg, 0);
-                            return true;
-				        }
-				        else if (thisListener->isCallbackActive(numFilters)) //global catch-all 
-				        {
-                            msg.fid = 0x80000000ul + (listenerPos << 24ul) + 0xFF;
-					        xQueueSend(callbackQueue, &msg, 0);
-                            return true;
-				        }
-                    }
-                }
-            }
-            
-            //otherwise, send frame to input queue
-            xQueueSend(rx_queue, &msg, 0);
-            if (debuggingMode) Serial.write('_');
-            return true;
+            sendCallback(msg);
+            stats.callbacksInline++;
         }
+        else queueCallback(i, msg);
+        return true;
     }
-    return false;
+
+    //otherwise, publish the frame to the application: either overwrite the filter's mailbox
+    //or queue it in the ring. Dropped if the ring is full
+    if (mailboxMode) mailboxes.write(i, *msg);
+    else if (ringFull) stats.rxDropped++;
+    else
+    {
+        rxRing.commit();
+        canStatsHighWater(stats.rxHighWater, rxRing.count());
+    }
+    if (debuggingMode) Serial.write('_');
+    return true;
+}
+
+//Puts a frame headed for a callback into the lane of the filter that accepted it
+void ESP32CAN::queueCallback(int mailbox, CAN_FRAME *msg)
+{
+    switch (filters[mailbox].priority)
+    {
+    case BI_PRIORITY_CRITICAL:
+        if (xQueueSend(callbackQueueCritical, msg, 0) != pdTRUE) stats.criticalDropped++;
+        break;
+    case BI_PRIORITY_BULK:
+        //once a filter has spilled into its slot it keeps using it until task_CAN caught up,
+        //otherwise a newer queued frame could be delivered before the older one in the slot
+        if ((bulkPending.load(std::memory_order_relaxed) & (1ul << mailbox)) ||
+            xQueueSend(callbackQueueBulk, msg, 0) != pdTRUE)
+        {
+            bulkSlots.write(mailbox, *msg);
+            if (bulkPending.fetch_or(1ul << mailbox, std::memory_order_release) & (1ul << mailbox))
+                stats.callbackCoalesced++;
+        }
+        break;
+    default:
+        if (xQueueSend(callbackQueue, msg, 0) != pdTRUE)
+        {
+            stats.callbackDropped++;
+            return;
+        }
+        canStatsHighWater(stats.callbackHighWater, uxQueueMessagesWaiting(callbackQueue));
+        break;
+    }
+    if (callbackTask) xTaskNotifyGive(callbackTask);
 }
 
 bool ESP32CAN::sendFrame(CAN_FRAME& txFrame)
@@ -459,25 +771,107 @@ bool ESP32CAN::sendFrame(CAN_FRAME& txFrame)
 
 bool ESP32CAN::rx_avail()
 {
-    if (!rx_queue) return false;
-    return uxQueueMessagesWaiting(rx_queue) > 0?true:false;
+    return rxRing.count() > 0?true:false;
 }
 
 uint16_t ESP32CAN::available()
 {
-    if (!rx_queue) return 0;
-    return uxQueueMessagesWaiting(rx_queue);
+    return rxRing.count();
 }
 
 uint32_t ESP32CAN::get_rx_buff(CAN_FRAME &msg)
 {
-    CAN_FRAME frame;
-    //receive next CAN frame from queue
-    if(xQueueReceive(rx_queue,&frame, 0) == pdTRUE)
-    {
-        msg = frame; //do a copy in the case that the receive worked
-        return true;
-    }
-    return false; //otherwise we leave the msg variable alone and just return false
+    //if a frame is waiting copy it out, otherwise we leave the msg variable alone and just return false
+    if (!rxRing.pop(msg)) return false;
+    biReadFrames++;
+    return true;
+}
+
+//Takes everything that is waiting (up to max) with a single release of the ring. If waiting
+//is given it receives the number of frames that were pending when the call was made.
+size_t ESP32CAN::readBatch(CAN_FRAME *out, size_t max, size_t *waiting)
+{
+    if (waiting) *waiting = rxRing.count();
+    size_t count = rxRing.popBatch(out, max);
+    biReadFrames += count;
+    return count;
+}
+
+//In mailbox mode frames that don't go to a callback are not queued. Each filter owns a slot
+//that always holds the newest frame it accepted; read it with readLatest()
+void ESP32CAN::setMailboxMode(bool state)
+{
+    mailboxMode = state;
+}
+
+//Non-blocking fetch of the newest frame accepted by the filter that covers this id. msg.fid
+//receives the slot's write count, which changes whenever a new frame arrives. coalesced
+//receives how many frames were overwritten before being read.
+bool ESP32CAN::readLatest(uint32_t id, bool extended, CAN_FRAME &msg, uint32_t *coalesced)
+{
+    int slot = matchFilter(id, extended);
+    if (slot < 0) return false;
+    if (!mailboxes.read(slot, msg, coalesced)) return false;
+    biReadFrames++;
+    return true;
+}
+
+CAN_FRAME *ESP32CAN::peekFrame()
+{
+    return rxRing.peek();
+}
+
+void ESP32CAN::releaseFrame()
+{
+    rxRing.release();
+    biReadFrames++;
 }
 
+//Copy of the receive counters. Queue capacities are filled in here, and the number of frames
+//the TWAI controller itself dropped comes straight from the driver (counted since the driver
+//was last installed, resetStats() doesn't touch it)
+void ESP32CAN::getStats(CAN_DRIVER_STATS &out)
+{
+    twai_status_info_t status_info;
+
+    out = stats;
+    out.rxCapacity = rxRing.capacity();
+    out.callbackCapacity = BI_CALLBACK_BUFFER_SIZE;
+    if (driverInstalled && twai_get_status_info(&status_info) == ESP_OK)
+        out.hardwareOverruns = status_info.rx_missed_count;
+}
+
+void ESP32CAN::resetStats()
+{
+    canStatsClear(stats);
+}
+
+//Per-ID statistics are taken before the software filters, of every frame the TWAI acceptance
+//filter lets through. To profile the whole bus turn hardware filtering off for the time being
+//(setHardwareFiltering(false) and commitFilters()): the RX task then sees every frame.
+void ESP32CAN::setIdProfiling(bool state)
+{
+    idProfiling = state;
+}
+
+//The tap sees every frame the TWAI acceptance filter lets through, including those the software
+//filters then drop; with hardware filtering off that is the whole bus. It runs in
+//task_LowLevelRX for each of them: keep it short and don't block.
+void ESP32CAN::setRawTap(void (*tap)(const CAN_FRAME &frame))
+{
+    rawTap.store(tap);
+}
+
+//Copies up to max profiled IDs into out, in no particular order, and returns how many.
+//untracked receives the number of frames whose ID found the table full
+int ESP32CAN::getIdProfile(CAN_ID_PROFILE *out, int max, uint32_t *untracked)
+{
+    if (untracked) *untracked = idProfiler.untracked();
+    return idProfiler.snapshot(out, max);
+}
+
+//The RX task empties the table before it records the next frame
+void ESP32CAN::resetIdProfile()
+{
+    idProfiler.requestClear();
+}
@@ -41,12 +41,29 @@
 #include "esp_system.h"
 #include "esp_adc_cal.h"
 #include "driver/twai.h"
+#include "esp_timer.h"
+#include "can_ring.h"
+#include "can_filter_table.h"
+#include "twai_filter_cover.h"
+#include "can_mailbox_table.h"
+#include "can_stats.h"
+#include "can_id_profiler.h"
 
 //#define DEBUG_SETUP
 #define BI_NUM_FILTERS 32
 
 #define BI_RX_BUFFER_SIZE	64
 #define BI_TX_BUFFER_SIZE  16
+#define BI_CALLBACK_BUFFER_SIZE 16
+#define BI_CRITICAL_BUFFER_SIZE 8
+#define BI_BULK_BUFFER_SIZE 8
+
+//callback lane a filter's frames are dispatched through, see setFilterPriority()
+#define BI_PRIORITY_NORMAL   0
+#define BI_PRIORITY_CRITICAL 1
+#define BI_PRIORITY_BULK     2
+
+#define BI_DISPATCH_QUEUE 0xFFFFFFFFul //dispatch target meaning "no callback, hand to the application"
 
 typedef struct
 {
@@ -54,6 +71,8 @@ typedef struct
   uint32_t id;
   bool extended;
   bool configured;
+  uint8_t priority;
+  bool inlineCallback;
 } ESP32_FILTER;
 
 typedef struct
@@ -84,25 +103,85 @@ public:
   void setRXBufferSize(int newSize);
   uint16_t available(); //like rx_avail but returns the number of waiting frames
   uint32_t get_rx_buff(CAN_FRAME &msg);
-  bool processFrame(twai_message_t &frame);
+  size_t readBatch(CAN_FRAME *out, size_t max, size_t *waiting = NULL); //copies out up to max frames at once
+  CAN_FRAME *peekFrame(); //oldest received frame in place, NULL if none. Pair with releaseFrame()
+  void releaseFrame();
+  void setMailboxMode(bool state); //keep only the newest frame per filter instead of queueing
+  bool readLatest(uint32_t id, bool extended, CAN_FRAME &msg, uint32_t *coalesced = NULL);
+  bool processFrame(twai_message_t &frame, int64_t rxTime); //rxTime in esp_timer microseconds
   void sendCallback(CAN_FRAME *frame);
 
   void setCANPins(gpio_num_t rxPin, gpio_num_t txPin);
+  void setHardwareFiltering(bool state); //derive the TWAI acceptance filter from our filters (default on)
+  void commitFilters(); //reinstall the driver once if filter changes since begin() need a new TWAI filter
+  void setFilterPriority(uint8_t mailbox, uint8_t priority); //BI_PRIORITY_xxx, normal by default
+  void setInlineCallback(uint8_t mailbox, bool state); //run this filter's callback in task_LowLevelRX
+  void getStats(CAN_DRIVER_STATS &out);
+  void resetStats();
+  void setIdProfiling(bool state); //keep per-ID traffic statistics of every received frame (default off)
+  int getIdProfile(CAN_ID_PROFILE *out, int max, uint32_t *untracked = NULL);
+  void resetIdProfile();
+  void refreshDispatch(); //re-resolve every filter's callback target, see below
+  void setRawTap(void (*tap)(const CAN_FRAME &frame)); //called by task_LowLevelRX with every received frame, ahead of the software filters. NULL removes it
+
+  //the CAN_COMMON callback setters, each followed by refreshDispatch(). A CANListener's own
+  //attachMBHandler()/attachGeneralHandler() can't be seen from here: call refreshDispatch()
+  //after them, or the watchdog picks the change up within 200ms
+  using CAN_COMMON::setCallback;
+  void setCallback(uint8_t mailbox, void (*cb)(CAN_FRAME *));
+  void setGeneralCallback(void (*cb)(CAN_FRAME *));
+  using CAN_COMMON::attachCANInterrupt;
+  void attachCANInterrupt(void (*cb)(CAN_FRAME *));
+  void attachCANInterrupt(uint8_t mailBox, void (*cb)(CAN_FRAME *));
+  void detachCANInterrupt(uint8_t mailBox);
+  void removeCallback();
+  void removeCallback(uint8_t mailbox);
+  void removeGeneralCallback();
+  bool attachObj(CANListener *listener);
+  bool detachObj(CANListener *listener);
 
   friend void CAN_WatchDog_Builtin( void *pvParameters );
   friend void task_LowLevelRX(void *pvParameters);
+  friend void task_CAN(void *pvParameters);
 
 protected:
   bool initializedResources;
   bool readyForTraffic;
+  bool driverInstalled;
+  bool hardwareFiltering;
+  bool hardwareFilterPending; //the TWAI filter changed while the driver was installed, see commitFilters()
+  bool mailboxMode;
+  bool idProfiling;
   int cyclesSinceTraffic;
 
 private:
   // Pin variables
+  void compileFilters();
+  void applyHardwareFilter();
+  uint32_t resolveDispatch(int mailbox);
+  int matchFilter(uint32_t id, bool extended);
+  void queueCallback(int mailbox, CAN_FRAME *msg);
+  bool serviceCallbacks();
+
   ESP32_FILTER filters[BI_NUM_FILTERS];
+  CANFilterTable filterTables[2]; //compiled from filters[] into the one not in use, then published
+  std::atomic<int> activeFilterTable; //index of the published table
+  std::atomic<int> filterTableUsers[2]; //lookups running on each table
+  uint32_t dispatch[BI_NUM_FILTERS]; //callback fid per filter or BI_DISPATCH_QUEUE, see refreshDispatch()
   int rxBufferSize;
+  CANMailboxTable mailboxes; //one slot per filter, only written in mailbox mode
+  CANFrameRing rxRing; //written only by task_LowLevelRX, read only by the application
+  CAN_DRIVER_STATS stats; //written only by task_LowLevelRX and the watchdog
+  TaskHandle_t callbackTask; //task_CAN, woken whenever any callback lane gets a frame
+  CANMailboxTable bulkSlots; //latest-wins overflow of the bulk lane, one slot per filter
+  std::atomic<uint32_t> bulkPending; //filters with a frame waiting in bulkSlots
+  uint32_t bulkDelivered[BI_NUM_FILTERS]; //bulkSlots write count last handed to a callback
+  CANIdProfiler idProfiler; //written only by task_LowLevelRX while idProfiling is set
+  std::atomic<void (*)(const CAN_FRAME &)> rawTap; //see setRawTap()
 };
 
 extern QueueHandle_t callbackQueue;
+extern QueueHandle_t callbackQueueCritical;
+extern QueueHandle_t callbackQueueBulk;
 
 #endif
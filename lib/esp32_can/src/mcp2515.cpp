@@ -120,6 +120,9 @@ MCP2515::MCP2515(uint8_t CS_Pin, uint8_t INT_Pin) : CAN_COMMON(6) {
   running = 0; 
   inhibitTransactions = false;
   initializedResources = false;
+  busOff = false;
+  errorPassive = false;
+  canStatsClear(stats);
 }
 
 void MCP2515::initializeResources()
@@ -128,7 +131,7 @@ void MCP2515::initializeResources()
 
   rxQueue = xQueueCreate(MCP_RX_BUFFER_SIZE, sizeof(CAN_FRAME));
   txQueue = xQueueCreate(MCP_TX_BUFFER_SIZE, sizeof(CAN_FRAME));
-  callbackQueueM15 = xQueueCreate(16, sizeof(CAN_FRAME));
+  callbackQueueM15 = xQueueCreate(MCP_CALLBACK_BUFFER_SIZE, sizeof(CAN_FRAME));
 
                             //func        desc    stack, params, priority, handle to task, core to pin to
   xTaskCreatePinnedToCore(&task_MCP15, "CAN_RX_M15", 4096, this, 3, NULL, 0);
@@ -511,6 +514,17 @@ uint32_t MCP2515::get_rx_buff(CAN_FRAME &msg)
     return GetRXFrame(msg);
 }
 
+//Only takes what was waiting when the call was made so a busy bus can't keep us here forever
+size_t MCP2515::readBatch(CAN_FRAME *out, size_t max, size_t *waiting)
+{
+    size_t pending = uxQueueMessagesWaiting(rxQueue);
+    size_t count = 0;
+    if (waiting) *waiting = pending;
+    if (pending > max) pending = max;
+    while (count < pending && xQueueReceive(rxQueue, &out[count], 0) == pdTRUE) count++;
+    return count;
+}
+
 void MCP2515::Reset() {
   if (!inhibitTransactions) SPI.beginTransaction(mcpSPISettings);
   digitalWrite(_CS,LOW);
@@ -912,6 +926,7 @@ void MCP2515::intHandler(void) {
     if((status & 1)) //RX buff 0 full
     {
       // read from RX buffer 0
+      stats.framesReceived++;
       message = ReadBuffer(RXB0);
       ctrlVal = Read(RXB0CTRL);
       handleFrameDispatch(&message, ctrlVal & 1);
@@ -919,6 +934,7 @@ void MCP2515::intHandler(void) {
     if((status & 2)) //RX buff 1 full
     {
       // read from RX buffer 1
+      stats.framesReceived++;
       message = ReadBuffer(RXB1);
       ctrlVal = Read(RXB1CTRL);
       handleFrameDispatch(&message, ctrlVal & 7);
@@ -949,6 +965,14 @@ void MCP2515::intHandler(void) {
     }
     if(interruptFlags & ERRIF) {
       //Serial.println("E");
+      uint8_t errorFlags = Read(EFLG);
+      if (errorFlags & EFLG_RX0OVR) stats.hardwareOverruns++;
+      if (errorFlags & EFLG_RX1OVR) stats.hardwareOverruns++;
+      //the chip recovers from bus-off by itself, all we can do is count how often it happened
+      if ((errorFlags & EFLG_TXBO) && !busOff) stats.busOffRecoveries++;
+      busOff = (errorFlags & EFLG_TXBO) != 0;
+      if ((errorFlags & (EFLG_TXEP | EFLG_RXEP)) && !errorPassive) stats.errorPassives++;
+      errorPassive = (errorFlags & (EFLG_TXEP | EFLG_RXEP)) != 0;
     }
     if(interruptFlags & MERRF) {
       //Serial.println("M");
@@ -965,17 +989,19 @@ void MCP2515::handleFrameDispatch(CAN_FRAME *frame, int filterHit)
 {
   CANListener *thisListener;
 
+  stats.framesAccepted++; //only frames the hardware filters let through ever get here
+
   //First, try to send a callback. If no callback registered then buffer the frame.
   if (cbCANFrame[filterHit]) 
 	{
     frame->fid = filterHit;
-    xQueueSendFromISR(callbackQueueM15, frame, 0);
+    queueCallback(frame);
     return;
 	}
 	else if (cbGeneral) 
 	{
     frame->fid = 0xFF;
-    xQueueSendFromISR(callbackQueueM15, frame, 0);
+    queueCallback(frame);
     return;
 	}
 	else
@@ -988,18 +1014,37 @@ void MCP2515::handleFrameDispatch(CAN_FRAME *frame, int filterHit)
 				if (thisListener->isCallbackActive(filterHit)) 
 				{
 					frame->fid = 0x80000000ul + (listenerPos << 24ul) + filterHit;
-          xQueueSendFromISR(callbackQueueM15, frame, 0);
+          queueCallback(frame);
           return;
 				}
 				else if (thisListener->isCallbackActive(numFilters)) //global catch-all 
 				{
 					frame->fid = 0x80000000ul + (listenerPos << 24ul) + 0xFF;
-          xQueueSendFromISR(callbackQueueM15, frame, 0);
+          queueCallback(frame);
           return;
 				}
 			}
 		}
 	} 
 	//if none of the callback types caught this frame then queue it in the buffer
-  xQueueSendFromISR(rxQueue, frame, NULL);
+  if (xQueueSendFromISR(rxQueue, frame, NULL) != pdTRUE) stats.rxDropped++;
+  else canStatsHighWater(stats.rxHighWater, uxQueueMessagesWaitingFromISR(rxQueue));
+}
+
+void MCP2515::queueCallback(CAN_FRAME *frame)
+{
+  if (xQueueSendFromISR(callbackQueueM15, frame, 0) != pdTRUE) stats.callbackDropped++;
+  else canStatsHighWater(stats.callbackHighWater, uxQueueMessagesWaitingFromISR(callbackQueueM15));
+}
+
+void MCP2515::getStats(CAN_DRIVER_STATS &out)
+{
+  out = stats;
+  out.rxCapacity = MCP_RX_BUFFER_SIZE;
+  out.callbackCapacity = MCP_CALLBACK_BUFFER_SIZE;
+}
+
+void MCP2515::resetStats()
+{
+  canStatsClear(stats);
 }
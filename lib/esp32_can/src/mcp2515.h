@@ -34,11 +34,13 @@
 #include "Arduino.h"
 #include "mcp2515_defs.h"
 #include <can_common.h>
+#include "can_stats.h"
 
 //#define DEBUG_SETUP
 
 #define MCP_RX_BUFFER_SIZE	32
 #define MCP_TX_BUFFER_SIZE  16
+#define MCP_CALLBACK_BUFFER_SIZE 16
 
 class MCP2515 : public CAN_COMMON
 {
@@ -63,6 +65,7 @@ class MCP2515 : public CAN_COMMON
 	bool rx_avail();
 	uint16_t available(); //like rx_avail but returns the number of waiting frames
 	uint32_t get_rx_buff(CAN_FRAME &msg);
+	size_t readBatch(CAN_FRAME *out, size_t max, size_t *waiting = NULL); //copies out up to max frames at once
 	
 	// Basic MCP2515 SPI Command Set
     void Reset();
@@ -94,9 +97,12 @@ class MCP2515 : public CAN_COMMON
 
 	void InitFilters(bool permissive);
 	void intHandler();
+	void getStats(CAN_DRIVER_STATS &out);
+	void resetStats();
   private:
 	bool _init(uint32_t baud, uint8_t freq, uint8_t sjw, bool autoBaud);
     void handleFrameDispatch(CAN_FRAME *frame, int filterHit);
+    void queueCallback(CAN_FRAME *frame);
     void initializeResources();
     // Pin variables
 	uint8_t _CS;
@@ -108,6 +114,9 @@ class MCP2515 : public CAN_COMMON
 	volatile uint8_t running; //1 if out of init code, 0 if still trying to initialize (auto baud detecting)
 	volatile bool inhibitTransactions;
     bool initializedResources;
+    bool busOff; //last TXBO state seen, so a bus-off is only counted once
+    bool errorPassive; //same for TXEP/RXEP
+    CAN_DRIVER_STATS stats; //written only from intHandler
     // Definitions for software buffers
 };
 
@@ -61,6 +61,13 @@
 #define WAKIF			0x40
 #define MERRF			0x80
 
+// EFLG bits
+#define EFLG_RX1OVR		0x80
+#define EFLG_RX0OVR		0x40
+#define EFLG_TXBO		0x20
+#define EFLG_TXEP		0x10
+#define EFLG_RXEP		0x08
+
 // Configuration Registers
 #define CANSTAT         0x0E
 #define CANCTRL         0x0F
@@ -71,6 +71,7 @@ void MCP2517FD::resetHardware()
         printf("Diag0: %x\n     Diag1: %x     ErrFlgs: %x", getCIBDIAG0(), cachedDiag1, getErrorFlags());
     }
     cachedDiag1 = 0;
+    stats.hardwareResets++;
 
     for (idx = 0; idx < 32; idx++)
     {
@@ -179,6 +180,7 @@ MCP2517FD::MCP2517FD(uint8_t CS_Pin, uint8_t INT_Pin) : CAN_COMMON(32) {
     txBufferSize = FD_TX_BUFFER_SIZE;
     rxBufferSize = FD_RX_BUFFER_SIZE;
     initializedResources = false;
+    canStatsClear(stats);
 }
 
 void MCP2517FD::setRXBufferSize(int newSize)
@@ -212,14 +214,14 @@ void MCP2517FD::initializeResources()
         rxQueue = xQueueCreate(rxBufferSize, sizeof(CAN_FRAME_FD));
         txQueue = xQueueCreate(txBufferSize, sizeof(CAN_FRAME_FD));
         //as in the ESP32-Builtin CAN we create a queue and task to do callbacks outside the interrupt handler
-        callbackQueueMCP = xQueueCreate(16, sizeof(CAN_FRAME_FD));
+        callbackQueueMCP = xQueueCreate(FD_CALLBACK_BUFFER_SIZE, sizeof(CAN_FRAME_FD));
     }
     else
     {
         rxQueue = xQueueCreate(rxBufferSize, sizeof(CAN_FRAME));
         txQueue = xQueueCreate(txBufferSize, sizeof(CAN_FRAME));
         //as in the ESP32-Builtin CAN we create a queue and task to do callbacks outside the interrupt handler
-        callbackQueueMCP = xQueueCreate(16, sizeof(CAN_FRAME));
+        callbackQueueMCP = xQueueCreate(FD_CALLBACK_BUFFER_SIZE, sizeof(CAN_FRAME));
     }
     if (debuggingMode) Serial.println("Initialized queues");
 
@@ -874,6 +876,17 @@ uint32_t MCP2517FD::get_rx_buff(CAN_FRAME &msg)
     return ret;
 }
 
+//Only takes what was waiting when the call was made so a busy bus can't keep us here forever
+size_t MCP2517FD::readBatch(CAN_FRAME *out, size_t max, size_t *waiting)
+{
+    size_t pending = available();
+    size_t count = 0;
+    if (waiting) *waiting = pending;
+    if (pending > max) pending = max;
+    while (count < pending && GetRXFrame(out[count])) count++;
+    return count;
+}
+
 uint32_t MCP2517FD::get_rx_buffFD(CAN_FRAME_FD &msg)
 {
     return GetRXFrame(msg);
@@ -1348,6 +1361,7 @@ void MCP2517FD::intHandler(void) {
             filtHit = ReadFrameBuffer(addr + 0x400, messageFD); //stupidly the returned address from FIFOUA needs an offset
             Write8(ADDR_CiFIFOCON + (CiFIFO_OFFSET * 1) + 1, 1); //set UINC (it's at bit 8 in the register so we move one byte into register and write 8 bits)
             status = Read( ADDR_CiFIFOSTA + (CiFIFO_OFFSET * 1) ); //read the register again to see if there are more frames waiting
+            stats.framesReceived++;
             if (inFDMode)
                 handleFrameDispatch(messageFD, filtHit);
             else
@@ -1361,6 +1375,8 @@ void MCP2517FD::intHandler(void) {
     {
         //once again, we know which FIFO must have overflowed - what to do about it though?
         errorFlags |= 1;
+        stats.hardwareOverruns++;
+        Write8(ADDR_CiFIFOSTA + (CiFIFO_OFFSET * 1), 0); //clear RXOVIF so the next overflow gets counted again
     }
     if (interruptFlags & (1 << 12)) //System error
     {
@@ -1405,6 +1421,10 @@ void MCP2517FD::intHandler(void) {
         if (diagBits & 0x800000) //23 - TXBOERR - device went bus-off (and auto recovered)
         {
             //it's OK if it goes bus off and tries to recover. Don't reset as we might mess up the bus if we're insane
+            stats.busOffRecoveries++;
+            //only clear TXBOERR so this bus-off isn't counted again. Read back first: the low half
+            //is the error free message counter, writing ones there would corrupt it
+            Write(ADDR_CiBDIAG1, Read(ADDR_CiBDIAG1) & ~0x800000ul);
         }
         if (diagBits & 0x40000000) //30 - ESI of RX FD message was set
         {
@@ -1566,17 +1586,19 @@ void MCP2517FD::handleFrameDispatch(CAN_FRAME_FD &frame, int filterHit)
 {
     CANListener *thisListener;
 
+    stats.framesAccepted++; //the hardware filters already threw away everything else
+
     //First, try to send a callback. If no callback registered then buffer the frame.
     if (cbCANFrame[filterHit]) 
     {
         frame.fid = filterHit;
-        xQueueSend(callbackQueueMCP, &frame, 0);
+        queueCallback(&frame);
         return;
     }
     else if (cbGeneral)
     {
         frame.fid = 0xFF;
-        xQueueSend(callbackQueueMCP, &frame, 0);
+        queueCallback(&frame);
         return;
     }
     else
@@ -1589,37 +1611,39 @@ void MCP2517FD::handleFrameDispatch(CAN_FRAME_FD &frame, int filterHit)
                 if (thisListener->isCallbackActive(filterHit))
                 {
                     frame.fid = 0x80000000ul + (listenerPos << 24ul) + filterHit;
-                    xQueueSend(callbackQueueMCP, &frame, 0);
+                    queueCallback(&frame);
                     return;
                 }
                 else if (thisListener->isCallbackActive(numFilters)) //global catch-all
                 {
                     frame.fid = 0x80000000ul + (listenerPos << 24ul) + 0xFF;
-                    xQueueSend(callbackQueueMCP, &frame, 0);
+                    queueCallback(&frame);
                     return;
                 }
             }
         }
     }
     //if none of the callback types caught this frame then queue it in the buffer
-    xQueueSend(rxQueue, &frame, 0);
+    queueRX(&frame);
 }
 
 void MCP2517FD::handleFrameDispatch(CAN_FRAME &frame, int filterHit)
 {
     CANListener *thisListener;
 
+    stats.framesAccepted++; //the hardware filters already threw away everything else
+
     //First, try to send a callback. If no callback registered then buffer the frame.
     if (cbCANFrame[filterHit]) 
     {
         frame.fid = filterHit;
-        xQueueSend(callbackQueueMCP, &frame, 0);
+        queueCallback(&frame);
         return;
     }
     else if (cbGeneral)
     {
         frame.fid = 0xFF;
-        xQueueSend(callbackQueueMCP, &frame, 0);
+        queueCallback(&frame);
         return;
     }
     else
@@ -1632,18 +1656,44 @@ void MCP2517FD::handleFrameDispatch(CAN_FRAME &frame, int filterHit)
                 if (thisListener->isCallbackActive(filterHit))
                 {
                     frame.fid = 0x80000000ul + (listenerPos << 24ul) + filterHit;
-                    xQueueSend(callbackQueueMCP, &frame, 0);
+                    queueCallback(&frame);
                     return;
                 }
                 else if (thisListener->isCallbackActive(numFilters)) //global catch-all
                 {
                     frame.fid = 0x80000000ul + (listenerPos << 24ul) + 0xFF;
-                    xQueueSend(callbackQueueMCP, &frame, 0);
+                    queueCallback(&frame);
                     return;
                 }
             }
         }
     }
     //if none of the callback types caught this frame then queue it in the buffer
-    xQueueSend(rxQueue, &frame, 0);
+    queueRX(&frame);
+}
+
+//Both frame types go through here so drops and high-water marks are counted in one place.
+//The queues were created for whichever frame type matches inFDMode
+void MCP2517FD::queueCallback(const void *frame)
+{
+    if (xQueueSend(callbackQueueMCP, frame, 0) != pdTRUE) stats.callbackDropped++;
+    else canStatsHighWater(stats.callbackHighWater, uxQueueMessagesWaiting(callbackQueueMCP));
+}
+
+void MCP2517FD::queueRX(const void *frame)
+{
+    if (xQueueSend(rxQueue, frame, 0) != pdTRUE) stats.rxDropped++;
+    else canStatsHighWater(stats.rxHighWater, uxQueueMessagesWaiting(rxQueue));
+}
+
+void MCP2517FD::getStats(CAN_DRIVER_STATS &out)
+{
+    out = stats;
+    out.rxCapacity = rxBufferSize;
+    out.callbackCapacity = FD_CALLBACK_BUFFER_SIZE;
+}
+
+void MCP2517FD::resetStats()
+{
+    canStatsClear(stats);
 }
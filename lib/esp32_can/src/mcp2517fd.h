@@ -4,10 +4,12 @@
 #include "Arduino.h"
 #include "mcp2517fd_defines.h"
 #include <can_common.h>
+#include "can_stats.h"
 
 //#define DEBUG_SETUP
 #define FD_RX_BUFFER_SIZE	64
 #define FD_TX_BUFFER_SIZE  32
+#define FD_CALLBACK_BUFFER_SIZE 16
 #define FD_NUM_FILTERS 32
 
 class MCP2517FD : public CAN_COMMON
@@ -35,6 +37,7 @@ class MCP2517FD : public CAN_COMMON
 	bool rx_avail();
 	uint16_t available(); //like rx_avail but returns the number of waiting frames
 	uint32_t get_rx_buff(CAN_FRAME &msg);
+	size_t readBatch(CAN_FRAME *out, size_t max, size_t *waiting = NULL); //copies out up to max frames at once
 	//special FD functions required to reimplement to support FD mode
 	uint32_t get_rx_buffFD(CAN_FRAME_FD &msg);
     uint32_t set_baudrateFD(uint32_t nominalSpeed, uint32_t dataSpeed);
@@ -81,6 +84,8 @@ class MCP2517FD : public CAN_COMMON
 	void txQueueSetup();
     void setRXBufferSize(int newSize);
     void setTXBufferSize(int newSize);
+	void getStats(CAN_DRIVER_STATS &out);
+	void resetStats();
 
     QueueHandle_t callbackQueueMCP;
     TaskHandle_t intTaskFD = NULL;
@@ -97,6 +102,8 @@ class MCP2517FD : public CAN_COMMON
 	void commonInit();	
     void handleFrameDispatch(CAN_FRAME_FD &frame, int filterHit);
     void handleFrameDispatch(CAN_FRAME &frame, int filterHit);
+	void queueCallback(const void *frame);
+	void queueRX(const void *frame);
 	void handleTXFifoISR(int fifo);
 	void handleTXFifo(int fifo, CAN_FRAME_FD &newFrame);
 	void handleTXFifo(int fifo, CAN_FRAME &newFrame);
@@ -122,6 +129,7 @@ class MCP2517FD : public CAN_COMMON
 	QueueHandle_t	txQueue;
 	uint32_t errorFlags;
     uint32_t cachedDiag1;
+    CAN_DRIVER_STATS stats; //written only from intHandler and resetHardware
 };
 
 extern MCP2517FD CAN1;
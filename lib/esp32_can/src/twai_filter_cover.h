@@ -0,0 +1,205 @@
+/*
+  twai_filter_cover.h - Derive a TWAI hardware acceptance filter from software filters
+
+  The TWAI controller has one 32 bit acceptance code/mask pair that is either used as a
+  single filter or split into two filters. Mask bits set to 1 are "don't care". The bits
+  are laid out like this (see the ESP-IDF TWAI documentation):
+
+  single filter   extended  [31:3] ID28-0   [2] RTR
+                  standard  [31:21] ID10-0  [20] RTR   [15:8] data byte 0  [7:0] data byte 1
+  dual filter     extended  filter 1 [31:16] ID28-13   filter 2 [15:0] ID28-13
+                  standard  filter 1 [31:21] ID10-0 [20] RTR [19:16]+[3:0] data byte 0
+                            filter 2 [15:5] ID10-0 [4] RTR
+
+  twaiCoverFilters() finds the tightest code/mask (single or dual) that still accepts every
+  frame the software filters accept. It can only ever be looser than the software filters,
+  which still run on every frame that gets through.
+
+  twaiFilterAccepts() models what the controller does with a frame so the result can be
+  checked off-device against recorded captures.
+*/
+
+#ifndef __TWAI_FILTER_COVER__
+#define __TWAI_FILTER_COVER__
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t acceptance_code;
+    uint32_t acceptance_mask;
+    bool single_filter;
+} TWAI_FILTER_COVER;
+
+#define TWAI_COVER_ACCEPT_ALL {0, 0xFFFFFFFFul, true}
+
+//a code/mask pair under construction. care has a 1 for every bit that must match code
+typedef struct
+{
+    uint32_t code;
+    uint32_t care;
+    bool empty;
+} TWAI_COVER_TERM;
+
+static inline void twaiCoverMerge(TWAI_COVER_TERM &term, uint32_t code, uint32_t care)
+{
+    if (term.empty)
+    {
+        term.code = code & care;
+        term.care = care;
+        term.empty = false;
+        return;
+    }
+    term.care &= care & ~(term.code ^ code);
+    term.code &= term.care;
+}
+
+static inline int twaiCoverFreeBits(uint32_t care, uint32_t idBits)
+{
+    int n = 0;
+    for (uint32_t b = idBits & ~care; b; b &= b - 1) n++;
+    return n;
+}
+
+//Fraction of the identifier space a dual filter setup lets through, in units of 2^-idWidth.
+//Overlap between the two halves is ignored, which only makes dual mode look worse.
+static inline double twaiCoverDualScore(const TWAI_COVER_TERM &a, const TWAI_COVER_TERM &b, uint32_t idBits)
+{
+    double s = 0;
+    if (!a.empty) s += (double)(1ul << twaiCoverFreeBits(a.care, idBits));
+    if (!b.empty) s += (double)(1ul << twaiCoverFreeBits(b.care, idBits));
+    return s;
+}
+
+//ids/masks/extended describe count software filters. Returns false (and accept all) if
+//nothing useful can be done, e.g. no filters at all or a filter that already accepts all.
+static bool twaiCoverFilters(const uint32_t *ids, const uint32_t *masks, const bool *extended,
+                             int count, TWAI_FILTER_COVER &out)
+{
+    TWAI_FILTER_COVER all = TWAI_COVER_ACCEPT_ALL;
+    out = all;
+    if (count <= 0) return false;
+
+    bool anyStd = false, anyExt = false;
+    for (int i = 0; i < count; i++)
+    {
+        if (extended[i]) anyExt = true;
+        else anyStd = true;
+    }
+
+    //single filter: both frame formats are compared against the same 32 bits, so mixing
+    //them is fine, we just end up caring only about bits every filter cares about
+    TWAI_COVER_TERM single = {0, 0, true};
+    for (int i = 0; i < count; i++)
+    {
+        if (extended[i]) twaiCoverMerge(single, ids[i] << 3, (masks[i] & 0x1FFFFFFFul) << 3);
+        else twaiCoverMerge(single, ids[i] << 21, (masks[i] & 0x7FFul) << 21);
+    }
+    if (single.care == 0) return false;
+
+    uint32_t idBits = anyExt ? 0xFFFFFFF8ul : 0xFFE00000ul;
+    double bestScore = (double)(1ul << twaiCoverFreeBits(single.care, idBits)) / (anyExt ? (double)(1ul << 13) : 1.0);
+    out.acceptance_code = single.code;
+    out.acceptance_mask = ~single.care;
+    out.single_filter = true;
+
+    //dual filter: only when every filter uses the same format. Ext dual filters only see
+    //ID28-13 (16 bits) so the score is in the same units as the single filter divided by 2^13.
+    if (count < 2 || (anyExt && anyStd)) return true;
+
+    uint32_t dualBits = anyExt ? 0xFFFFul : 0xFFE0ul;
+    uint32_t dualCode[32], dualCare[32];
+    int n = count > 32 ? 32 : count;
+    for (int i = 0; i < n; i++)
+    {
+        if (anyExt)
+        {
+            dualCode[i] = ids[i] >> 13;
+            dualCare[i] = (masks[i] & 0x1FFFFFFFul) >> 13;
+        }
+        else
+        {
+            dualCode[i] = (ids[i] & 0x7FF) << 5;
+            dualCare[i] = (masks[i] & 0x7FF) << 5;
+        }
+    }
+
+    //greedy split: seed the two halves with every pair of filters in turn, then put each
+    //remaining filter in whichever half grows less
+    for (int a = 0; a < n; a++)
+    {
+        for (int b = a + 1; b < n; b++)
+        {
+            TWAI_COVER_TERM f1 = {0, 0, true}, f2 = {0, 0, true};
+            twaiCoverMerge(f1, dualCode[a], dualCare[a]);
+            twaiCoverMerge(f2, dualCode[b], dualCare[b]);
+            for (int i = 0; i < n; i++)
+            {
+                if (i == a || i == b) continue;
+                TWAI_COVER_TERM t1 = f1, t2 = f2;
+                twaiCoverMerge(t1, dualCode[i], dualCare[i]);
+                twaiCoverMerge(t2, dualCode[i], dualCare[i]);
+                if (twaiCoverDualScore(t1, f2, dualBits) <= twaiCoverDualScore(f1, t2, dualBits)) f1 = t1;
+                else f2 = t2;
+            }
+            double score = twaiCoverDualScore(f1, f2, dualBits);
+            if (score < bestScore)
+            {
+                bestScore = score;
+                out.single_filter = false;
+                if (anyExt)
+                {
+                    out.acceptance_code = (f1.code << 16) | f2.code;
+                    out.acceptance_mask = (~f1.care << 16) | (~f2.care & 0xFFFFul);
+                }
+                else
+                {
+                    //filter 1: ID [31:21], RTR and data nibbles don't care
+                    //filter 2: ID [15:5], RTR don't care
+                    out.acceptance_code = (f1.code << 16) | f2.code;
+                    out.acceptance_mask = (~(f1.care << 16) & 0xFFFF0000ul) | (~f2.care & 0xFFFFul);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static inline bool twaiMaskedMatch(uint32_t value, uint32_t code, uint32_t mask)
+{
+    return ((value ^ code) & ~mask) == 0;
+}
+
+//what the controller does with a received frame given this filter configuration
+static inline bool twaiFilterAccepts(const TWAI_FILTER_COVER &f, uint32_t id, bool extended, bool rtr,
+                                     uint8_t length, const uint8_t *data)
+{
+    uint8_t d0 = length > 0 ? data[0] : 0;
+    uint8_t d1 = length > 1 ? data[1] : 0;
+    uint32_t dataMask = 0; //data bytes the frame doesn't have always pass
+    if (length < 1) dataMask |= 0xFF00;
+    if (length < 2) dataMask |= 0x00FF;
+
+    if (f.single_filter)
+    {
+        if (extended)
+            return twaiMaskedMatch((id << 3) | (rtr ? 4 : 0), f.acceptance_code, f.acceptance_mask | 3);
+        return twaiMaskedMatch((id << 21) | (rtr ? (1ul << 20) : 0) | ((uint32_t)d0 << 8) | d1,
+                               f.acceptance_code, f.acceptance_mask | 0xF0000ul | dataMask);
+    }
+
+    if (extended)
+    {
+        uint32_t upper = (id >> 13) & 0xFFFF;
+        return twaiMaskedMatch(upper << 16, f.acceptance_code & 0xFFFF0000ul, f.acceptance_mask | 0xFFFF)
+            || twaiMaskedMatch(upper, f.acceptance_code & 0xFFFF, f.acceptance_mask | 0xFFFF0000ul);
+    }
+
+    uint32_t d0Mask = length < 1 ? 0xF000Ful : 0;
+    uint32_t f1 = (id << 21) | (rtr ? (1ul << 20) : 0) | ((uint32_t)(d0 >> 4) << 16) | (d0 & 0xF);
+    uint32_t f2 = ((id & 0x7FF) << 5) | (rtr ? 0x10 : 0);
+    return twaiMaskedMatch(f1, f.acceptance_code, f.acceptance_mask | 0xFFF0ul | d0Mask)
+        || twaiMaskedMatch(f2, f.acceptance_code & 0xFFFF, (f.acceptance_mask & 0xFFFF) | 0xFFFF000Ful);
+}
+
+#endif
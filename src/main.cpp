@@ -44,6 +44,11 @@ char l[VALUE_COUNT][20];
 #define FONT_LARGE u8g2_font_logisoso38_tf
 #define FONT_BODY u8g2_font_logisoso16_tf
 
+// - Screens, as keys for the refresh scheduler
+#define SCREEN_KEY_HOME 1000  // + 32 x the layout + the value chosen in DISPLAY
+#define SCREEN_KEY_SPLASH 2000
+#define SCREEN_KEY_MENU 3000  // + the menu item shown
+
 // - KY040 knob values
 #define KNOB_MODE_MENU 0
 #define KNOB_MODE_TESTRPM 1
@@ -81,6 +86,9 @@ int WS2812_EXTRAPIXEL_1 = WS2812_NUMPIXELS + 1;            // optional
 int WS2812_EXTRAPIXEL_2 = WS2812_NUMPIXELS + 2;            // optional
 int WS2812_EXTRAPIXEL_3 = WS2812_NUMPIXELS + 3;            // optional
 
+// - SN65HVD230 CAN Bus values
+size_t canPeakBacklog = 0;     // most frames found waiting in the driver at once
+
 // TODO: add global variables here
 int addr = 0;
 int currentDisplay = 0;
@@ -166,28 +174,78 @@ void SSD1306_ShowSplashScreen()
   u8g2.drawStr(0, 32, s);
   sprintf(s, "Ver:%s", VERSION);
   u8g2.drawStr(0, 62, s);
-  u8g2.sendBuffer();
+  displaySend();
 }
 
-void SSD1306_ShowDefaultScreen()
+// One cell of the home screen layout, drawn over its cleared bounding box
+void SSD1306_DrawCell(const LayoutCell &cell)
 {
   char s[20];
+  int slot = layoutSlot(cell);
 
-  u8g2.clearBuffer();
+  u8g2.setDrawColor(0);
+  u8g2.drawBox(cell.x, cell.y, cell.w, cell.h);
+  u8g2.setDrawColor(1);
 
-  u8g2.setFont(FONT_HEADER);
-  sprintf(s, "%s", l[v[CURRENT_DISPLAY]]);
-  u8g2.drawStr(0, 16, s);
+  switch (cell.widget)
+  {
+  case WIDGET_LARGE:
+    u8g2.setFont(FONT_HEADER);
+    u8g2.drawStr(cell.x, cell.y + 16, l[slot]);
+    sprintf(s, "%d", v[slot]);
+    displayDrawLarge(cell.x, cell.y + cell.h - 1, s);
+    break;
+
+  case WIDGET_NUMBER:
+    u8g2.setFont(u8g2_font_profont12_mf);
+    snprintf(s, cell.w / 6 + 1, "%s", l[slot]); // as much of the label as fits, 6 pixels a character
+    u8g2.drawStr(cell.x, cell.y + 9, s);
+    u8g2.setFont(FONT_BODY);
+    sprintf(s, "%d", v[slot]);
+    u8g2.drawStr(cell.x, cell.y + cell.h - 1, s);
+    break;
+
+  case WIDGET_LARGE_NUMBER:
+    sprintf(s, "%d", v[slot]);
+    displayDrawLarge(cell.x, cell.y + cell.h - 1, s);
+    break;
+
+  case WIDGET_BAR:
+  {
+    int low = v[VALUE_MINRPM], high = v[PARAM_MAXRPM];
+    int value = v[slot] < low ? low : (v[slot] > high ? high : v[slot]);
+    int fill = high > low ? (int)((long)(value - low) * (cell.w - 4) / (high - low)) : 0;
+    u8g2.drawFrame(cell.x, cell.y + 4, cell.w, cell.h - 8);
+    if (fill > 0)
+      u8g2.drawBox(cell.x + 2, cell.y + 6, fill, cell.h - 12);
+    break;
+  }
 
-  u8g2.setFont(FONT_LARGE);
-  sprintf(s, "%d", v[v[CURRENT_DISPLAY]]);
-  u8g2.drawStr(0, 63, s);
+  default:
+    break;
+  }
+}
+
+// The home screen in the layout chosen from the DISPLAY menu. With onlyChanged just the
+// cells of the values the refresh scheduler found changed are redrawn, over the previous
+// frame still in the buffer
+void SSD1306_ShowDefaultScreen(bool onlyChanged)
+{
+  const Layout &layout = layoutCurrent();
+
+  if (!onlyChanged)
+    u8g2.clearBuffer();
+  for (int i = 0; i < layout.cellCount; i++)
+    if (!onlyChanged || refreshSignalDirty(i))
+      SSD1306_DrawCell(layout.cells[i]);
 
-  u8g2.sendBuffer();
+  displaySend();
 }
 
 void printFrame(CAN_FRAME *message)
 {
+  Serial.print(message->timestamp);
+  Serial.print(" ");
   Serial.print(message->id, HEX);
   if (message->extended) Serial.print(" X ");
   else Serial.print(" S ");   
@@ -212,6 +270,9 @@ void sensorSetup()
 {
   // - SSD1306 I2C OLED DISPLAY
     u8g2.begin();
+    displayInvalidate();
+    displaySetup();
+    displayGlyphsSetup(FONT_LARGE);
     SSD1306_ShowSplashScreen();
   
   // - KY040 ROTARY ENCODER
@@ -226,13 +287,23 @@ void sensorSetup()
     strip.begin();
     strip.setBrightness(v[v[CURRENT_BRIGHTNESS]]);
     strip.show(); // Initialize all pixels to 'off'
+    shiftLightSetup();
+
+  // - Post-mortem bus recorder, before the CAN module so its raw tap is in from the first frame
+    if (BUS_RECORDER)
+      recorderSetup();
 
   // - Internal ESP32 CAN module
     CAN0.setCANPins(GPIO_NUM_4, GPIO_NUM_5);
     CAN0.setListenOnlyMode(true);
+    CAN0.setMailboxMode(CAN_MAILBOX_MODE);
+    CAN0.setHardwareFiltering(!recorderNeedsWholeBus()); // see RECORDER_WHOLE_BUS
     CAN0.begin(CAN_BPS_500K);
-    // set filter here
-    CAN0.watchFor();
+    if (CAN_WATCH_ALL)
+      CAN0.watchFor();
+    else
+      CAN0.watchFor(FRAME_ID_ENGINE_SPEED_HEX); // the TWAI hardware filter is derived from these
+    CAN0.commitFilters(); // one driver reinstall for all the filters above
 }
 
 // ------------------------------------------------------------------------------------------
@@ -267,6 +338,19 @@ void sensorUpdateReadings()
     sprintf(s, "Light level=%d", v[CURRENT_LIGHTLEVEL]);
     log_out("LIGHTLVL", s);
   }
+
+  if (SENSOR_SN65HVD230) // - CAN Bus receive backlog
+  {
+    char s[80];
+    CAN_DRIVER_STATS stats;
+    CAN0.getStats(stats);
+    sprintf(s, "Peak RX backlog=%u frames, dropped=%u", (unsigned int)canPeakBacklog,
+            (unsigned int)(stats.rxDropped + stats.callbackDropped));
+    log_out(STR_SN65HVD230_LOG_PREFIX, s);
+
+    if (BUS_RECORDER)
+      recorderCheckBusErrors(stats);
+  }
 }
 
 void LogCurrentMenuItem()
@@ -288,11 +372,11 @@ void SaveCurrentValue(int m)
     switch (mi[m].intValueCurrent)
     {
     case MENU_VALUE_SHOW_INFO:
-      SSD1306_ShowSplashScreen();
+      ON_SPLASH_SCREEN = true; // drawn by the refresh scheduler
       break;
     case MENU_VALUE_SHOW_HOME:
       ON_SPLASH_SCREEN = false;
-      SSD1306_ShowDefaultScreen();
+      SSD1306_ShowDefaultScreen(false);
       break;
     }
   }
@@ -313,7 +397,120 @@ void SaveCurrentValue(int m)
 
     ON_SPLASH_SCREEN = false;
     SSD1306_ResetTimeout();
-    sensorUpdateDisplay();
+  }
+}
+
+// Decode a single frame received from the CAN bus
+void sensorHandleFrame(CAN_FRAME &can_message)
+{
+#if DEBUG
+  Serial.print(can_message.timestamp); // microseconds since boot, stamped by the driver on receive
+  Serial.print(" CAN MSG: 0x");
+  Serial.print(can_message.id, HEX);
+  Serial.print(" [");
+  Serial.print(can_message.length, DEC);
+  Serial.print("] <");
+  for (int i = 0; i < can_message.length; i++)
+  {
+    if (i != 0)
+      Serial.print(":");
+    Serial.print(can_message.data.byte[i], HEX);
+  }
+  Serial.println(">");
+#else
+  // every signal of signals.h carried by this frame goes straight into v[]
+  if (canDecodeFrame(canSignals, CAN_SIGNAL_COUNT, can_message, v) > 0 &&
+      LATENCY_INSTRUMENTATION && can_message.id == FRAME_ID_ENGINE_SPEED_DEC)
+    latencyEngineSpeedUpdated(can_message.timestamp);
+#endif
+}
+
+// Receive path counters of the CAN driver, used to size its buffers
+void sensorPrintCANStats()
+{
+  CAN_DRIVER_STATS stats;
+  char s[80];
+
+  CAN0.getStats(stats);
+  sprintf(s, "received %u accepted %u filter misses %u", (unsigned int)stats.framesReceived,
+          (unsigned int)stats.framesAccepted, (unsigned int)stats.filterMisses);
+  Serial.println(s);
+  sprintf(s, "rx queue peak %u/%u dropped %u", (unsigned int)stats.rxHighWater, (unsigned int)stats.rxCapacity,
+          (unsigned int)stats.rxDropped);
+  Serial.println(s);
+  sprintf(s, "callback queue peak %u/%u dropped %u", (unsigned int)stats.callbackHighWater,
+          (unsigned int)stats.callbackCapacity, (unsigned int)stats.callbackDropped);
+  Serial.println(s);
+  sprintf(s, "critical dropped %u bulk coalesced %u inline %u", (unsigned int)stats.criticalDropped,
+          (unsigned int)stats.callbackCoalesced, (unsigned int)stats.callbacksInline);
+  Serial.println(s);
+  sprintf(s, "controller overruns %u resets %u", (unsigned int)stats.hardwareOverruns,
+          (unsigned int)stats.hardwareResets);
+  Serial.println(s);
+  sprintf(s, "error passive %u bus-off recoveries %u", (unsigned int)stats.errorPassives,
+          (unsigned int)stats.busOffRecoveries);
+  Serial.println(s);
+}
+
+// Diagnostics over the serial console, one character per command
+void sensorSerialCommand(char command)
+{
+  switch (command)
+  {
+  case 's': // CAN driver counters
+    sensorPrintCANStats();
+    break;
+  case 'S':
+    CAN0.resetStats();
+    Serial.println("CAN driver counters cleared");
+    break;
+  case 'l': // frame-to-photon latency histogram
+    latencyPrint();
+    break;
+  case 'L':
+    latencyReset();
+    Serial.println("Latency histogram cleared");
+    break;
+  case 'r': // bus recorder state and saved captures
+    recorderPrint();
+    break;
+  case 'R':
+    if (recorderTrigger(RECORDER_TRIGGER_MANUAL))
+      Serial.println("Recorder triggered");
+    else
+      Serial.println("Recorder off or busy");
+    break;
+  case 'd': // saved captures as hex, for tools/recdump
+    recorderDump();
+    break;
+  case 'o': // OLED bytes sent and redraws
+    displayPrint();
+    refreshPrint();
+    break;
+  case 'O':
+    displayResetStats();
+    refreshResetStats();
+    Serial.println("Display counters cleared");
+    break;
+  case 'w': // shift light show() rate
+    shiftLightPrint();
+    break;
+  case 'W':
+    shiftLightResetStats();
+    Serial.println("Shift light counters cleared");
+    break;
+  case 'p': // per-ID bus profile
+    profilerPrint();
+    break;
+  case 'b': // bus profiling on/off without the menu page
+    profilerToggle();
+    break;
+  case 'P':
+    profilerReset();
+    Serial.println("Bus profile cleared");
+    break;
+  default:
+    break;
   }
 }
 
@@ -338,10 +535,7 @@ void sensorUpdateReadingsQuick()
             currentMenu = 0; // go to top of menu
           }
           if (mi[currentMenu].setValueID != VALUE_SHOW)
-          {
-            sensorUpdateDisplay();
             LogCurrentMenuItem();
-          }
           break;
 
         case MENU_TYPE_INT:
@@ -352,7 +546,11 @@ void sensorUpdateReadingsQuick()
 
           ON_SPLASH_SCREEN = false;
           SSD1306_ResetTimeout();
-          sensorUpdateDisplay();
+          break;
+
+        case MENU_TYPE_LIST:
+          currentMenu = 0; // nothing to save, back to the top of the menu
+          SSD1306_ResetTimeout();
           break;
 
         default:
@@ -382,13 +580,17 @@ void sensorUpdateReadingsQuick()
           LogCurrentMenuItem();
           break;
 
+        case MENU_TYPE_LIST:
+          if (mi[currentMenu].intValueCurrent < mi[currentMenu].intValueMax)
+            mi[currentMenu].intValueCurrent++;
+          break;
+
         default:
           break;
         }
 
         ON_SPLASH_SCREEN = false;
         SSD1306_ResetTimeout();
-        sensorUpdateDisplay();
         KY040_STATUS_CURRENT = KY040_STATUS_IDLE;
         break;
 
@@ -412,13 +614,17 @@ void sensorUpdateReadingsQuick()
           LogCurrentMenuItem();
           break;
 
+        case MENU_TYPE_LIST:
+          if (mi[currentMenu].intValueCurrent > mi[currentMenu].intValueMin)
+            mi[currentMenu].intValueCurrent--;
+          break;
+
         default:
           break;
         }
 
         ON_SPLASH_SCREEN = false;
         SSD1306_ResetTimeout();
-        sensorUpdateDisplay();
         KY040_STATUS_CURRENT = KY040_STATUS_IDLE;
         break;
 
@@ -426,35 +632,45 @@ void sensorUpdateReadingsQuick()
         break;
       }
   
-    uint32_t color;
-
-    rangedvalue = (int)((float)(v[CURRENT_ENGINE_SPEED] * (float)WS2812_NUMPIXELS) / (float)v[PARAM_MAXRPM]);
-
-    if (v[CURRENT_ENGINE_SPEED] >= v[PARAM_MAXRPM]) // Shift pattern display
+    if (SHIFT_LIGHT_TABLE)
     {
-      strip.setBrightness(v[v[CURRENT_BRIGHTNESS]]);
-      StripFullBlink(100, color_blue);
+      shiftLightUpdate(); // show() only when the picture changes
     }
     else
     {
-      strip.setBrightness(v[v[CURRENT_BRIGHTNESS]]);
-      for (int i = 0; i < WS2812_NUMPIXELS; i++) // regular RPM display
+      uint32_t color;
+
+      rangedvalue = (int)((float)(v[CURRENT_ENGINE_SPEED] * (float)WS2812_NUMPIXELS) / (float)v[PARAM_MAXRPM]);
+
+      if (v[CURRENT_ENGINE_SPEED] >= v[PARAM_MAXRPM]) // Shift pattern display
+      {
+        strip.setBrightness(v[v[CURRENT_BRIGHTNESS]]);
+        StripFullBlink(100, color_blue);
+      }
+      else
       {
-        if (i < first_third_max)
-          color = color_green;
-        if (i >= first_third_max)
-          color = color_white;
-        if (i >= second_third_max)
-          color = color_red;
-
-        if (i <= rangedvalue)
-          strip.setPixelColor(i, color);
-        else
-          strip.setPixelColor(i, color_black);
+        strip.setBrightness(v[v[CURRENT_BRIGHTNESS]]);
+        for (int i = 0; i < WS2812_NUMPIXELS; i++) // regular RPM display
+        {
+          if (i < first_third_max)
+            color = color_green;
+          if (i >= first_third_max)
+            color = color_white;
+          if (i >= second_third_max)
+            color = color_red;
+
+          if (i <= rangedvalue)
+            strip.setPixelColor(i, color);
+          else
+            strip.setPixelColor(i, color_black);
+        }
+        if (v[CURRENT_ENGINE_SPEED] == v[VALUE_MINRPM])
+          strip.clear();
+        uint32_t showStart = micros();
+        strip.show();
+        if (LATENCY_INSTRUMENTATION)
+          latencyStripShown(showStart, micros());
       }
-      if (v[CURRENT_ENGINE_SPEED] == v[VALUE_MINRPM])
-        strip.clear();
-      strip.show();
     }
   
   // - SN65HVD230 CAN Bus module
@@ -478,31 +694,38 @@ void sensorUpdateReadingsQuick()
     // Turbocharger temperature:                   75(117)   7
     // Turbocharger temperature:                   76(118)   7
 
-    CAN_FRAME can_message;
-
-    if (CAN0.read(can_message))
+    if (CAN_MAILBOX_MODE)
     {
-#if DEBUG      
-      Serial.print("CAN MSG: 0x");
-      Serial.print(can_message.id, HEX);
-      Serial.print(" [");
-      Serial.print(can_message.length, DEC);
-      Serial.print("] <");
-      for (int i = 0; i < can_message.length; i++)
+      // Only the newest engine speed frame matters, fetch it straight from its mailbox
+      static uint32_t lastEngineSpeedWrite = 0;
+      CAN_FRAME latest;
+
+      if (CAN0.readLatest(FRAME_ID_ENGINE_SPEED_HEX, true, latest) && latest.fid != lastEngineSpeedWrite)
       {
-        if (i != 0)
-          Serial.print(":");
-        Serial.print(can_message.data.byte[i], HEX);
+        lastEngineSpeedWrite = latest.fid;
+        sensorHandleFrame(latest);
       }
-      Serial.println(">");
-#else
-      if (can_message.id == FRAME_ID_ENGINE_SPEED_DEC)
+    }
+    else
+    {
+      // Drain everything the driver has queued since the last pass, one batch at a time
+      CAN_FRAME batch[CAN_RX_BATCH];
+      size_t waiting;
+      size_t count;
+
+      do
       {
-        v[CURRENT_ENGINE_SPEED] = 256 * can_message.data.byte[2] + can_message.data.byte[3];
-      }
-#endif
+        count = CAN0.readBatch(batch, CAN_RX_BATCH, &waiting);
+        if (waiting > canPeakBacklog)
+          canPeakBacklog = waiting;
+        for (size_t i = 0; i < count; i++)
+          sensorHandleFrame(batch[i]);
+      } while (count == CAN_RX_BATCH);
     }
 
+    if (BUS_RECORDER)
+      recorderUpdate();
+
   // TODO: Perform measurements on every loop
   /* code */
 }
@@ -510,6 +733,77 @@ void sensorUpdateReadingsQuick()
 // ------------------------------------------------------------------------------------------
 // Step 6/7 - Update the local display
 // ------------------------------------------------------------------------------------------
+
+// Which screen sensorUpdateDisplay() draws now and the values it shows, for the refresh
+// scheduler. Called on every loop() pass, only declares anything when the screen changes
+void sensorDeclareScreen()
+{
+  int screen;
+
+  if (!SCREEN_ACTIVE)
+    screen = SCREEN_KEY_HOME + 32 * v[CURRENT_LAYOUT] + v[CURRENT_DISPLAY];
+  else if (ON_SPLASH_SCREEN)
+    screen = SCREEN_KEY_SPLASH;
+  else
+    screen = SCREEN_KEY_MENU + currentMenu;
+  if (screen == refreshScreen)
+    return;
+  profilerPageShown(screen == SCREEN_KEY_MENU + MENU_ITEM_BUS_PROFILE); // opens the hardware filter while shown
+
+  MenuItem &item = mi[currentMenu];
+  if (!SCREEN_ACTIVE)
+  {
+    const Layout &layout = layoutCurrent();
+    refreshBegin(screen, 0);
+    for (int i = 0; i < layout.cellCount; i++) // one signal per cell, in cell order
+      refreshWatchValue(layoutSlot(layout.cells[i]));
+  }
+  else if (ON_SPLASH_SCREEN)
+    refreshBegin(screen, 0);
+  else if (item.type == MENU_TYPE_MENU)
+  {
+    refreshBegin(screen, 0);
+    refreshWatch(&item.menuValueCurrent, 0);
+  }
+  else
+  {
+    refreshBegin(screen, item.type == MENU_TYPE_LIST ? DELAY_MS : 0); // the bus profile is live
+    refreshWatch(&item.intValueCurrent, 0);
+  }
+}
+
+// Rows of the bus profile below the header: the selected one inverted and scrolled into
+// view, its details on the last line
+void sensorDrawProfilePage(MenuItem &item)
+{
+  char s[24];
+
+  profilerRefresh();
+  item.intValueMax = profilerCount > 0 ? profilerCount - 1 : 0;
+  if (item.intValueCurrent > item.intValueMax)
+    item.intValueCurrent = item.intValueMax;
+
+  u8g2.setFont(u8g2_font_profont12_mf);
+  if (profilerCount == 0)
+  {
+    u8g2.drawStr(0, 40, "no frames yet");
+    return;
+  }
+
+  int first = item.intValueCurrent - PROFILER_PAGE_ROWS + 1;
+  if (first < 0)
+    first = 0;
+  for (int r = 0; r < PROFILER_PAGE_ROWS && first + r < profilerCount; r++)
+  {
+    profilerFormatRow(profilerRows[first + r], s);
+    u8g2.setDrawColor(first + r == item.intValueCurrent ? 0 : 1); // _mf fonts draw their background
+    u8g2.drawStr(0, 28 + r * 12, s);
+  }
+  u8g2.setDrawColor(1);
+  profilerFormatDetail(profilerRows[item.intValueCurrent], s);
+  u8g2.drawStr(0, 63, s);
+}
+
 void sensorUpdateDisplay()
 {
   if (SCREEN_ACTIVE) // update the display only if active
@@ -527,14 +821,17 @@ void sensorUpdateDisplay()
           u8g2.setFont(FONT_BODY);
           u8g2.drawStr(0, 40, mi[mi[currentMenu].m[mi[currentMenu].menuValueCurrent]].label);
         }
+        else if (mi[currentMenu].type == MENU_TYPE_LIST) // bus profile, redrawn live every DELAY_MS
+        {
+          sensorDrawProfilePage(mi[currentMenu]);
+        }
         else // display current value (RPM or MPH)
         {
-          u8g2.setFont(FONT_LARGE);
           sprintf(s, "%d", mi[currentMenu].intValueCurrent);
-          u8g2.drawStr(0, 63, s);
+          displayDrawLarge(0, 63, s);
         }
 
-        u8g2.sendBuffer();
+        displaySend();
 
       /* code */ // <-- other indicators and annunciators
     }
@@ -545,7 +842,7 @@ void sensorUpdateDisplay()
   }
   else
   {
-    SSD1306_ShowDefaultScreen();
+    SSD1306_ShowDefaultScreen(!refreshFullRedraw());
   }
 }
 
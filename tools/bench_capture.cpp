@@ -0,0 +1,167 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_capture.cpp
+//
+// Host benchmark of the binary capture format (include/can_capture.h). For every capture:
+//
+//   size      text bytes against binary bytes, and binary bytes per frame
+//   lossless  every frame decoded from the binary stream must equal the one read from the
+//             text (ID, extended, RTR, DLC, payload and timestamp)
+//
+// then the encode and decode cost in ns/frame over all captures played again and again
+// (timestamps keep counting up between passes, as a long session would), and the same long
+// stream decoded from its first key record past the middle, as if the first half was lost:
+// what it decodes must equal the tail of the session.
+//
+// Usage: bench_capture [passes] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "can_common.h"
+#include "can_capture.h"
+#include "raw_candump.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static bool sameFrame(const CAN_FRAME &a, const CAN_FRAME &b)
+{
+    return a.id == b.id && a.extended == b.extended && a.rtr == b.rtr && a.length == b.length &&
+           a.timestamp == b.timestamp && !memcmp(a.data.byte, b.data.byte, a.length);
+}
+
+static size_t encodeAll(const std::vector<CAN_FRAME> &frames, std::vector<uint8_t> &out)
+{
+    CANCaptureWriter writer;
+    out.resize(CAN_CAPTURE_HEADER_SIZE + frames.size() * CAN_CAPTURE_MAX_RECORD);
+    size_t used = canCaptureHeader(&out[0]);
+    for (const CAN_FRAME &frame : frames)
+        used += writer.encode(frame, &out[used]);
+    out.resize(used);
+    return used;
+}
+
+// Decodes a whole stream, or from pos on when that is a key record. -1 if it is damaged
+static long decodeAll(const std::vector<uint8_t> &in, std::vector<CAN_FRAME> &frames,
+                      size_t pos = CAN_CAPTURE_HEADER_SIZE)
+{
+    CANCaptureReader reader;
+    CAN_FRAME frame;
+    bool isFrame;
+
+    if (!canCaptureIsHeader(in.data(), in.size()))
+        return -1;
+    while (pos < in.size())
+    {
+        int n = reader.next(&in[pos], in.size() - pos, frame, isFrame);
+        if (n <= 0)
+            return -1;
+        pos += n;
+        if (isFrame)
+            frames.push_back(frame);
+    }
+    return (long)frames.size();
+}
+
+static double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 2000;
+    std::vector<const char *> inputs(argv + (argc > 1 ? 2 : 1), argv + argc);
+    if (inputs.empty())
+        inputs = {"raw_candump_08-03-22-15-14.csv", "raw_candump_08-03-22-18-12.csv", "raw_candump_08-04-22-13-43.csv",
+                  "candump_08-03-22-15-14.csv",     "candump_08-03-22-18-12.csv",     "candump_08-04-22-13-43.csv"};
+
+    std::vector<CAN_FRAME> all;
+    size_t textTotal = 0, binTotal = 0;
+    long mismatches = 0;
+
+    printf("capture                           frames   text bytes    cap bytes   ratio  bytes/frame\n");
+    for (const char *path : inputs)
+    {
+        RawCandumpReader reader;
+        if (!reader.open(path))
+        {
+            fprintf(stderr, "Can't read %s\n", path);
+            continue;
+        }
+        std::vector<CAN_FRAME> frames;
+        for (const CAN_FRAME &frame : reader)
+            frames.push_back(frame);
+        std::vector<uint8_t> bin;
+        std::vector<CAN_FRAME> back;
+        size_t size = encodeAll(frames, bin);
+        if (decodeAll(bin, back) != (long)frames.size())
+            mismatches++;
+        for (size_t i = 0; i < frames.size() && i < back.size(); i++)
+            if (!sameFrame(frames[i], back[i]))
+                mismatches++;
+
+        printf("%-30s %9zu %12zu %12zu %6.1fx %12.2f\n", path, frames.size(), reader.size(), size,
+               (double)reader.size() / size, frames.empty() ? 0.0 : (double)size / frames.size());
+        textTotal += reader.size();
+        binTotal += size;
+        all.insert(all.end(), frames.begin(), frames.end());
+    }
+    if (all.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+    printf("%-30s %9zu %12zu %12zu %6.1fx\n\n", "total", all.size(), textTotal, binTotal, (double)textTotal / binTotal);
+
+    // one long session: the captures back to back, passes times
+    std::vector<CAN_FRAME> session;
+    session.reserve(all.size() * passes);
+    uint32_t base = 0;
+    for (long p = 0; p < passes; p++)
+    {
+        for (CAN_FRAME frame : all)
+        {
+            frame.timestamp += base;
+            session.push_back(frame);
+        }
+        base = session.back().timestamp + 1000;
+    }
+
+    std::vector<uint8_t> bin;
+    auto start = Clock::now();
+    size_t size = encodeAll(session, bin);
+    double encode = seconds(start);
+
+    std::vector<CAN_FRAME> back;
+    back.reserve(session.size());
+    start = Clock::now();
+    long decoded = decodeAll(bin, back);
+    double decode = seconds(start);
+
+    if (decoded != (long)session.size())
+        mismatches++;
+    for (size_t i = 0; i < session.size() && i < back.size(); i++)
+        if (!sameFrame(session[i], back[i]))
+            mismatches++;
+
+    size_t half = bin.size() / 2;
+    size_t key = half + canCaptureFindKey(&bin[half], bin.size() - half);
+    std::vector<CAN_FRAME> tail;
+    long resynced = key < bin.size() ? decodeAll(bin, tail, key) : -1;
+    if (resynced <= 0)
+        mismatches++;
+    for (long i = 0; i < resynced && i < (long)session.size(); i++)
+        if (!sameFrame(session[session.size() - resynced + i], tail[i]))
+            mismatches++;
+
+    printf("%zu frames in one stream, %.2f bytes/frame, %ld mismatches\n", session.size(),
+           (double)size / session.size(), mismatches);
+    printf("  from the first key past the middle: %ld frames decoded\n", resynced);
+    printf("  encode  %6.1f ns/frame  %8.0f MB/s of output\n", encode * 1e9 / session.size(), size / encode / 1048576);
+    printf("  decode  %6.1f ns/frame  %8.0f MB/s of input\n", decode * 1e9 / session.size(), size / decode / 1048576);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_dispatch.cpp
+//
+// Host benchmark of how a frame reaches a registered callback in ESP32CAN:
+//
+//   two hop  task_LowLevelRX builds the frame, copies it into the callback queue and wakes
+//            task_CAN, which copies it out and calls the handler (the default path)
+//   inline   task_LowLevelRX calls the handler on the frame it just built
+//            (setInlineCallback)
+//
+// The callback queue is modelled like bench_rx_ring models the FreeRTOS queue: fixed
+// storage, copies in and out under a lock. task_CAN blocks on it the way it blocks on its
+// task notification, so every wake-up is a real thread switch on the host.
+//
+// Two measurements: a burst (frames/s with the queue kept busy) and a ping-pong where each
+// frame is sent on its own and we time frame built -> handler entered, which is the extra
+// latency the two hop path adds to every isolated frame.
+//
+// Usage: bench_dispatch [frames] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "can_common.h"
+#include "capture_csv.h"
+
+#define QUEUE_SIZE 16 // BI_CALLBACK_BUFFER_SIZE
+
+typedef std::chrono::steady_clock Clock;
+
+// Callback queue plus the notification task_CAN sleeps on
+class CallbackQueueModel
+{
+public:
+    CallbackQueueModel() : head(0), tail(0), waiting(0), closed(false) {}
+
+    bool send(const CAN_FRAME *item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            if (waiting == QUEUE_SIZE)
+                return false;
+            memcpy(&storage[head], item, sizeof(CAN_FRAME));
+            head = (head + 1) % QUEUE_SIZE;
+            waiting++;
+        }
+        notify.notify_one();
+        return true;
+    }
+
+    bool receive(CAN_FRAME *item)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        notify.wait(lock, [this]() { return waiting > 0 || closed; });
+        if (waiting == 0)
+            return false;
+        memcpy(item, &storage[tail], sizeof(CAN_FRAME));
+        tail = (tail + 1) % QUEUE_SIZE;
+        waiting--;
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            closed = true;
+        }
+        notify.notify_all();
+    }
+
+private:
+    std::mutex cs;
+    std::condition_variable notify;
+    CAN_FRAME storage[QUEUE_SIZE];
+    int head, tail, waiting;
+    bool closed;
+};
+
+// A handler of the kind that is allowed to run inline: decode a value and store it
+static volatile int engineSpeed;
+static uint64_t handled;
+
+static inline void handler(CAN_FRAME *frame)
+{
+    engineSpeed = 256 * frame->data.byte[2] + frame->data.byte[3];
+    handled += frame->id;
+}
+
+static inline void buildFrame(CAN_FRAME *msg, const CAN_FRAME &src, uint32_t fid)
+{
+    msg->id = src.id;
+    msg->length = src.length;
+    msg->rtr = src.rtr;
+    msg->extended = src.extended;
+    for (int i = 0; i < 8; i++)
+        msg->data.byte[i] = src.data.byte[i];
+    msg->fid = fid;
+}
+
+static double burstTwoHop(const std::vector<CAN_FRAME> &src, long frames)
+{
+    CallbackQueueModel queue;
+    handled = 0;
+
+    auto start = Clock::now();
+    std::thread taskCAN([&]() {
+        CAN_FRAME rxFrame;
+        while (queue.receive(&rxFrame))
+            handler(&rxFrame);
+    });
+    for (long i = 0; i < frames; i++)
+    {
+        CAN_FRAME msg;
+        buildFrame(&msg, src[i % src.size()], 0);
+        while (!queue.send(&msg)) // the driver drops here, the benchmark waits instead
+            std::this_thread::yield();
+    }
+    queue.close();
+    taskCAN.join();
+    return std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / frames;
+}
+
+static double burstInline(const std::vector<CAN_FRAME> &src, long frames)
+{
+    CAN_FRAME slot; // the RX ring slot the frame is built in
+    handled = 0;
+
+    auto start = Clock::now();
+    for (long i = 0; i < frames; i++)
+    {
+        buildFrame(&slot, src[i % src.size()], 0);
+        handler(&slot);
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / frames;
+}
+
+// Frame built -> handler entered, one frame in flight at a time
+static std::vector<double> pingPongTwoHop(const std::vector<CAN_FRAME> &src, long frames)
+{
+    CallbackQueueModel queue;
+    std::vector<double> latency;
+    std::atomic<long> done(0);
+    Clock::time_point built;
+
+    latency.reserve(frames);
+    std::thread taskCAN([&]() {
+        CAN_FRAME rxFrame;
+        while (queue.receive(&rxFrame))
+        {
+            latency.push_back(std::chrono::duration<double>(Clock::now() - built).count() * 1e9);
+            handler(&rxFrame);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    });
+    for (long i = 0; i < frames; i++)
+    {
+        CAN_FRAME msg;
+        built = Clock::now();
+        buildFrame(&msg, src[i % src.size()], 0);
+        queue.send(&msg);
+        while (done.load(std::memory_order_acquire) <= i)
+            std::this_thread::yield();
+    }
+    queue.close();
+    taskCAN.join();
+    return latency;
+}
+
+static std::vector<double> pingPongInline(const std::vector<CAN_FRAME> &src, long frames)
+{
+    std::vector<double> latency;
+    CAN_FRAME slot;
+
+    latency.reserve(frames);
+    for (long i = 0; i < frames; i++)
+    {
+        Clock::time_point built = Clock::now();
+        buildFrame(&slot, src[i % src.size()], 0);
+        latency.push_back(std::chrono::duration<double>(Clock::now() - built).count() * 1e9);
+        handler(&slot);
+    }
+    return latency;
+}
+
+static double percentile(std::vector<double> &v, double pct)
+{
+    if (v.empty())
+        return 0;
+    size_t k = (size_t)(pct / 100.0 * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+int main(int argc, char **argv)
+{
+    long frames = argc > 1 ? atol(argv[1]) : 2000000;
+    std::vector<CAN_FRAME> src;
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; i++)
+            if (captureLoadFile(argv[i], src) < 0)
+                fprintf(stderr, "Can't read %s\n", argv[i]);
+    }
+    else
+    {
+        captureLoadFile("candump_08-03-22-15-14.csv", src);
+        captureLoadFile("candump_08-03-22-18-12.csv", src);
+        captureLoadFile("candump_08-04-22-13-43.csv", src);
+    }
+    if (src.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+
+    printf("%zu captured frames, replaying %ld per run\n\n", src.size(), frames);
+
+    double twoHop = burstTwoHop(src, frames);
+    uint64_t twoHopSum = handled;
+    double single = burstInline(src, frames);
+    if (handled != twoHopSum)
+        fprintf(stderr, "Checksum mismatch: two hop %llu inline %llu\n",
+                (unsigned long long)twoHopSum, (unsigned long long)handled);
+
+    printf("burst             ns/frame\n");
+    printf("  two hop       %12.1f\n", twoHop);
+    printf("  inline        %12.1f\n", single);
+    printf("  speedup       %12.2fx\n\n", twoHop / single);
+
+    long pings = frames / 20 > 0 ? frames / 20 : 1;
+    std::vector<double> a = pingPongTwoHop(src, pings);
+    std::vector<double> b = pingPongInline(src, pings);
+
+    printf("isolated frame    built -> handler, ns (%ld frames)\n", pings);
+    printf("                       p50          p99\n");
+    printf("  two hop       %10.0f   %10.0f\n", percentile(a, 50), percentile(a, 99));
+    printf("  inline        %10.0f   %10.0f\n", percentile(b, 50), percentile(b, 99));
+    return 0;
+}
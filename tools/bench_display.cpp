@@ -0,0 +1,200 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_display.cpp
+//
+// Host benchmark of the OLED tile updates (include/oled_tiles.h) over recorded drives. The
+// captures are played on a virtual clock (raw_candump_*.csv keep their timing, frames of
+// the same second spread evenly; other captures are paced at -r frames/s), engine speed is
+// decoded with the firmware's signal table and the default screen is redrawn every DELAY_MS
+// of capture time, the way loop() does once the menu has timed out. Every frame goes
+// through the frame buffer of the native U8g2 stand-in and is sent two ways:
+//
+//   full    u8g2.sendBuffer(), 1024 bytes each time
+//   tiles   only the runs of changed 8x8 tiles, through updateDisplayArea()
+//
+// Besides the frame buffer bytes it estimates the I2C time at 400 kHz (9 bits per byte) of
+// each way: every area first sets the column and page (BENCH_AREA_OVERHEAD bytes) and U8g2
+// splits the data into Wire transfers of BENCH_I2C_CHUNK bytes that each repeat the address
+// and control byte. Last, the cost of flush() itself in ns per frame.
+//
+// Usage: bench_display [-i interval_ms] [-r fps] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+
+#include "can_common.h"
+#include "capture_csv.h"
+#include "config.h"
+#include "oled_tiles.h"
+#include "native/U8g2lib.h"
+
+const int CURRENT_ENGINE_SPEED = 0; // value slot, as in menu.h
+#include "signals.h"
+
+#define BENCH_DEFAULT_FPS 1000
+#define BENCH_AREA_OVERHEAD 6 // address, control byte, column low/high, page
+#define BENCH_I2C_CHUNK 24    // data bytes per Wire transfer
+#define BENCH_I2C_HZ 400000
+#define BENCH_PASSES 50       // repetitions of the flush() timing
+
+struct WireCost
+{
+    uint64_t bytes;
+    uint64_t areas;
+    uint64_t wireBytes;
+
+    void area(int tiles)
+    {
+        int data = tiles * OLED_TILE_BYTES;
+        bytes += data;
+        areas++;
+        wireBytes += BENCH_AREA_OVERHEAD + data + 2 * ((data + BENCH_I2C_CHUNK - 1) / BENCH_I2C_CHUNK);
+    }
+    double milliseconds() const { return wireBytes * 9 * 1000.0 / BENCH_I2C_HZ; }
+};
+
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE, 0, 0);
+
+// What SSD1306_ShowDefaultScreen() draws
+static void drawDefaultScreen(int rpm)
+{
+    char s[20];
+
+    u8g2.clearBuffer();
+    u8g2.setFont(u8g2_font_logisoso16_tf);
+    u8g2.drawStr(0, 16, "ENGINE RPM");
+    u8g2.setFont(u8g2_font_logisoso38_tf);
+    sprintf(s, "%d", rpm);
+    u8g2.drawStr(0, 63, s);
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: bench_display [-i interval_ms] [-r fps] [capture.csv ...]\n"
+                    "  -i  redraw interval in capture time (default DELAY_MS, %d)\n"
+                    "  -r  pace of captures without timestamps (default %d)\n",
+            DELAY_MS, BENCH_DEFAULT_FPS);
+}
+
+int main(int argc, char **argv)
+{
+    double interval = DELAY_MS;
+    double fps = BENCH_DEFAULT_FPS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:r:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i':
+            interval = atof(optarg);
+            break;
+        case 'r':
+            fps = atof(optarg);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (interval <= 0 || fps <= 0)
+    {
+        usage();
+        return 2;
+    }
+
+    static const char *drives[] = {"raw_candump_08-03-22-15-14.csv", "raw_candump_08-03-22-18-12.csv",
+                                   "raw_candump_08-04-22-13-43.csv"};
+    std::vector<const char *> files;
+    for (int i = optind; i < argc; i++)
+        files.push_back(argv[i]);
+    if (files.empty())
+        for (const char *drive : drives)
+            files.push_back(drive);
+
+    // one default screen per interval of each drive, kept for the timing pass
+    std::vector<std::vector<uint8_t>> screens;
+    uint64_t frameCount = 0;
+    double seconds = 0;
+    for (const char *file : files)
+    {
+        std::vector<CAN_FRAME> frames;
+        if (captureLoadFile(file, frames) < 0)
+        {
+            fprintf(stderr, "Can't read %s\n", file);
+            return 1;
+        }
+        frameCount += frames.size();
+
+        bool timed = false;
+        for (const CAN_FRAME &f : frames)
+            if (f.timestamp)
+                timed = true;
+
+        int values[30] = {0};
+        double nextDraw = 0, ms = 0;
+        for (size_t i = 0; i < frames.size();)
+        {
+            size_t end = i + 1;
+            if (timed)
+                while (end < frames.size() && frames[end].timestamp == frames[i].timestamp)
+                    end++;
+            for (size_t k = i; k < end; k++)
+            {
+                ms = timed ? frames[i].timestamp / 1000.0 + (k - i) * 1000.0 / (end - i) : k * 1000.0 / fps;
+                while (ms >= nextDraw)
+                {
+                    drawDefaultScreen(values[CURRENT_ENGINE_SPEED]);
+                    screens.emplace_back(u8g2.getBufferPtr(), u8g2.getBufferPtr() + OLED_BUFFER_SIZE);
+                    nextDraw += interval;
+                }
+                canDecodeFrame(canSignals, CAN_SIGNAL_COUNT, frames[k], values);
+            }
+            i = end;
+        }
+        seconds += ms / 1000.0;
+    }
+    if (screens.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+
+    WireCost full = {0, 0, 0}, tiles = {0, 0, 0};
+    OledTileTracker tracker;
+    for (const std::vector<uint8_t> &screen : screens)
+    {
+        for (int row = 0; row < OLED_TILE_ROWS; row++)
+            full.area(OLED_TILE_COLS); // sendBuffer() sends page by page
+        tracker.flush(screen.data(), [&](int, int, int tw) { tiles.area(tw); });
+    }
+
+    size_t n = screens.size();
+    printf("%llu frames, %.0f s of driving, %zu redraws every %.0f ms\n\n", (unsigned long long)frameCount,
+           seconds, n, interval);
+    printf("         bytes/frame  areas/frame  wire bytes/frame  I2C ms/frame  total I2C s\n");
+    printf("full     %11.1f  %11.1f  %16.1f  %12.2f  %11.2f\n", (double)full.bytes / n, (double)full.areas / n,
+           (double)full.wireBytes / n, full.milliseconds() / n, full.milliseconds() / 1000);
+    printf("tiles    %11.1f  %11.1f  %16.1f  %12.2f  %11.2f\n", (double)tiles.bytes / n, (double)tiles.areas / n,
+           (double)tiles.wireBytes / n, tiles.milliseconds() / n, tiles.milliseconds() / 1000);
+    printf("\nunchanged frames %u of %zu, peak %u bytes, %.1fx fewer wire bytes\n", tracker.stats.unchanged, n,
+           tracker.stats.peakBytes, (double)full.wireBytes / tiles.wireBytes);
+
+    // cost of the diff itself
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < BENCH_PASSES; p++)
+    {
+        tracker.invalidate();
+        for (const std::vector<uint8_t> &screen : screens)
+            checksum += tracker.flush(screen.data(), [&](int tx, int ty, int tw) { checksum += tx + ty + tw; });
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("flush() %.0f ns per frame on this host (checksum %llu)\n", ns / (BENCH_PASSES * n),
+           (unsigned long long)checksum);
+    return 0;
+}
@@ -0,0 +1,145 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_glyph_cache.cpp
+//
+// Host benchmark of the large readout drawn from pre-rasterized glyphs (include/
+// glyph_cache.h) against u8g2.drawStr(). Renders the default screen (header and engine
+// speed in the large font) for every value of an RPM sweep, and for the engine speeds of the
+// recorded drives, both ways through the native U8g2 stand-in, whose fonts are run length
+// coded and decoded per glyph like U8g2's. Every frame of the cached path is checked to be
+// identical to the drawStr() one.
+//
+// Reports ns per frame of the whole screen (clearBuffer, header, readout) and of the
+// readout alone.
+//
+// Usage: bench_glyph_cache [passes] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "can_common.h"
+#include "capture_csv.h"
+#include "glyph_cache.h"
+#include "native/U8g2lib.h"
+
+const int CURRENT_ENGINE_SPEED = 0; // value slot, as in menu.h
+#include "signals.h"
+
+#define BENCH_SWEEP 10000 // 0 to 9999 RPM
+
+static U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, U8X8_PIN_NONE, 0, 0);
+static OledGlyphCache glyphs;
+
+// What SSD1306_ShowDefaultScreen() draws, the readout either way
+static void drawScreen(const char *value, bool cached, bool header)
+{
+    u8g2.clearBuffer();
+    if (header)
+    {
+        u8g2.setFont(u8g2_font_logisoso16_tf);
+        u8g2.drawStr(0, 16, "ENGINE RPM");
+    }
+    if (!cached || glyphs.draw(u8g2.getBufferPtr(), 0, 63, value) < 0)
+    {
+        u8g2.setFont(u8g2_font_logisoso38_tf);
+        u8g2.drawStr(0, 63, value);
+    }
+}
+
+static double timeScreens(const std::vector<std::vector<char>> &values, long passes, bool cached, bool header)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long p = 0; p < passes; p++)
+        for (const std::vector<char> &value : values)
+            drawScreen(value.data(), cached, header);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / (passes * values.size());
+}
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 20;
+    if (passes < 1)
+    {
+        fprintf(stderr, "usage: bench_glyph_cache [passes] [capture.csv ...]\n");
+        return 2;
+    }
+
+    // the boot time capture, as displayGlyphsSetup() does it
+    u8g2.setFont(u8g2_font_logisoso38_tf);
+    for (const char *c = GLYPH_CACHE_CHARS; *c; c++)
+    {
+        char s[2] = {*c, 0};
+        u8g2.clearBuffer();
+        int advance = u8g2.drawStr(0, 63, s);
+        glyphs.capture(*c, u8g2.getBufferPtr(), 63, advance);
+    }
+    printf("%d glyphs cached in %d bytes\n", glyphs.size(), glyphs.bytes());
+
+    std::vector<std::vector<char>> sweep, drive;
+    char s[16];
+    for (int rpm = 0; rpm < BENCH_SWEEP; rpm++)
+    {
+        snprintf(s, sizeof(s), "%d", rpm);
+        sweep.emplace_back(s, s + strlen(s) + 1);
+    }
+
+    static const char *drives[] = {"candump_08-03-22-15-14.csv", "candump_08-03-22-18-12.csv",
+                                   "candump_08-04-22-13-43.csv"};
+    std::vector<const char *> files;
+    for (int i = 2; i < argc; i++)
+        files.push_back(argv[i]);
+    if (files.empty())
+        for (const char *file : drives)
+            files.push_back(file);
+    for (const char *file : files)
+    {
+        std::vector<CAN_FRAME> frames;
+        if (captureLoadFile(file, frames) < 0)
+        {
+            fprintf(stderr, "Can't read %s\n", file);
+            return 1;
+        }
+        int values[30] = {0};
+        for (const CAN_FRAME &frame : frames)
+            if (canDecodeFrame(canSignals, CAN_SIGNAL_COUNT, frame, values))
+            {
+                snprintf(s, sizeof(s), "%d", values[CURRENT_ENGINE_SPEED]);
+                drive.emplace_back(s, s + strlen(s) + 1);
+            }
+    }
+
+    // same pixels both ways
+    long mismatches = 0;
+    for (const std::vector<std::vector<char>> *set : {&sweep, &drive})
+        for (const std::vector<char> &value : *set)
+        {
+            uint8_t reference[1024];
+            drawScreen(value.data(), false, true);
+            memcpy(reference, u8g2.getBufferPtr(), sizeof(reference));
+            drawScreen(value.data(), true, true);
+            if (memcmp(reference, u8g2.getBufferPtr(), sizeof(reference)))
+                mismatches++;
+        }
+    printf("%zu sweep values, %zu engine speed frames from the drives, %ld frames differ\n\n", sweep.size(),
+           drive.size(), mismatches);
+
+    printf("ns per frame            drawStr()   glyph cache   speedup\n");
+    for (int set = 0; set < 2; set++)
+    {
+        const std::vector<std::vector<char>> &values = set ? drive : sweep;
+        if (values.empty())
+            continue;
+        for (int header = 1; header >= 0; header--)
+        {
+            double slow = timeScreens(values, passes, false, header);
+            double fast = timeScreens(values, passes, true, header);
+            printf("%-6s %-14s %10.0f  %12.0f  %7.1fx\n", set ? "drives" : "sweep",
+                   header ? "whole screen" : "readout only", slow, fast, slow / fast);
+        }
+    }
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_raw_candump.cpp
+//
+// Host benchmark of the raw_candump_*.csv readers, in MB/s of log text:
+//
+//   capture_csv  captureLoadFile(): fgets into a line buffer, tokenize, strtoul per field
+//   mmap         RawCandumpReader (tools/host/raw_candump.h): mapped file, parsed in place
+//   convert      RawCandumpReader plus formatting every frame in the compact candump_*.csv
+//                layout, as tools/raw2candump does (output kept in memory)
+//
+// The recorded logs are only a few kilobytes, so they are concatenated over and over into a
+// scratch file of the requested size first (it is read once before timing so both readers
+// start from the page cache). Both readers must produce exactly the same frames.
+
+//
+// Usage: bench_raw_candump [MB] [raw_candump.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "can_common.h"
+#include "capture_csv.h"
+#include "raw_candump.h"
+
+#define SCRATCH_FILE "/tmp/bench_raw_candump.csv"
+
+typedef std::chrono::steady_clock Clock;
+
+static bool sameFrame(const CAN_FRAME &a, const CAN_FRAME &b)
+{
+    return a.id == b.id && a.extended == b.extended && a.length == b.length && a.timestamp == b.timestamp &&
+           !memcmp(a.data.byte, b.data.byte, a.length);
+}
+
+static bool readAll(const char *path, std::string &text)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        text.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+static double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    long megabytes = argc > 1 ? atol(argv[1]) : 256;
+    std::vector<const char *> inputs(argv + (argc > 1 ? 2 : 1), argv + argc);
+    if (inputs.empty())
+        inputs = {"raw_candump_08-03-22-15-14.csv", "raw_candump_08-03-22-18-12.csv", "raw_candump_08-04-22-13-43.csv"};
+
+    // a log cut off mid-line (power lost while writing) would run into the next copy, drop it
+    std::string seed;
+    for (const char *path : inputs)
+    {
+        std::string text;
+        if (!readAll(path, text))
+            fprintf(stderr, "Can't read %s\n", path);
+        seed.append(text, 0, text.rfind('\n') + 1);
+    }
+    if (seed.empty())
+    {
+        fprintf(stderr, "No log text loaded. Run from the repository root or pass raw_candump files.\n");
+        return 1;
+    }
+
+    FILE *f = fopen(SCRATCH_FILE, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Can't write %s\n", SCRATCH_FILE);
+        return 1;
+    }
+    size_t target = (size_t)megabytes << 20, written = 0;
+    while (written < target)
+        written += fwrite(seed.data(), 1, seed.size(), f);
+    fclose(f);
+    double mb = written / 1048576.0;
+
+    // warm the page cache
+    RawCandumpReader reader;
+    if (!reader.open(SCRATCH_FILE))
+    {
+        fprintf(stderr, "Can't map %s\n", SCRATCH_FILE);
+        return 1;
+    }
+    volatile uint64_t touch = 0;
+    {
+        std::string warm;
+        readAll(SCRATCH_FILE, warm);
+        touch += warm.size();
+    }
+
+    auto start = Clock::now();
+    std::vector<CAN_FRAME> reference;
+    reference.reserve(written / 40);
+    captureLoadFile(SCRATCH_FILE, reference);
+    double csv = seconds(start);
+
+    start = Clock::now();
+    uint64_t frames = 0, checksum = 0;
+    for (const CAN_FRAME &frame : reader)
+    {
+        frames++;
+        checksum += frame.id + frame.data.byte[0] + frame.timestamp;
+    }
+    double mapped = seconds(start);
+
+    // correctness: same frames, in the same order
+    uint64_t mismatches = frames == reference.size() ? 0 : 1;
+    reader.rewind();
+    size_t k = 0;
+    for (const CAN_FRAME &frame : reader)
+        if (k >= reference.size() || !sameFrame(frame, reference[k++]))
+            mismatches++;
+
+    std::vector<char> out(written + 64);
+    reader.rewind();
+    start = Clock::now();
+    size_t used = 0;
+    for (const CAN_FRAME &frame : reader)
+        used += rawFormatCandump(frame, &out[used]);
+    double convert = seconds(start);
+
+    printf("%.0f MB of log text, %llu frames, %llu lines skipped, %llu mismatches\n\n", mb,
+           (unsigned long long)frames, (unsigned long long)reader.skippedLines(), (unsigned long long)mismatches);
+    printf("                     MB/s     Mframes/s\n");
+    printf("  capture_csv  %10.0f  %10.2f\n", mb / csv, reference.size() / csv / 1e6);
+    printf("  mmap         %10.0f  %10.2f   (%.1fx)\n", mb / mapped, frames / mapped / 1e6, csv / mapped);
+    printf("  convert      %10.0f  %10.2f   (%.0f MB of candump text)\n", mb / convert, frames / convert / 1e6,
+           used / 1048576.0);
+    printf("  (checksum %llu %llu)\n", (unsigned long long)checksum, (unsigned long long)touch);
+
+    remove(SCRATCH_FILE);
+    return mismatches ? 1 : 0;
+}
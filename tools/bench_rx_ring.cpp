@@ -0,0 +1,263 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_rx_ring.cpp
+//
+// Host benchmark of the ESP32CAN receive path: the lock-free CANFrameRing against a model
+// of the FreeRTOS rx_queue it replaced (copy into a local frame, copy into the queue under
+// a critical section, copy out again under a critical section).
+//
+// The frames replayed are the ones recorded in the candump_*.csv captures. Absolute numbers
+// are host numbers; the ratio between the two paths is what matters.
+//
+// Usage: bench_rx_ring [frames] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "can_common.h"
+#include "can_ring.h"
+#include "capture_csv.h"
+
+#define QUEUE_SIZE 64 // BI_RX_BUFFER_SIZE
+
+// What twai_receive() hands to processFrame()
+struct TwaiMessage
+{
+    uint32_t identifier;
+    uint8_t data_length_code;
+    uint8_t data[8];
+    bool extd;
+    bool rtr;
+};
+
+// Stand-in for a FreeRTOS queue: fixed storage, copy in, copy out, every access inside a
+// critical section.
+class QueueModel
+{
+public:
+    QueueModel() : head(0), tail(0), waiting(0) {}
+
+    bool send(const CAN_FRAME *item)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (waiting == QUEUE_SIZE)
+            return false;
+        memcpy(&storage[head], item, sizeof(CAN_FRAME));
+        head = (head + 1) % QUEUE_SIZE;
+        waiting++;
+        return true;
+    }
+
+    bool receive(CAN_FRAME *item)
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        if (waiting == 0)
+            return false;
+        memcpy(item, &storage[tail], sizeof(CAN_FRAME));
+        tail = (tail + 1) % QUEUE_SIZE;
+        waiting--;
+        return true;
+    }
+
+private:
+    std::mutex cs;
+    CAN_FRAME storage[QUEUE_SIZE];
+    int head, tail, waiting;
+};
+
+static inline void buildFrame(CAN_FRAME *msg, const TwaiMessage &frame)
+{
+    msg->id = frame.identifier;
+    msg->length = frame.data_length_code;
+    msg->rtr = frame.rtr;
+    msg->extended = frame.extd;
+    for (int i = 0; i < 8; i++)
+        msg->data.byte[i] = frame.data[i];
+}
+
+static inline uint64_t consume(const CAN_FRAME &msg)
+{
+    return msg.id + msg.data.value;
+}
+
+struct Result
+{
+    double fps;
+    uint64_t checksum;
+    uint64_t fullSpins;
+};
+
+static Result runQueue(const std::vector<TwaiMessage> &src, long frames)
+{
+    QueueModel queue;
+    uint64_t checksum = 0, spins = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() {
+        CAN_FRAME frame, msg;
+        long got = 0;
+        while (got < frames)
+        {
+            if (queue.receive(&frame)) // get_rx_buff()
+            {
+                msg = frame;
+                checksum += consume(msg);
+                got++;
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    for (long i = 0; i < frames; i++) // task_LowLevelRX + processFrame()
+    {
+        CAN_FRAME msg;
+        buildFrame(&msg, src[i % src.size()]);
+        while (!queue.send(&msg))
+        {
+            spins++;
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {frames / secs, checksum, spins};
+}
+
+static Result runRing(const std::vector<TwaiMessage> &src, long frames)
+{
+    CANFrameRing ring;
+    uint64_t checksum = 0, spins = 0;
+
+    ring.allocate(QUEUE_SIZE);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() {
+        long got = 0;
+        while (got < frames)
+        {
+            CAN_FRAME *msg = ring.peek();
+            if (msg)
+            {
+                checksum += consume(*msg);
+                ring.release();
+                got++;
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    for (long i = 0; i < frames; i++)
+    {
+        CAN_FRAME *msg;
+        while ((msg = ring.claim()) == NULL)
+        {
+            spins++;
+            std::this_thread::yield();
+        }
+        buildFrame(msg, src[i % src.size()]);
+        ring.commit();
+    }
+    consumer.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {frames / secs, checksum, spins};
+}
+
+// Same path with producer and consumer on one thread, which isolates the per-frame cost of
+// the buffer itself from cross-core traffic.
+template <typename Fn>
+static double nsPerFrame(long frames, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return secs * 1e9 / frames;
+}
+
+int main(int argc, char **argv)
+{
+    long frames = argc > 1 ? atol(argv[1]) : 5000000;
+    std::vector<CAN_FRAME> captured;
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; i++)
+            if (captureLoadFile(argv[i], captured) < 0)
+                fprintf(stderr, "Can't read %s\n", argv[i]);
+    }
+    else
+    {
+        captureLoadFile("candump_08-03-22-15-14.csv", captured);
+        captureLoadFile("candump_08-03-22-18-12.csv", captured);
+        captureLoadFile("candump_08-04-22-13-43.csv", captured);
+    }
+    if (captured.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+
+    std::vector<TwaiMessage> src;
+    for (const CAN_FRAME &f : captured)
+    {
+        TwaiMessage m;
+        m.identifier = f.id;
+        m.data_length_code = f.length;
+        m.extd = f.extended;
+        m.rtr = f.rtr;
+        memcpy(m.data, f.data.byte, 8);
+        src.push_back(m);
+    }
+
+    printf("%zu captured frames, replaying %ld per run\n\n", src.size(), frames);
+
+    Result q = runQueue(src, frames);
+    Result r = runRing(src, frames);
+    if (q.checksum != r.checksum)
+        fprintf(stderr, "Checksum mismatch: queue %llu ring %llu\n",
+                (unsigned long long)q.checksum, (unsigned long long)r.checksum);
+
+    printf("two threads       frames/s      producer full yields\n");
+    printf("  queue model   %12.0f   %12llu\n", q.fps, (unsigned long long)q.fullSpins);
+    printf("  spsc ring     %12.0f   %12llu\n", r.fps, (unsigned long long)r.fullSpins);
+    printf("  speedup       %12.2fx\n\n", r.fps / q.fps);
+
+    QueueModel queue;
+    CANFrameRing ring;
+    ring.allocate(QUEUE_SIZE);
+    uint64_t sink = 0;
+
+    double qns = nsPerFrame(frames, [&]() {
+        CAN_FRAME msg, frame;
+        for (long i = 0; i < frames; i++)
+        {
+            buildFrame(&msg, src[i % src.size()]);
+            queue.send(&msg);
+            queue.receive(&frame);
+            sink += consume(frame);
+        }
+    });
+    double rns = nsPerFrame(frames, [&]() {
+        for (long i = 0; i < frames; i++)
+        {
+            CAN_FRAME *msg = ring.claim();
+            buildFrame(msg, src[i % src.size()]);
+            ring.commit();
+            sink += consume(*ring.peek());
+            ring.release();
+        }
+    });
+
+    printf("one thread        ns/frame\n");
+    printf("  queue model   %12.1f\n", qns);
+    printf("  spsc ring     %12.1f\n", rns);
+    printf("  (checksum %llu)\n", (unsigned long long)sink);
+    return 0;
+}
@@ -0,0 +1,180 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/bench_signals.cpp
+//
+// Host benchmark of the signal decoder in include/can_signal.h. The recorded captures are
+// decoded three ways:
+//
+//   interpreted  a generic DBC style decoder that walks each signal bit by bit using the
+//                layout stored in the table at run time
+//   table        canDecodeFrame() with the compile time specialized extractors
+//   hand coded   the old "if (id == ...) v = 256 * byte[2] + byte[3]" (engine speed only)
+//
+// Besides the firmware's engine speed signal the table holds a set of made-up signals of
+// every shape (both byte orders, signed, odd lengths, crossing byte boundaries) on the
+// busiest IDs of the captures, so there is real work per frame. The interpreted decoder is
+// also the reference: every table result is checked against it.
+//
+// Usage: bench_signals [passes] [capture.csv ...]
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "can_common.h"
+#include "can_signal.h"
+#include "capture_csv.h"
+
+#define VALUE_COUNT 30
+
+// Layout kept as data, the way a runtime DBC decoder sees it
+struct SignalLayout
+{
+    uint32_t frameId;
+    uint8_t start;
+    uint8_t length;
+    uint8_t order;
+    bool isSigned;
+    float scale;
+    float offset;
+    int slot;
+};
+
+// The same list once as runtime data and once specialized at compile time
+#define BENCH_SIGNALS(X)                                                     \
+    X(0x0028A006, 0, 12, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 10)           \
+    X(0x0030A002, 7, 8, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 11)               \
+    X(0x0030A002, 12, 10, CAN_BIG_ENDIAN, true, 0.5f, -10.0f, 12)            \
+    X(0x0030A002, 40, 16, CAN_LITTLE_ENDIAN, true, 1.0f, 0.0f, 13)           \
+    X(0x0220A006, 7, 16, CAN_BIG_ENDIAN, false, 0.25f, 0.0f, 14)             \
+    X(0x0220A006, 20, 7, CAN_LITTLE_ENDIAN, false, 1.0f, 40.0f, 15)          \
+    X(0x0220A006, 39, 32, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 16)             \
+    X(0x0618A001, 23, 16, CAN_BIG_ENDIAN, false, 1.0f, 0.0f, 0)              \
+    X(0x0618A001, 32, 8, CAN_LITTLE_ENDIAN, true, 1.0f, 0.0f, 17)            \
+    X(0x0628A001, 15, 16, CAN_BIG_ENDIAN, false, 0.1f, 0.0f, 18)             \
+    X(0x0628A001, 24, 1, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 19)           \
+    X(0x0810A000, 0, 32, CAN_LITTLE_ENDIAN, true, 1.0f, 0.0f, 20)            \
+    X(0x0810A000, 44, 5, CAN_LITTLE_ENDIAN, false, 1.0f, 0.0f, 21)
+
+#define AS_LAYOUT(id, start, len, order, sign, scale, offset, slot) {id, start, len, order, sign, scale, offset, slot},
+#define AS_SIGNAL(id, start, len, order, sign, scale, offset, slot) CAN_SIGNAL_DEF(id, true, start, len, order, sign, scale, offset, slot),
+
+static const SignalLayout layouts[] = {BENCH_SIGNALS(AS_LAYOUT)};
+constexpr CAN_SIGNAL signals[] = {BENCH_SIGNALS(AS_SIGNAL)};
+#define SIGNAL_COUNT (int)(sizeof(signals) / sizeof(signals[0]))
+static_assert(canSignalsSorted(signals, SIGNAL_COUNT), "bench table must be sorted by frame ID");
+
+// Bit by bit, straight from the DBC definition of the two byte orders
+static int32_t interpretRaw(const SignalLayout &s, const uint8_t *data)
+{
+    uint32_t raw = 0;
+    int bit = s.start;
+    if (s.order == CAN_LITTLE_ENDIAN)
+    {
+        for (int i = 0; i < s.length; i++, bit++)
+            raw |= (uint32_t)((data[bit / 8] >> (bit % 8)) & 1) << i;
+    }
+    else
+    {
+        for (int i = 0; i < s.length; i++)
+        {
+            raw = (raw << 1) | ((data[bit / 8] >> (bit % 8)) & 1);
+            bit = bit % 8 == 0 ? bit + 15 : bit - 1;
+        }
+    }
+    if (s.isSigned && s.length < 32 && (raw & (1u << (s.length - 1))))
+        raw |= ~0u << s.length;
+    return (int32_t)raw;
+}
+
+static int interpretFrame(const CAN_FRAME &frame, int *values)
+{
+    int decoded = 0;
+    for (const SignalLayout &s : layouts)
+    {
+        if (s.frameId != frame.id)
+            continue;
+        values[s.slot] = (int)(interpretRaw(s, frame.data.byte) * s.scale + s.offset);
+        decoded++;
+    }
+    return decoded;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char **argv)
+{
+    long passes = argc > 1 ? atol(argv[1]) : 20000;
+    std::vector<CAN_FRAME> frames;
+
+    if (argc > 2)
+    {
+        for (int i = 2; i < argc; i++)
+            if (captureLoadFile(argv[i], frames) < 0)
+                fprintf(stderr, "Can't read %s\n", argv[i]);
+    }
+    else
+    {
+        captureLoadFile("candump_08-03-22-15-14.csv", frames);
+        captureLoadFile("candump_08-03-22-18-12.csv", frames);
+        captureLoadFile("candump_08-04-22-13-43.csv", frames);
+    }
+    if (frames.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+
+    // correctness first: the table has to agree with the bit by bit reference everywhere
+    long mismatches = 0, perPass = 0;
+    for (const CAN_FRAME &f : frames)
+    {
+        int a[VALUE_COUNT] = {0}, b[VALUE_COUNT] = {0};
+        perPass += interpretFrame(f, a);
+        canDecodeFrame(signals, SIGNAL_COUNT, f, b);
+        for (int i = 0; i < VALUE_COUNT; i++)
+            if (a[i] != b[i])
+                mismatches++;
+        if (f.id == 0x0618A001 && b[0] != 256 * f.data.byte[2] + f.data.byte[3])
+            mismatches++;
+    }
+    printf("%zu captured frames, %d signals, %ld decoded per pass, %ld mismatches\n\n", frames.size(),
+           SIGNAL_COUNT, perPass, mismatches);
+
+    int values[VALUE_COUNT] = {0};
+    long total = 0;
+
+    auto start = Clock::now();
+    for (long p = 0; p < passes; p++)
+        for (const CAN_FRAME &f : frames)
+            total += interpretFrame(f, values);
+    double interpreted = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (long p = 0; p < passes; p++)
+        for (const CAN_FRAME &f : frames)
+            total += canDecodeFrame(signals, SIGNAL_COUNT, f, values);
+    double table = std::chrono::duration<double>(Clock::now() - start).count();
+
+    long rpmFrames = 0;
+    start = Clock::now();
+    for (long p = 0; p < passes; p++)
+        for (const CAN_FRAME &f : frames)
+            if (f.id == 0x0618A001)
+            {
+                values[0] = 256 * f.data.byte[2] + f.data.byte[3];
+                rpmFrames++;
+            }
+    double handCoded = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double signalsPerRun = (double)perPass * passes;
+    printf("                 signals/s      ns/frame\n");
+    printf("  interpreted  %12.0f  %10.2f\n", signalsPerRun / interpreted, interpreted * 1e9 / (passes * frames.size()));
+    printf("  table        %12.0f  %10.2f\n", signalsPerRun / table, table * 1e9 / (passes * frames.size()));
+    printf("  hand coded   %12.0f  %10.2f   (engine speed only)\n", rpmFrames / handCoded,
+           handCoded * 1e9 / (passes * frames.size()));
+    printf("  (checksum %ld %d)\n", total, values[0]);
+    return mismatches ? 1 : 0;
+}
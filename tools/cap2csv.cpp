@@ -0,0 +1,73 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/cap2csv.cpp
+//
+// Converts a binary capture (include/can_capture.h) into text: the compact candump_*.csv
+// layout by default, or with -t the same lines prefixed by the frame's micros() timestamp
+// (which the compact layout has no room for).
+//
+// Usage: cap2csv [-t] capture.cap [capture.csv]      (stdout if no output is given)
+// ==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+
+#include "can_common.h"
+#include "capture_bin.h"
+#include "raw_candump.h"
+
+#define OUTPUT_BUFFER (1 << 20)
+
+int main(int argc, char **argv)
+{
+    bool timestamps = argc > 1 && !strcmp(argv[1], "-t");
+    int arg = timestamps ? 2 : 1;
+    if (argc - arg < 1 || argc - arg > 2)
+    {
+        fprintf(stderr, "usage: cap2csv [-t] capture.cap [capture.csv]\n");
+        return 2;
+    }
+
+    CaptureBinReader reader;
+    if (!reader.open(argv[arg]))
+    {
+        fprintf(stderr, "Can't read %s or it isn't a capture\n", argv[arg]);
+        return 1;
+    }
+    FILE *out = argc - arg > 1 ? fopen(argv[arg + 1], "wb") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "Can't write %s\n", argv[arg + 1]);
+        return 1;
+    }
+
+    static char buffer[OUTPUT_BUFFER];
+    size_t used = 0;
+    unsigned long frames = 0;
+    CAN_FRAME frame;
+    while (reader.next(frame))
+    {
+        if (used > OUTPUT_BUFFER - 64)
+        {
+            fwrite(buffer, 1, used, out);
+            used = 0;
+        }
+        if (timestamps)
+            used += sprintf(buffer + used, "%u,", (unsigned int)frame.timestamp);
+        used += rawFormatCandump(frame, buffer + used);
+        frames++;
+    }
+    fwrite(buffer, 1, used, out);
+    if (out != stdout && fclose(out) != 0)
+    {
+        fprintf(stderr, "Error writing %s\n", argv[arg + 1]);
+        return 1;
+    }
+    if (reader.damaged())
+    {
+        fprintf(stderr, "%lu frames, the capture is damaged: frames up to a key record were lost\n", frames);
+        return 1;
+    }
+    fprintf(stderr, "%lu frames\n", frames);
+    return 0;
+}
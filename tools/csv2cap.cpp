@@ -0,0 +1,54 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/csv2cap.cpp
+//
+// Converts text captures (any layout tools/host/raw_candump.h reads: raw_candump_*.csv and
+// candump_*.csv) into the binary capture format of include/can_capture.h. Lossless: ID,
+// extended flag, DLC, payload and timestamp all survive, cap2csv gives the text back.
+//
+// Usage: csv2cap capture.csv capture.cap
+// ==========================================================================================
+
+#include <stdio.h>
+
+#include "can_common.h"
+#include "capture_bin.h"
+#include "raw_candump.h"
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: csv2cap capture.csv capture.cap\n");
+        return 2;
+    }
+
+    RawCandumpReader reader;
+    if (!reader.open(argv[1]))
+    {
+        fprintf(stderr, "Can't read %s\n", argv[1]);
+        return 1;
+    }
+    CaptureBinWriter writer;
+    if (!writer.open(argv[2]))
+    {
+        fprintf(stderr, "Can't write %s\n", argv[2]);
+        return 1;
+    }
+
+    unsigned long frames = 0;
+    for (const CAN_FRAME &frame : reader)
+    {
+        writer.write(frame);
+        frames++;
+    }
+    size_t bytes = writer.bytesWritten();
+    if (!writer.close())
+    {
+        fprintf(stderr, "Error writing %s\n", argv[2]);
+        return 1;
+    }
+    fprintf(stderr, "%lu frames, %zu -> %zu bytes (%.1fx), %.1f bytes/frame\n", frames, reader.size(), bytes,
+            (double)reader.size() / bytes, frames ? (double)bytes / frames : 0.0);
+    return 0;
+}
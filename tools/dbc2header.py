@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+# ==========================================================================================
+# CANDISPLAY - a CANBUS display device
+# tools/dbc2header.py
+#
+# Turns a .dbc file into a header of constexpr descriptors for the firmware, so decoding
+# knowledge lives in the DBC and adding a signal is a data change. For every signal the
+# header provides
+#
+#   DBC_<FILE>_<MESSAGE>_<SIGNAL>(slot)   a CAN_SIGNAL entry (see include/can_signal.h) that
+#                                         decodes the signal into v[slot]
+#   DBC_<FILE>_<MESSAGE>_ID               the frame ID of every message
+#
+# plus DBC_MESSAGE / DBC_SIGNAL / DBC_VALUE tables with names, units, ranges and value
+# tables. Simple multiplexing (M / m<n>) is supported; extended multiplexing
+# (SG_MUL_VAL_) is not.
+#
+# Run by PlatformIO before every build through tools/pio_dbc.py, or by hand:
+#
+#   python3 tools/dbc2header.py dbc/abarth500.dbc include/dbc_abarth500.h
+# ==========================================================================================
+
+import os
+import re
+import sys
+
+RE_MESSAGE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+RE_SIGNAL = re.compile(r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                       r'\(\s*([^,]+)\s*,\s*([^)]+)\)\s*\[\s*([^|]+)\|([^\]]+)\]\s*"([^"]*)"')
+RE_VALUES = re.compile(r'^VAL_\s+(\d+)\s+(\w+)\s+(.*?);', re.M | re.S)
+RE_VALUE_PAIR = re.compile(r'(-?\d+)\s+"([^"]*)"')
+RE_COMMENT = re.compile(r'^CM_\s+SG_\s+(\d+)\s+(\w+)\s+"([^"]*)"\s*;', re.M | re.S)
+
+CAN_EXTENDED_FLAG = 0x80000000
+
+
+class DbcError(Exception):
+    pass
+
+
+class Signal:
+    def __init__(self, name, mux, start, length, order, signed, scale, offset, minimum, maximum, unit):
+        self.name = name
+        self.mux_role = 0
+        self.mux_value = 0
+        if mux == 'M':
+            self.mux_role = 1
+        elif mux:
+            self.mux_role = 2
+            self.mux_value = int(mux[1:])
+        self.start = start
+        self.length = length
+        self.big_endian = order == '0'
+        self.signed = signed == '-'
+        self.scale = scale
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.unit = unit
+        self.values = []
+        self.comment = ''
+
+
+class Message:
+    def __init__(self, raw_id, name, length):
+        self.extended = bool(raw_id & CAN_EXTENDED_FLAG)
+        self.id = raw_id & 0x1FFFFFFF
+        self.raw_id = raw_id
+        self.name = name
+        self.length = length
+        self.signals = []
+
+    def multiplexor(self):
+        for s in self.signals:
+            if s.mux_role == 1:
+                return s
+        return None
+
+
+def parse(text):
+    messages = {}
+    current = None
+
+    if 'SG_MUL_VAL_' in text:
+        raise DbcError('extended multiplexing (SG_MUL_VAL_) is not supported')
+
+    for number, line in enumerate(text.splitlines(), 1):
+        line = line.strip()
+        m = RE_MESSAGE.match(line)
+        if m:
+            current = Message(int(m.group(1)), m.group(2), int(m.group(3)))
+            messages[current.raw_id] = current
+            continue
+        m = RE_SIGNAL.match(line)
+        if m:
+            if current is None:
+                raise DbcError('line %d: signal outside of a message' % number)
+            current.signals.append(Signal(m.group(1), m.group(2), int(m.group(3)), int(m.group(4)), m.group(5),
+                                          m.group(6), float(m.group(7)), float(m.group(8)), float(m.group(9)),
+                                          float(m.group(10)), m.group(11)))
+            continue
+        if line.startswith('SG_'):
+            raise DbcError('line %d: can\'t parse signal: %s' % (number, line))
+        if line:
+            current = None
+
+    # value tables and comments may span lines, so they are matched on the whole text
+    for m in RE_VALUES.finditer(text):
+        signal = find_signal(messages, int(m.group(1)), m.group(2))
+        signal.values = [(int(v), d) for v, d in RE_VALUE_PAIR.findall(m.group(3))]
+
+    for m in RE_COMMENT.finditer(text):
+        find_signal(messages, int(m.group(1)), m.group(2)).comment = ' '.join(m.group(3).split())
+
+    for msg in messages.values():
+        muxes = [s for s in msg.signals if s.mux_role == 1]
+        if len(muxes) > 1:
+            raise DbcError('%s has more than one multiplexor' % msg.name)
+        for s in msg.signals:
+            if s.mux_role == 2 and not muxes:
+                raise DbcError('%s.%s is multiplexed but %s has no multiplexor' % (msg.name, s.name, msg.name))
+            check_layout(msg, s)
+    return sorted(messages.values(), key=lambda m: (m.id, m.extended))
+
+
+def find_signal(messages, raw_id, name):
+    msg = messages.get(raw_id)
+    if msg:
+        for s in msg.signals:
+            if s.name == name:
+                return s
+    raise DbcError('unknown signal %s in message %d' % (name, raw_id))
+
+
+def check_layout(msg, s):
+    # same rules as the static_asserts in CANSignalLayout, reported with names attached
+    if not 1 <= s.length <= 32:
+        raise DbcError('%s.%s: only signals of 1 to 32 bits can be decoded' % (msg.name, s.name))
+    if s.big_endian:
+        shift = (7 - s.start // 8) * 8 + s.start % 8 - (s.length - 1)
+    else:
+        shift = s.start
+    if shift < 0 or shift + s.length > 64:
+        raise DbcError('%s.%s runs past the 8 data bytes' % (msg.name, s.name))
+
+
+def ident(name):
+    return re.sub(r'[^A-Za-z0-9]', '_', name).upper()
+
+
+def c_float(value):
+    text = repr(float(value))
+    if 'e' not in text and '.' not in text:
+        text += '.0'
+    return text + 'f'
+
+
+def c_string(text):
+    return '"' + text.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def order_name(s):
+    return 'CAN_BIG_ENDIAN' if s.big_endian else 'CAN_LITTLE_ENDIAN'
+
+
+def generate(messages, source, prefix):
+    guard = '__DBC_%s__' % prefix
+    out = []
+    w = out.append
+
+    w('// ==========================================================================================')
+    w('// CANDISPLAY - a CANBUS display device')
+    w('// %s' % ('dbc_%s.h' % prefix.lower()))
+    w('//')
+    w('// Generated by tools/dbc2header.py from %s. Do not edit, change the DBC instead.' % source)
+    w('// ==========================================================================================')
+    w('')
+    w('#ifndef %s' % guard)
+    w('#define %s' % guard)
+    w('')
+    w('#include "can_signal.h"')
+    w('')
+    w('// ---- Frame IDs')
+    w('')
+    for msg in messages:
+        w('#define DBC_%s_%s_ID 0x%08X' % (prefix, ident(msg.name), msg.id))
+    w('')
+    w('// ---- CAN_SIGNAL entries, pass the value slot the signal should be decoded into')
+    for msg in messages:
+        mux = msg.multiplexor()
+        w('')
+        w('// %s (0x%X, %s)' % (msg.name, msg.id, 'extended' if msg.extended else 'standard'))
+        for s in msg.signals:
+            macro = 'DBC_%s_%s_%s(slot)' % (prefix, ident(msg.name), ident(s.name))
+            common = '0x%08X, %s, %d, %d, %s, %s, %s, %s' % (
+                msg.id, 'true' if msg.extended else 'false', s.start, s.length, order_name(s),
+                'true' if s.signed else 'false', c_float(s.scale), c_float(s.offset))
+            if s.comment:
+                w('// %s' % s.comment)
+            if s.mux_role == 2:
+                w('#define %s CAN_SIGNAL_MUX_DEF(%s, %d, %d, %s, %d, slot)' % (
+                    macro, common, mux.start, mux.length, order_name(mux), s.mux_value))
+            else:
+                w('#define %s CAN_SIGNAL_DEF(%s, slot)' % (macro, common))
+
+    w('')
+    w('// ---- Value tables')
+    w('')
+    for msg in messages:
+        for s in msg.signals:
+            if s.values:
+                w('constexpr DBC_VALUE dbc%sValues_%s_%s[] = {' % (prefix.title().replace('_', ''), msg.name, s.name))
+                for value, description in s.values:
+                    w('    {%d, %s},' % (value, c_string(description)))
+                w('};')
+
+    w('')
+    w('// ---- Signal and message descriptors')
+    w('')
+    table = 'dbc%s' % prefix.title().replace('_', '')
+    for msg in messages:
+        if not msg.signals:
+            continue
+        w('constexpr DBC_SIGNAL %sSignals_%s[] = {' % (table, msg.name))
+        for s in msg.signals:
+            values = '%sValues_%s_%s' % (table, msg.name, s.name) if s.values else 'nullptr'
+            w('    {%s, %d, %d, %s, %s, %s, %s, %s, %s, %s, %d, %d, %s, %d},' % (
+                c_string(s.name), s.start, s.length, order_name(s), 'true' if s.signed else 'false',
+                c_float(s.scale), c_float(s.offset), c_float(s.minimum), c_float(s.maximum), c_string(s.unit),
+                s.mux_role, s.mux_value, values, len(s.values)))
+        w('};')
+    w('')
+    w('constexpr DBC_MESSAGE %sMessages[] = {' % table)
+    for msg in messages:
+        signals = '%sSignals_%s' % (table, msg.name) if msg.signals else 'nullptr'
+        w('    {0x%08X, %s, %s, %d, %s, %d},' % (
+            msg.id, 'true' if msg.extended else 'false', c_string(msg.name), msg.length, signals,
+            len(msg.signals)))
+    w('};')
+    w('')
+    w('#define DBC_%s_MESSAGE_COUNT %d' % (prefix, len(messages)))
+    w('')
+    w('#endif')
+    return '\n'.join(out) + '\n'
+
+
+def convert(dbc_path, header_path):
+    with open(dbc_path, encoding='latin-1') as f:
+        messages = parse(f.read())
+    prefix = ident(os.path.splitext(os.path.basename(dbc_path))[0])
+    source = os.path.relpath(dbc_path, os.path.dirname(os.path.dirname(os.path.abspath(header_path))))
+    text = generate(messages, source.replace(os.sep, '/'), prefix)
+    with open(header_path, 'w', newline='\n') as f:
+        f.write(text)
+    return len(messages), sum(len(m.signals) for m in messages)
+
+
+def main(argv):
+    if len(argv) != 2:
+        print('usage: dbc2header.py file.dbc header.h', file=sys.stderr)
+        return 2
+    try:
+        messages, signals = convert(argv[0], argv[1])
+    except (DbcError, OSError) as e:
+        print('dbc2header: %s: %s' % (argv[0], e), file=sys.stderr)
+        return 1
+    print('dbc2header: %s -> %s (%d messages, %d signals)' % (argv[0], argv[1], messages, signals))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
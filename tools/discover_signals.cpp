@@ -0,0 +1,774 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/discover_signals.cpp
+//
+// Signal discovery for the IDs the DBC doesn't decode yet. Reads captures of any size
+// (every text layout of tools/host/raw_candump.h, or binary .cap files) and computes, for
+// every ID and every byte, bit and 16 bit field (both byte orders):
+//
+//   change rate    how often the field differs from the previous frame of the same ID
+//   entropy        of the byte values (bits: of the 0/1 split)
+//   counters       byte or nibble stepping by exactly +1 from frame to frame (rolling counter)
+//   checksums      byte equal to the sum, xor or CRC-8 (SAE J1850) of the other bytes
+//   smoothness     mean |step| over the range of values, small for physical signals
+//   correlation    Pearson r against a reference signal decoded with the DBC (engine speed by
+//                  default), holding its last value between reference frames
+//
+// and prints ranked candidate lists: fields that follow the reference, smooth signal-like
+// fields, counters and checksums, plus a table of IDs with their period.
+//
+// Text captures are memory mapped and split into line aligned chunks that all cores parse
+// and accumulate in parallel; each thread keeps its own statistics, merged at the end. The
+// per-frame work is straight-line loops over fixed arrays laid out column by column (one
+// array per statistic, one lane per byte or field), which the compiler vectorizes, and the
+// histograms the bit and entropy figures are derived from once at the end.
+//
+// Usage: discover_signals [-r Message.Signal] [-n top] [-j threads] capture ...
+// ==========================================================================================
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "can_common.h"
+#include "can_signal.h"
+#include "dbc_abarth500.h"
+#include "capture_bin.h"
+#include "raw_candump.h"
+
+#define DISCOVER_CHUNK (16u << 20)  // bytes of text per work item
+#define DISCOVER_TABLE 1024         // ID slots per thread, power of two
+#define DISCOVER_WORDS 14           // 16 bit fields: bytes n,n+1 little endian (0-6), big endian (7-13)
+#define DISCOVER_COLUMNS (8 + DISCOVER_WORDS)
+#define DISCOVER_DEFAULT_TOP 20
+#define DISCOVER_MIN_SAMPLES 30      // frames of an ID (with a reference value, for r) before it is ranked
+
+typedef std::chrono::steady_clock Clock;
+
+// ---- Reference signal, decoded at run time from the DBC descriptors
+
+struct Reference
+{
+    const DBC_MESSAGE *message;
+    const DBC_SIGNAL *signal;
+    const DBC_SIGNAL *mux; // multiplexor of the message when the signal is multiplexed
+};
+
+static int64_t dbcRaw(const DBC_SIGNAL &s, const uint8_t *data)
+{
+    uint64_t word = s.order == CAN_LITTLE_ENDIAN ? canPayloadLE(data) : canPayloadBE(data);
+    int shift = s.order == CAN_LITTLE_ENDIAN ? s.start : (7 - s.start / 8) * 8 + s.start % 8 - (s.length - 1);
+    uint64_t raw = (word >> shift) & ((1ull << s.length) - 1);
+    if (s.isSigned && (raw >> (s.length - 1)))
+        return (int64_t)raw - (1ll << s.length);
+    return (int64_t)raw;
+}
+
+static bool referenceFind(const char *spec, Reference &ref)
+{
+    const char *dot = strchr(spec, '.');
+    if (!dot)
+        return false;
+    std::string message(spec, dot - spec);
+    for (int m = 0; m < DBC_ABARTH500_MESSAGE_COUNT; m++)
+    {
+        const DBC_MESSAGE &msg = dbcAbarth500Messages[m];
+        if (message != msg.name)
+            continue;
+        ref.message = &msg;
+        ref.signal = ref.mux = NULL;
+        for (int i = 0; i < msg.signalCount; i++)
+        {
+            if (!strcmp(msg.signals[i].name, dot + 1))
+                ref.signal = &msg.signals[i];
+            if (msg.signals[i].muxRole == DBC_MUX_MULTIPLEXOR)
+                ref.mux = &msg.signals[i];
+        }
+        if (ref.signal && ref.signal->muxRole != DBC_MUX_MULTIPLEXED)
+            ref.mux = NULL;
+        return ref.signal != NULL;
+    }
+    return false;
+}
+
+// Physical value of the reference if this frame carries it
+static bool referenceDecode(const Reference &ref, const CAN_FRAME &frame, double &value)
+{
+    if (frame.id != ref.message->id || (bool)frame.extended != ref.message->extended)
+        return false;
+    if (ref.mux && dbcRaw(*ref.mux, frame.data.byte) != ref.signal->muxValue)
+        return false;
+    value = dbcRaw(*ref.signal, frame.data.byte) * ref.signal->scale + ref.signal->offset;
+    return true;
+}
+
+// ---- Per-ID accumulators
+
+static uint8_t crc8Table[256];
+
+static void crc8Init()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t c = (uint8_t)i;
+        for (int b = 0; b < 8; b++)
+            c = (uint8_t)(c & 0x80 ? (c << 1) ^ 0x1D : c << 1);
+        crc8Table[i] = c;
+    }
+}
+
+// SAE J1850 CRC-8 of data[from, to)
+static uint8_t crc8(const uint8_t *data, int from, int to)
+{
+    uint8_t c = 0xFF;
+    for (int i = from; i < to; i++)
+        c = crc8Table[c ^ data[i]];
+    return (uint8_t)(c ^ 0xFF);
+}
+
+struct IdStats
+{
+    uint32_t key; // ID | extended << 31
+    uint8_t dlc;
+    bool hasPrevious;
+    uint8_t previous[8];
+    uint32_t previousTimestamp;
+    uint16_t previousWord[DISCOVER_WORDS];
+
+    uint64_t frames;
+    uint64_t steps; // frames with a previous one in the same chunk
+    uint64_t periods;
+    double periodSum;
+    double periodSquares;
+
+    // columns: one lane per byte
+    uint32_t valueHistogram[8][256];
+    uint32_t changeHistogram[8][256]; // of previous ^ current, bit toggles come from it
+    uint32_t byteCounter[8];          // byte stepped by +1 (mod 256)
+    uint32_t lowNibbleCounter[8];     // low nibble stepped by +1 (mod 16)
+    uint32_t highNibbleCounter[8];    // high nibble stepped by +1 (mod 16)
+    uint32_t sumMatch[8];             // byte == sum of the other bytes (mod 256)
+    uint32_t xorMatch[8];             // byte == xor of the other bytes
+    uint32_t crcFirst;                // byte 0 == CRC-8 of bytes 1..dlc-1
+    uint32_t crcLast;                 // last byte == CRC-8 of the ones before
+    double byteAbsStep[8];
+
+    // columns: one lane per 16 bit field
+    uint32_t wordChanges[DISCOVER_WORDS];
+    uint32_t wordUp[DISCOVER_WORDS];
+    uint32_t wordDown[DISCOVER_WORDS];
+    uint16_t wordMin[DISCOVER_WORDS];
+    uint16_t wordMax[DISCOVER_WORDS];
+    double wordAbsStep[DISCOVER_WORDS];
+
+    // correlation with the reference: bytes first, then the 16 bit fields
+    uint64_t referenced;
+    double sy, syy;
+    double sx[DISCOVER_COLUMNS];
+    double sxx[DISCOVER_COLUMNS];
+    double sxy[DISCOVER_COLUMNS];
+};
+
+class Analyzer
+{
+public:
+    Analyzer(const Reference &r) : ref(r) { clear(); }
+
+    void clear()
+    {
+        stats.clear();
+        stats.reserve(64);
+        memset(slots, 0, sizeof(slots));
+        haveReference = false;
+        reference = 0;
+        frames = 0;
+        textBytes = 0;
+    }
+
+    // A new chunk: nothing carries over from the previous frames
+    void restart()
+    {
+        for (IdStats &s : stats)
+            s.hasPrevious = false;
+        haveReference = false;
+    }
+
+    void add(const CAN_FRAME &frame)
+    {
+        double value;
+        if (referenceDecode(ref, frame, value))
+        {
+            reference = value;
+            haveReference = true;
+        }
+        update(find(frame), frame);
+        frames++;
+    }
+
+    // Adds everything other collected
+    void merge(const Analyzer &other)
+    {
+        for (const IdStats &o : other.stats)
+        {
+            CAN_FRAME probe;
+            probe.id = o.key & 0x1FFFFFFF;
+            probe.extended = o.key >> 31;
+            IdStats &s = find(probe);
+            if (o.dlc > s.dlc)
+                s.dlc = o.dlc;
+            s.frames += o.frames;
+            s.steps += o.steps;
+            s.periods += o.periods;
+            s.periodSum += o.periodSum;
+            s.periodSquares += o.periodSquares;
+            for (int b = 0; b < 8; b++)
+            {
+                for (int v = 0; v < 256; v++)
+                {
+                    s.valueHistogram[b][v] += o.valueHistogram[b][v];
+                    s.changeHistogram[b][v] += o.changeHistogram[b][v];
+                }
+                s.byteCounter[b] += o.byteCounter[b];
+                s.lowNibbleCounter[b] += o.lowNibbleCounter[b];
+                s.highNibbleCounter[b] += o.highNibbleCounter[b];
+                s.sumMatch[b] += o.sumMatch[b];
+                s.xorMatch[b] += o.xorMatch[b];
+                s.byteAbsStep[b] += o.byteAbsStep[b];
+            }
+            s.crcFirst += o.crcFirst;
+            s.crcLast += o.crcLast;
+            for (int w = 0; w < DISCOVER_WORDS; w++)
+            {
+                s.wordChanges[w] += o.wordChanges[w];
+                s.wordUp[w] += o.wordUp[w];
+                s.wordDown[w] += o.wordDown[w];
+                s.wordMin[w] = std::min(s.wordMin[w], o.wordMin[w]);
+                s.wordMax[w] = std::max(s.wordMax[w], o.wordMax[w]);
+                s.wordAbsStep[w] += o.wordAbsStep[w];
+            }
+            s.referenced += o.referenced;
+            s.sy += o.sy;
+            s.syy += o.syy;
+            for (int c = 0; c < DISCOVER_COLUMNS; c++)
+            {
+                s.sx[c] += o.sx[c];
+                s.sxx[c] += o.sxx[c];
+                s.sxy[c] += o.sxy[c];
+            }
+        }
+        frames += other.frames;
+        textBytes += other.textBytes;
+    }
+
+    const Reference &ref;
+    std::vector<IdStats> stats;
+    uint64_t frames;
+    uint64_t textBytes;
+
+private:
+    static uint32_t keyOf(const CAN_FRAME &frame) { return (frame.id & 0x1FFFFFFF) | (frame.extended ? 1u << 31 : 0); }
+
+    IdStats &find(const CAN_FRAME &frame)
+    {
+        uint32_t key = keyOf(frame);
+        uint32_t pos = (key * 2654435761u) >> 22; // top 10 bits index DISCOVER_TABLE
+        for (;; pos = (pos + 1) & (DISCOVER_TABLE - 1))
+        {
+            if (!slots[pos])
+                break;
+            if (stats[slots[pos] - 1].key == key)
+                return stats[slots[pos] - 1];
+        }
+        if (stats.size() >= DISCOVER_TABLE / 2)
+        {
+            fprintf(stderr, "More than %d IDs, is this a CAN capture?\n", DISCOVER_TABLE / 2);
+            exit(1);
+        }
+        stats.emplace_back();
+        IdStats &s = stats.back();
+        memset(&s, 0, sizeof(s));
+        s.key = key;
+        for (int w = 0; w < DISCOVER_WORDS; w++)
+            s.wordMin[w] = 0xFFFF;
+        slots[pos] = (uint16_t)stats.size();
+        return s;
+    }
+
+    void update(IdStats &s, const CAN_FRAME &frame)
+    {
+        uint8_t d[8] = {0};
+        int dlc = frame.length > 8 ? 8 : frame.length;
+        memcpy(d, frame.data.byte, dlc);
+        if (dlc > s.dlc)
+            s.dlc = (uint8_t)dlc;
+        s.frames++;
+
+        uint16_t word[DISCOVER_WORDS];
+        for (int i = 0; i < 7; i++)
+        {
+            word[i] = (uint16_t)(d[i] | d[i + 1] << 8);
+            word[7 + i] = (uint16_t)(d[i] << 8 | d[i + 1]);
+        }
+
+        uint8_t sum = 0, parity = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            s.valueHistogram[i][d[i]]++;
+            sum += d[i];
+            parity ^= d[i];
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            s.sumMatch[i] += (uint8_t)(sum - d[i]) == d[i];
+            s.xorMatch[i] += (uint8_t)(parity ^ d[i]) == d[i];
+        }
+        if (dlc > 1)
+        {
+            s.crcFirst += crc8(d, 1, dlc) == d[0];
+            s.crcLast += crc8(d, 0, dlc - 1) == d[dlc - 1];
+        }
+        for (int w = 0; w < DISCOVER_WORDS; w++)
+        {
+            s.wordMin[w] = std::min(s.wordMin[w], word[w]);
+            s.wordMax[w] = std::max(s.wordMax[w], word[w]);
+        }
+
+        if (s.hasPrevious)
+        {
+            s.steps++;
+            for (int i = 0; i < 8; i++)
+            {
+                uint8_t p = s.previous[i];
+                s.changeHistogram[i][p ^ d[i]]++;
+                s.byteCounter[i] += (uint8_t)(d[i] - p) == 1;
+                s.lowNibbleCounter[i] += ((d[i] - p) & 0x0F) == 1;
+                s.highNibbleCounter[i] += (((d[i] >> 4) - (p >> 4)) & 0x0F) == 1;
+                s.byteAbsStep[i] += abs(d[i] - p);
+            }
+            for (int w = 0; w < DISCOVER_WORDS; w++)
+            {
+                int step = word[w] - s.previousWord[w];
+                s.wordChanges[w] += step != 0;
+                s.wordUp[w] += step > 0;
+                s.wordDown[w] += step < 0;
+                s.wordAbsStep[w] += abs(step);
+            }
+            uint32_t period = frame.timestamp - s.previousTimestamp;
+            s.periods++;
+            s.periodSum += period;
+            s.periodSquares += (double)period * period;
+        }
+
+        if (haveReference)
+        {
+            double x[DISCOVER_COLUMNS];
+            for (int i = 0; i < 8; i++)
+                x[i] = d[i];
+            for (int w = 0; w < DISCOVER_WORDS; w++)
+                x[8 + w] = word[w];
+            double y = reference;
+            s.referenced++;
+            s.sy += y;
+            s.syy += y * y;
+            for (int c = 0; c < DISCOVER_COLUMNS; c++)
+            {
+                s.sx[c] += x[c];
+                s.sxx[c] += x[c] * x[c];
+                s.sxy[c] += x[c] * y;
+            }
+        }
+
+        memcpy(s.previous, d, 8);
+        memcpy(s.previousWord, word, sizeof(word));
+        s.previousTimestamp = frame.timestamp;
+        s.hasPrevious = true;
+    }
+
+    uint16_t slots[DISCOVER_TABLE]; // index + 1 into stats, 0 is free
+    bool haveReference;
+    double reference;
+};
+
+// ---- Reading
+
+// Text captures: line aligned chunks handed out to the threads as they finish the previous one
+static bool analyzeText(const char *path, std::vector<Analyzer *> &workers)
+{
+    RawCandumpReader probe;
+    if (!probe.open(path))
+        return false;
+    size_t size = probe.size();
+    probe.close();
+
+    std::atomic<size_t> nextChunk(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (Analyzer *a : workers)
+        threads.emplace_back([&, a]() {
+            RawCandumpReader reader;
+            if (!reader.open(path))
+            {
+                failed = true;
+                return;
+            }
+            for (size_t from; (from = nextChunk.fetch_add(DISCOVER_CHUNK)) < size;)
+            {
+                reader.limit(from, from + DISCOVER_CHUNK);
+                a->restart();
+                CAN_FRAME frame;
+                while (reader.next(frame))
+                    a->add(frame);
+            }
+        });
+    for (std::thread &t : threads)
+        t.join();
+    workers[0]->textBytes += size;
+    return !failed;
+}
+
+// Binary captures are one delta coded stream, read by a single thread
+static bool analyzeBinary(const char *path, Analyzer &a)
+{
+    CaptureBinReader reader;
+    if (!reader.open(path))
+        return false;
+    a.restart();
+    CAN_FRAME frame;
+    while (reader.next(frame))
+        a.add(frame);
+    if (reader.damaged())
+        fprintf(stderr, "%s is damaged, read up to the damage\n", path);
+    FILE *f = fopen(path, "rb");
+    if (f)
+    {
+        fseek(f, 0, SEEK_END);
+        a.textBytes += ftell(f);
+        fclose(f);
+    }
+    return true;
+}
+
+static bool isBinaryCapture(const char *path)
+{
+    uint8_t header[CAN_CAPTURE_HEADER_SIZE];
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    size_t n = fread(header, 1, sizeof(header), f);
+    fclose(f);
+    return canCaptureIsHeader(header, n);
+}
+
+// ---- Report
+
+struct Candidate
+{
+    const IdStats *id;
+    char field[16];
+    double score;
+    double changeRate;
+    double entropy;
+    double correlation;
+    double smoothness;
+    int minimum;
+    int maximum;
+};
+
+static double correlation(const IdStats &s, int c)
+{
+    double n = (double)s.referenced;
+    if (n < 2)
+        return 0;
+    double vx = n * s.sxx[c] - s.sx[c] * s.sx[c];
+    double vy = n * s.syy - s.sy * s.sy;
+    if (vx <= 0 || vy <= 0)
+        return 0;
+    return (n * s.sxy[c] - s.sx[c] * s.sy) / sqrt(vx * vy);
+}
+
+static double byteEntropy(const IdStats &s, int b)
+{
+    double h = 0;
+    for (int v = 0; v < 256; v++)
+        if (s.valueHistogram[b][v])
+        {
+            double p = (double)s.valueHistogram[b][v] / s.frames;
+            h -= p * log2(p);
+        }
+    return h;
+}
+
+static double ratio(uint64_t part, uint64_t whole)
+{
+    return whole ? (double)part / whole : 0;
+}
+
+static void formatId(const IdStats &s, char *out)
+{
+    sprintf(out, s.key >> 31 ? "0x%08X" : "0x%03X", s.key & 0x1FFFFFFF);
+}
+
+// Byte n of a frame of this ID never changed and always held the same value
+static bool constantByte(const IdStats &s, int b)
+{
+    return s.changeHistogram[b][0] == s.steps;
+}
+
+static void collect(const IdStats &s, std::vector<Candidate> &fields)
+{
+    for (int b = 0; b < s.dlc; b++)
+    {
+        Candidate c;
+        c.id = &s;
+        sprintf(c.field, "byte %d", b);
+        c.changeRate = 1 - ratio(s.changeHistogram[b][0], s.steps);
+        c.entropy = byteEntropy(s, b);
+        c.correlation = correlation(s, b);
+        c.minimum = 255;
+        c.maximum = 0;
+        for (int v = 0; v < 256; v++)
+            if (s.valueHistogram[b][v])
+            {
+                c.minimum = std::min(c.minimum, v);
+                c.maximum = std::max(c.maximum, v);
+            }
+        c.smoothness = c.maximum > c.minimum && s.steps ? s.byteAbsStep[b] / s.steps / (c.maximum - c.minimum) : 1;
+        c.score = 0;
+        fields.push_back(c);
+    }
+    for (int w = 0; w < DISCOVER_WORDS; w++)
+    {
+        int first = w % 7;
+        if (first + 1 >= s.dlc || constantByte(s, first) || constantByte(s, first + 1))
+            continue; // a 16 bit field with a constant half is just its other byte
+        Candidate c;
+        c.id = &s;
+        sprintf(c.field, "%s %d-%d", w < 7 ? "le16" : "be16", first, first + 1);
+        c.changeRate = ratio(s.wordChanges[w], s.steps);
+        c.entropy = -1;
+        c.correlation = correlation(s, 8 + w);
+        c.minimum = s.wordMin[w];
+        c.maximum = s.wordMax[w];
+        c.smoothness = c.maximum > c.minimum && s.steps ? s.wordAbsStep[w] / s.steps / (c.maximum - c.minimum) : 1;
+        c.score = 0;
+        fields.push_back(c);
+    }
+}
+
+// Best counter or checksum explanation of byte b, "" if none fits. A few frames fit some
+// pattern by chance (two frames are always a 100% counter), so short-lived IDs get none.
+static const char *byteRole(const IdStats &s, int b, double &fraction)
+{
+    static const double threshold = 0.9;
+    fraction = 0;
+    if (s.frames < DISCOVER_MIN_SAMPLES || !s.steps || constantByte(s, b))
+        return "";
+    struct
+    {
+        const char *name;
+        double value;
+    } roles[] = {
+        {"counter", ratio(s.byteCounter[b], s.steps)},
+        {"counter (low nibble)", ratio(s.lowNibbleCounter[b], s.steps)},
+        {"counter (high nibble)", ratio(s.highNibbleCounter[b], s.steps)},
+        {"checksum (sum)", ratio(s.sumMatch[b], s.frames)},
+        {"checksum (xor)", ratio(s.xorMatch[b], s.frames)},
+        {"checksum (CRC-8 J1850)", b == 0 ? ratio(s.crcFirst, s.frames) : b == s.dlc - 1 ? ratio(s.crcLast, s.frames) : 0},
+    };
+    const char *best = "";
+    for (auto &r : roles)
+        if (r.value >= threshold && r.value > fraction)
+        {
+            fraction = r.value;
+            best = r.name;
+        }
+    return best;
+}
+
+static void printCandidates(const char *title, std::vector<Candidate> &fields, size_t top)
+{
+    printf("\n%s\n", title);
+    printf("  ID          field       change  entropy      min      max  smooth      r\n");
+    for (size_t i = 0; i < fields.size() && i < top; i++)
+    {
+        const Candidate &c = fields[i];
+        char id[16], entropy[16];
+        formatId(*c.id, id);
+        if (c.entropy < 0)
+            strcpy(entropy, "-");
+        else
+            sprintf(entropy, "%.2f", c.entropy);
+        printf("  %-11s %-10s %6.1f%% %8s %8d %8d %7.3f %+6.3f\n", id, c.field, c.changeRate * 100, entropy, c.minimum,
+               c.maximum, c.smoothness, c.correlation);
+    }
+    if (fields.empty())
+        printf("  (none)\n");
+}
+
+static void report(const Analyzer &a, size_t top)
+{
+    std::vector<const IdStats *> ids;
+    for (const IdStats &s : a.stats)
+        ids.push_back(&s);
+    std::sort(ids.begin(), ids.end(), [](const IdStats *x, const IdStats *y) { return x->key < y->key; });
+
+    printf("\nIDs\n");
+    printf("  ID           frames  dlc  period ms  jitter ms  changing bytes  bit changes per byte\n");
+    for (const IdStats *s : ids)
+    {
+        char id[16], changing[9], bits[80];
+        formatId(*s, id);
+        double mean = s->periods ? s->periodSum / s->periods : 0;
+        double jitter = s->periods ? sqrt(std::max(0.0, s->periodSquares / s->periods - mean * mean)) : 0;
+        char *p = bits;
+        for (int b = 0; b < 8; b++)
+        {
+            changing[b] = b >= s->dlc ? ' ' : constantByte(*s, b) ? '.' : 'x';
+            // bits that toggled at least once, from the xor histogram
+            uint8_t toggled = 0;
+            for (int v = 1; v < 256; v++)
+                if (s->changeHistogram[b][v])
+                    toggled |= (uint8_t)v;
+            if (b < s->dlc)
+                p += sprintf(p, "%02X ", toggled);
+        }
+        changing[8] = 0;
+        printf("  %-11s %7llu %4d %10.2f %10.2f  %-14s  %s\n", id, (unsigned long long)s->frames, s->dlc, mean / 1000,
+               jitter / 1000, changing, bits);
+    }
+
+    std::vector<Candidate> fields;
+    for (const IdStats *s : ids)
+        collect(*s, fields);
+
+    // ---- follows the reference
+    std::vector<Candidate> correlated;
+    for (const Candidate &c : fields)
+        if (c.changeRate > 0 && c.id->referenced >= DISCOVER_MIN_SAMPLES && c.id->key != (a.ref.message->id | (a.ref.message->extended ? 1u << 31 : 0)))
+            correlated.push_back(c);
+    std::sort(correlated.begin(), correlated.end(),
+              [](const Candidate &x, const Candidate &y) { return fabs(x.correlation) > fabs(y.correlation); });
+    char title[160];
+    sprintf(title, "Fields following %s.%s (by |r|, its own message left out)", a.ref.message->name, a.ref.signal->name);
+    printCandidates(title, correlated, top);
+
+    // ---- smooth, signal-like
+    std::vector<Candidate> smooth;
+    for (const Candidate &c : fields)
+    {
+        double fraction;
+        bool isByte = c.entropy >= 0;
+        int b = isByte ? atoi(c.field + 5) : -1;
+        if (c.id->frames < DISCOVER_MIN_SAMPLES || c.changeRate < 0.01 || c.maximum - c.minimum < 8 ||
+            (isByte && *byteRole(*c.id, b, fraction)))
+            continue;
+        smooth.push_back(c);
+    }
+    std::sort(smooth.begin(), smooth.end(), [](const Candidate &x, const Candidate &y) { return x.smoothness < y.smoothness; });
+    printCandidates("Signal-like fields (changing, wide range, small steps: by smoothness)", smooth, top);
+
+    // ---- counters and checksums
+    printf("\nCounters and checksums (byte matches the pattern in >= 90%% of frames)\n");
+    int found = 0;
+    for (const IdStats *s : ids)
+        for (int b = 0; b < s->dlc; b++)
+        {
+            double fraction;
+            const char *role = byteRole(*s, b, fraction);
+            if (!*role)
+                continue;
+            char id[16];
+            formatId(*s, id);
+            printf("  %-11s byte %d  %-24s %5.1f%%\n", id, b, role, fraction * 100);
+            found++;
+        }
+    if (!found)
+        printf("  (none)\n");
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: discover_signals [-r Message.Signal] [-n top] [-j threads] capture ...\n"
+                    "  -r  reference signal from dbc/abarth500.dbc (default EngineStatus.EngineSpeed)\n"
+                    "  -n  candidates per list (default %d)\n"
+                    "  -j  threads (default: all cores)\n",
+            DISCOVER_DEFAULT_TOP);
+}
+
+int main(int argc, char **argv)
+{
+    const char *refSpec = "EngineStatus.EngineSpeed";
+    size_t top = DISCOVER_DEFAULT_TOP;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:j:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            refSpec = optarg;
+            break;
+        case 'n':
+            top = (size_t)atol(optarg);
+            break;
+        case 'j':
+            threads = (unsigned int)atoi(optarg);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (optind >= argc || threads < 1)
+    {
+        usage();
+        return 2;
+    }
+
+    Reference ref;
+    if (!referenceFind(refSpec, ref))
+    {
+        fprintf(stderr, "No signal %s in the DBC\n", refSpec);
+        return 2;
+    }
+    crc8Init();
+
+    std::vector<Analyzer *> workers;
+    for (unsigned int i = 0; i < threads; i++)
+        workers.push_back(new Analyzer(ref));
+
+    auto start = Clock::now();
+    for (int i = optind; i < argc; i++)
+    {
+        bool ok = isBinaryCapture(argv[i]) ? analyzeBinary(argv[i], *workers[0]) : analyzeText(argv[i], workers);
+        if (!ok)
+            fprintf(stderr, "Can't read %s\n", argv[i]);
+    }
+    for (unsigned int i = 1; i < threads; i++)
+        workers[0]->merge(*workers[i]);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const Analyzer &all = *workers[0];
+    if (!all.frames)
+    {
+        fprintf(stderr, "No frames read\n");
+        return 1;
+    }
+    printf("%llu frames, %zu IDs from %.1f MB in %.2f s (%.0f MB/s, %u threads), reference %s\n",
+           (unsigned long long)all.frames, all.stats.size(), all.textBytes / 1048576.0, seconds,
+           all.textBytes / 1048576.0 / seconds, threads, refSpec);
+    report(all, top);
+
+    for (Analyzer *a : workers)
+        delete a;
+    return 0;
+}
@@ -0,0 +1,47 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/host/can_common.h
+//
+// Host-side stand-in for collin80/can_common so that the portable pieces of the CAN
+// library (and the host tools) can be compiled off-device. Only the frame layout is
+// reproduced here.
+// ==========================================================================================
+
+#ifndef __HOST_CAN_COMMON__
+#define __HOST_CAN_COMMON__
+
+#include <stdint.h>
+#include <string.h>
+
+typedef union {
+    uint64_t value;
+    struct {
+        uint32_t low;
+        uint32_t high;
+    };
+    struct {
+        uint16_t s0;
+        uint16_t s1;
+        uint16_t s2;
+        uint16_t s3;
+    };
+    uint8_t bytes[8];
+    uint8_t byte[8];
+} BytesUnion;
+
+class CAN_FRAME
+{
+public:
+    CAN_FRAME() { memset(this, 0, sizeof(*this)); }
+
+    BytesUnion data;    // 64 bits - lots of ways to access it.
+    uint32_t id;        // 29 bit if ide set, 11 bit otherwise
+    uint32_t fid;       // family ID - used internally to library
+    uint32_t timestamp; // microseconds when the frame was received
+    uint8_t rtr;        // Remote Transmission Request (1 = RTR, 0 = data frame)
+    uint8_t priority;   // Priority but only important for TX frames
+    uint8_t extended;   // Extended ID flag
+    uint8_t length;     // Number of data bytes
+};
+
+#endif
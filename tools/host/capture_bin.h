@@ -0,0 +1,194 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/host/capture_bin.h
+//
+// File side of the binary capture format (include/can_capture.h) for the host tools:
+// CaptureBinWriter appends frames to a file through a 64 KB buffer, CaptureBinReader
+// streams them back, refilling its buffer as records run past the end of it. A damaged
+// stream is picked up again at the next key record.
+// ==========================================================================================
+
+#ifndef __HOST_CAPTURE_BIN__
+#define __HOST_CAPTURE_BIN__
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "can_common.h"
+#include "can_capture.h"
+
+#define CAPTURE_BIN_BUFFER 65536
+
+class CaptureBinWriter
+{
+public:
+    CaptureBinWriter() : file(NULL), used(0), total(0) {}
+    ~CaptureBinWriter() { close(); }
+
+    bool open(const char *path)
+    {
+        close();
+        file = fopen(path, "wb");
+        if (!file)
+            return false;
+        used = canCaptureHeader(buffer);
+        total = used;
+        return true;
+    }
+
+    void write(const CAN_FRAME &frame)
+    {
+        if (used > CAPTURE_BIN_BUFFER - CAN_CAPTURE_MAX_RECORD)
+            flush();
+        size_t n = encoder.encode(frame, buffer + used);
+        used += n;
+        total += n;
+    }
+
+    // Returns false if anything failed to reach the disk
+    bool close()
+    {
+        if (!file)
+            return true;
+        flush();
+        bool ok = !ferror(file);
+        ok = fclose(file) == 0 && ok;
+        file = NULL;
+        return ok;
+    }
+
+    size_t bytesWritten() const { return total; }
+
+private:
+    void flush()
+    {
+        fwrite(buffer, 1, used, file);
+        used = 0;
+    }
+
+    CANCaptureWriter encoder;
+    FILE *file;
+    uint8_t buffer[CAPTURE_BIN_BUFFER];
+    size_t used;
+    size_t total;
+};
+
+class CaptureBinReader
+{
+public:
+    CaptureBinReader() : file(NULL), pos(0), filled(0), corrupt(false) {}
+    ~CaptureBinReader() { close(); }
+
+    // Fails if the file can't be opened or doesn't start with a capture header
+    bool open(const char *path)
+    {
+        close();
+        file = fopen(path, "rb");
+        if (!file)
+            return false;
+        refill();
+        if (!canCaptureIsHeader(buffer, filled))
+        {
+            close();
+            return false;
+        }
+        pos = CAN_CAPTURE_HEADER_SIZE;
+        return true;
+    }
+
+    void close()
+    {
+        if (file)
+            fclose(file);
+        file = NULL;
+        pos = filled = 0;
+        corrupt = false;
+        decoder.clear();
+    }
+
+    bool next(CAN_FRAME &frame)
+    {
+        while (file)
+        {
+            bool isFrame;
+            int n = decoder.next(buffer + pos, filled - pos, frame, isFrame);
+            if (n > 0)
+            {
+                pos += n;
+                if (isFrame)
+                    return true;
+            }
+            else if (n == CAN_CAPTURE_MORE && refill())
+                continue;
+            else if (n == CAN_CAPTURE_ERROR && skipToKey())
+                corrupt = true;
+            else
+            {
+                corrupt = corrupt || n == CAN_CAPTURE_ERROR || pos < filled; // a truncated last record counts too
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // True if records were skipped or the last one was cut off
+    bool damaged() const { return corrupt; }
+
+private:
+    // Past the record that failed to decode, to the next key record. False if there is none.
+    bool skipToKey()
+    {
+        pos++;
+        for (;;)
+        {
+            size_t at = canCaptureFindKey(buffer + pos, filled - pos);
+            if (at < filled - pos)
+            {
+                pos += at;
+                return true;
+            }
+            if (filled - pos >= CAN_CAPTURE_KEY_SIZE)
+                pos = filled - (CAN_CAPTURE_KEY_SIZE - 1); // a key may start in the last bytes
+            if (!refill())
+                return false;
+        }
+    }
+
+    // Moves the unread tail to the front and reads more. False at the end of the file.
+    bool refill()
+    {
+        memmove(buffer, buffer + pos, filled - pos);
+        filled -= pos;
+        pos = 0;
+        size_t n = fread(buffer + filled, 1, CAPTURE_BIN_BUFFER - filled, file);
+        filled += n;
+        return n > 0;
+    }
+
+    CANCaptureReader decoder;
+    FILE *file;
+    uint8_t buffer[CAPTURE_BIN_BUFFER];
+    size_t pos;
+    size_t filled;
+    bool corrupt;
+};
+
+// Appends every frame of a binary capture to frames. Returns the number read or -1 if the
+// file can't be opened or isn't a capture.
+inline long captureBinLoadFile(const char *path, std::vector<CAN_FRAME> &frames)
+{
+    CaptureBinReader reader;
+    CAN_FRAME frame;
+    long count = 0;
+
+    if (!reader.open(path))
+        return -1;
+    while (reader.next(frame))
+    {
+        frames.push_back(frame);
+        count++;
+    }
+    return count;
+}
+
+#endif
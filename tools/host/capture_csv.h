@@ -0,0 +1,130 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/host/capture_csv.h
+//
+// Loader for the capture files in the repository root. Understands all the layouts we
+// have produced so far:
+//
+//   candump_*.csv      0x0220A006,8,0x80,...,0x00,128,...,000   (DLC, hex and decimal bytes)
+//   candump_*.csv      0x0628A001,0,36,0,128,5,0,0,32          (decimal bytes only)
+//   raw_candump_*.csv  0x0628A001<TAB>0<TAB>36...              (decimal bytes only)
+//   raw_candump_*.csv  log_out() lines, "... | CANBUS | New extended frame from 0x... DLC 8 Data 0x.. ..."
+//
+// Only the log_out() layout carries a (one second resolution) timestamp, which is stored
+// in microseconds relative to the first frame. Other layouts get timestamp 0.
+// ==========================================================================================
+
+#ifndef __HOST_CAPTURE_CSV__
+#define __HOST_CAPTURE_CSV__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "can_common.h"
+
+static bool captureParseLogTime(const char *line, long *seconds)
+{
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    if (sscanf(line, "%d-%d-%d %d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday,
+               &t.tm_hour, &t.tm_min, &t.tm_sec) != 6)
+        return false;
+    *seconds = ((((long)t.tm_mday * 24 + t.tm_hour) * 60) + t.tm_min) * 60 + t.tm_sec;
+    return true;
+}
+
+// Parses one capture line into frame. Returns false for lines that don't hold a frame.
+static bool captureParseLine(const char *line, CAN_FRAME &frame, long *seconds)
+{
+    char tok[32][16];
+    int n = 0;
+    const char *p = strstr(line, " from ");
+
+    frame = CAN_FRAME();
+    *seconds = -1;
+
+    if (p) // log_out() layout
+    {
+        captureParseLogTime(line, seconds);
+        p += 6;
+    }
+    else
+        p = line;
+
+    while (*p && n < 32)
+    {
+        while (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+            p++;
+        if (!*p)
+            break;
+        int len = 0;
+        while (*p && *p != ',' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+        {
+            if (len < 15)
+                tok[n][len++] = *p;
+            p++;
+        }
+        tok[n][len] = 0;
+        if (strcmp(tok[n], "DLC") && strcmp(tok[n], "Data"))
+            n++;
+    }
+
+    if (n < 1 || strncmp(tok[0], "0x", 2) != 0)
+        return false;
+
+    frame.id = (uint32_t)strtoul(tok[0], NULL, 16);
+    frame.extended = (frame.id > 0x7FF || strlen(tok[0]) > 5) ? 1 : 0;
+
+    if (n >= 3 && strncmp(tok[2], "0x", 2) == 0) // DLC followed by hex bytes
+    {
+        int dlc = atoi(tok[1]);
+        if (dlc > 8 || n < 2 + dlc)
+            return false;
+        frame.length = dlc;
+        for (int i = 0; i < dlc; i++)
+            frame.data.byte[i] = (uint8_t)strtoul(tok[2 + i], NULL, 16);
+    }
+    else // decimal bytes only
+    {
+        int dlc = n - 1 > 8 ? 8 : n - 1;
+        frame.length = dlc;
+        for (int i = 0; i < dlc; i++)
+            frame.data.byte[i] = (uint8_t)strtoul(tok[1 + i], NULL, 10);
+    }
+    return true;
+}
+
+// Appends every frame in path to frames. Returns the number of frames read or -1 if the
+// file can't be opened.
+static long captureLoadFile(const char *path, std::vector<CAN_FRAME> &frames)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return -1;
+
+    char line[512];
+    long count = 0;
+    long first = -1;
+    CAN_FRAME frame;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        long seconds;
+        if (!captureParseLine(line, frame, &seconds))
+            continue;
+        if (seconds >= 0)
+        {
+            if (first < 0)
+                first = seconds;
+            frame.timestamp = (uint32_t)((seconds - first) * 1000000L);
+        }
+        frames.push_back(frame);
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+#endif
@@ -0,0 +1,396 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/host/raw_candump.h
+//
+// Streaming reader for raw_candump_*.csv logs, which grow into the gigabytes in the car.
+// The file is memory mapped and parsed in place: no line buffer, no per-line allocation,
+// no sscanf/strtoul. Both layouts the logger has written are understood, and so are the
+// two candump_*.csv layouts:
+//
+//   log_out()  1970-01-01 08:00:01 | CANBUS | New extended frame from 0x0220A006 DLC 8 Data 0x80 ...
+//   tabbed     0x0628A001<TAB>0<TAB>36<TAB>...                       (decimal bytes only)
+//   candump    0x0628A001,0,36,0,128,5,0,0,32                        (decimal bytes only)
+//   candump    0x0220A006,8,0x80,...,0x00,128,...,000                (DLC, hex and decimal bytes)
+//
+// Fixed width fields are decoded eight characters at a time in a 64 bit word (SWAR): the
+// 8 digit frame ID is validated and converted without a per-character loop, and the
+// timestamp prefix is only parsed when it differs from the previous line's. Timestamps
+// become microseconds relative to the first frame, like captureLoadFile() does.
+//
+//   RawCandumpReader reader;
+//   if (reader.open("raw_candump_08-03-22-15-14.csv"))
+//       for (const CAN_FRAME &frame : reader)
+//           ...
+// ==========================================================================================
+
+#ifndef __HOST_RAW_CANDUMP__
+#define __HOST_RAW_CANDUMP__
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "can_common.h"
+
+// ---- Digit helpers
+
+// 0-15 for hex digits, 0xFF for anything else
+struct RawHexTable
+{
+    uint8_t v[256];
+    RawHexTable()
+    {
+        memset(v, 0xFF, sizeof(v));
+        for (int i = 0; i < 10; i++)
+            v['0' + i] = i;
+        for (int i = 0; i < 6; i++)
+            v['a' + i] = v['A' + i] = 10 + i;
+    }
+};
+
+static const RawHexTable rawHex;
+
+static inline uint64_t rawLoad8(const char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8); // little endian host: p[0] ends up in the low byte
+    return v;
+}
+
+// Per byte: 0x80 where the (7 bit) byte is >= lo
+static inline uint64_t rawBytesAtLeast(uint64_t v, uint8_t lo)
+{
+    return (v + 0x0101010101010101ull * (0x80 - lo)) & 0x8080808080808080ull;
+}
+
+// Eight hex digits, most significant first. Returns false if any of them isn't one.
+static inline bool rawParseHex8(const char *p, uint32_t &out)
+{
+    uint64_t v = rawLoad8(p);
+    if (v & 0x8080808080808080ull)
+        return false;
+    uint64_t lower = v | 0x2020202020202020ull; // 'A'-'F' -> 'a'-'f', digits unchanged
+    uint64_t digit = rawBytesAtLeast(v, '0') & ~rawBytesAtLeast(v, '9' + 1);
+    uint64_t alpha = rawBytesAtLeast(lower, 'a') & ~rawBytesAtLeast(lower, 'f' + 1);
+    if ((digit | alpha) != 0x8080808080808080ull)
+        return false;
+
+    // nibble value per byte, then fold pairs: 8 x 4 bits -> 4 x 8 -> 2 x 16 -> 1 x 32
+    v = (v & 0x0F0F0F0F0F0F0F0Full) + ((alpha >> 7) * 9);
+    v = ((v << 4) + (v >> 8)) & 0x00FF00FF00FF00FFull;
+    v = ((v << 8) + (v >> 16)) & 0x0000FFFF0000FFFFull;
+    v = ((v << 16) + (v >> 32)) & 0x00000000FFFFFFFFull;
+    out = (uint32_t)v;
+    return true;
+}
+
+static inline int rawDigit2(const char *p)
+{
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+// Writes frame as one line of the compact candump_*.csv layout ("0x0628A001,0,36,0,128,5,0,0,32\n")
+// and returns its length, at most 43 characters
+static inline size_t rawFormatCandump(const CAN_FRAME &frame, char *out)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    char *p = out;
+    *p++ = '0';
+    *p++ = 'x';
+    for (int i = frame.extended ? 7 : 2; i >= 0; i--)
+        *p++ = hexDigits[(frame.id >> (4 * i)) & 0xF];
+    for (int i = 0; i < frame.length && i < 8; i++)
+    {
+        uint8_t b = frame.data.byte[i];
+        *p++ = ',';
+        if (b >= 100)
+            *p++ = '0' + b / 100;
+        if (b >= 10)
+            *p++ = '0' + b / 10 % 10;
+        *p++ = '0' + b % 10;
+    }
+    *p++ = '\n';
+    return p - out;
+}
+
+// ---- Reader
+
+class RawCandumpReader
+{
+public:
+    class iterator
+    {
+    public:
+        iterator(RawCandumpReader *r) : reader(r) { ++*this; }
+        const CAN_FRAME &operator*() const { return reader->frame; }
+        const CAN_FRAME *operator->() const { return &reader->frame; }
+        iterator &operator++()
+        {
+            if (reader && !reader->next(reader->frame))
+                reader = NULL;
+            return *this;
+        }
+        bool operator!=(const iterator &o) const { return reader != o.reader; }
+
+    private:
+        RawCandumpReader *reader;
+    };
+
+    RawCandumpReader() : base(NULL), length(0), fd(-1) { rewind(); }
+    ~RawCandumpReader() { close(); }
+
+    bool open(const char *path)
+    {
+        struct stat st;
+        close();
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        if (fstat(fd, &st) < 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+        length = (size_t)st.st_size;
+        void *m = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        madvise(m, length, MADV_SEQUENTIAL);
+        base = (const char *)m;
+        rewind();
+        return true;
+    }
+
+    void close()
+    {
+        if (base)
+            munmap((void *)base, length);
+        if (fd >= 0)
+            ::close(fd);
+        base = NULL;
+        length = 0;
+        fd = -1;
+        rewind();
+    }
+
+    void rewind()
+    {
+        pos = 0;
+        stop = length;
+        lines = 0;
+        skipped = 0;
+        firstSecond = -1;
+        lastSecond = -1;
+        memset(lastStamp, 0, sizeof(lastStamp));
+    }
+
+    // Reads only the lines that start in [from, to), so threads can share out one file. A
+    // line that starts before from belongs to the previous range. Timestamps of the log_out()
+    // layout count from the first line of the range.
+    void limit(size_t from, size_t to)
+    {
+        rewind();
+        stop = to < length ? to : length;
+        pos = from < stop ? from : stop;
+        if (pos > 0 && base[pos - 1] != '\n')
+        {
+            const char *eol = (const char *)memchr(base + pos, '\n', length - pos);
+            pos = eol ? eol - base + 1 : length;
+        }
+    }
+
+    size_t size() const { return length; }
+    size_t offset() const { return pos; }
+    uint64_t lineCount() const { return lines; }
+    uint64_t skippedLines() const { return skipped; }
+
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(NULL); }
+
+    // Next frame of the file. Lines that don't hold a frame (Init messages, headers, junk)
+    // are skipped and counted.
+    bool next(CAN_FRAME &out)
+    {
+        while (pos < stop)
+        {
+            const char *line = base + pos;
+            const char *eol = (const char *)memchr(line, '\n', length - pos);
+            if (!eol)
+                eol = base + length;
+            pos = eol - base + 1;
+            lines++;
+            if (parseLine(line, eol, out))
+                return true;
+            skipped++;
+        }
+        return false;
+    }
+
+private:
+    static const int STAMP_LENGTH = 19; // "1970-01-01 08:00:01"
+
+    bool parseLine(const char *p, const char *end, CAN_FRAME &out)
+    {
+        long second = -1;
+
+        if (end - p > STAMP_LENGTH && p[4] == '-' && p[10] == ' ') // log_out() layout
+        {
+            second = stampSeconds(p);
+            const char *from = findFrom(p + STAMP_LENGTH, end);
+            if (!from)
+                return false;
+            p = from;
+        }
+        if (end - p < 10 || p[0] != '0' || p[1] != 'x')
+            return false;
+
+        out = CAN_FRAME();
+        p += 2;
+        const char *id = p;
+        if (end - id > 8 && rawParseHex8(id, out.id) && rawHex.v[(uint8_t)id[8]] == 0xFF)
+            p += 8; // the usual 29 bit ID, "0x" and eight digits
+        else
+        {
+            while (p < end && rawHex.v[(uint8_t)*p] != 0xFF)
+                p++;
+            if (p == id || p - id > 8)
+                return false;
+            out.id = 0;
+            for (const char *q = id; q < p; q++)
+                out.id = (out.id << 4) | rawHex.v[(uint8_t)*q];
+        }
+        out.extended = (out.id > 0x7FF || p - id > 3) ? 1 : 0;
+
+        if (second >= 0)
+        {
+            if (firstSecond < 0)
+                firstSecond = second;
+            out.timestamp = (uint32_t)((second - firstSecond) * 1000000L);
+            return parseLogData(p, end, out);
+        }
+        return parseDecimalData(p, end, out);
+    }
+
+    // "... DLC <n> Data 0xAA 0xBB ..." (the decimal copy that follows is ignored)
+    bool parseLogData(const char *p, const char *end, CAN_FRAME &out)
+    {
+        p = skipBlank(p, end);
+        if (end - p < 3 || memcmp(p, "DLC", 3))
+            return false;
+        p = skipBlank(p + 3, end);
+        if (p >= end || *p < '0' || *p > '8')
+            return false;
+        out.length = *p++ - '0';
+        p = skipBlank(p, end);
+        if (end - p < 4 || memcmp(p, "Data", 4))
+            return false;
+        return parseHexData(p + 4, end, out);
+    }
+
+    // out.length bytes written as 0xAA, separated by blanks or commas
+    bool parseHexData(const char *p, const char *end, CAN_FRAME &out)
+    {
+        for (int i = 0; i < out.length; i++)
+        {
+            p = skipSeparators(p, end);
+            if (end - p < 4 || p[0] != '0' || p[1] != 'x')
+                return false;
+            uint8_t hi = rawHex.v[(uint8_t)p[2]], lo = rawHex.v[(uint8_t)p[3]];
+            if ((hi | lo) > 0x0F)
+                return false;
+            out.data.byte[i] = (uint8_t)(hi << 4 | lo);
+            p += 4;
+        }
+        return true;
+    }
+
+    // Up to eight decimal bytes separated by tabs, spaces or commas, or a DLC followed by
+    // hex bytes (the decimal copy after them is ignored)
+    bool parseDecimalData(const char *p, const char *end, CAN_FRAME &out)
+    {
+        int n = 0;
+        while (n < 8)
+        {
+            p = skipSeparators(p, end);
+            if (p >= end || *p == '\r')
+                break;
+            unsigned int value = 0;
+            const char *digits = p;
+            while (p < end && (unsigned)(*p - '0') < 10 && p - digits < 3)
+                value = value * 10 + (*p++ - '0');
+            if (p == digits || value > 255)
+                return false;
+            if (n == 0 && value <= 8)
+            {
+                const char *next = skipSeparators(p, end);
+                if (end - next > 2 && next[0] == '0' && next[1] == 'x')
+                {
+                    out.length = value;
+                    return parseHexData(next, end, out);
+                }
+            }
+            out.data.byte[n++] = (uint8_t)value;
+        }
+        out.length = n;
+        return true;
+    }
+
+    // Seconds since the start of the month, as captureParseLogTime(). Consecutive lines
+    // nearly always share the stamp, so only a changed one is parsed.
+    long stampSeconds(const char *p)
+    {
+        if (rawLoad8(p + 11) == rawLoad8(lastStamp + 11) && !memcmp(p, lastStamp, STAMP_LENGTH))
+            return lastSecond;
+        memcpy(lastStamp, p, STAMP_LENGTH);
+        lastSecond = (((long)rawDigit2(p + 8) * 24 + rawDigit2(p + 11)) * 60 + rawDigit2(p + 14)) * 60 +
+                     rawDigit2(p + 17);
+        return lastSecond;
+    }
+
+    static const char *findFrom(const char *p, const char *end)
+    {
+        while (p < end)
+        {
+            const char *f = (const char *)memchr(p, 'f', end - p);
+            if (!f || end - f < 5)
+                return NULL;
+            if (f[1] == 'r' && f[2] == 'o' && f[3] == 'm' && (f[4] == ' ' || f[4] == '\t'))
+                return skipBlank(f + 4, end);
+            p = f + 1;
+        }
+        return NULL;
+    }
+
+    static const char *skipBlank(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        return p;
+    }
+
+    static const char *skipSeparators(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+            p++;
+        return p;
+    }
+
+    const char *base;
+    size_t length;
+    size_t pos;
+    size_t stop; // end of the range limit() set, length otherwise
+    int fd;
+    uint64_t lines;
+    uint64_t skipped;
+    long firstSecond;
+    long lastSecond;
+    char lastStamp[24];
+    CAN_FRAME frame; // what the iterator hands out
+};
+
+#endif
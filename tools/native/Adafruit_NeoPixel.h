@@ -0,0 +1,62 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/Adafruit_NeoPixel.h
+//
+// Native stand-in for the WS2812 strip. Pixels and brightness are kept so the replay can
+// tell what the shift light shows; show() only counts (and keeps a copy of what was sent).
+// ==========================================================================================
+
+#ifndef __NATIVE_ADAFRUIT_NEOPIXEL__
+#define __NATIVE_ADAFRUIT_NEOPIXEL__
+
+#include <stdint.h>
+#include <string.h>
+
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+#define NATIVE_MAX_PIXELS 64
+
+class Adafruit_NeoPixel
+{
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t, uint16_t)
+        : showCount(0), changedShows(0), count(n > NATIVE_MAX_PIXELS ? NATIVE_MAX_PIXELS : n), brightness(255)
+    {
+        memset(pixels, 0, sizeof(pixels));
+        memset(shown, 0, sizeof(shown));
+    }
+
+    void begin() {}
+    void show()
+    {
+        if (memcmp(shown, pixels, sizeof(pixels)))
+            changedShows++;
+        memcpy(shown, pixels, sizeof(pixels));
+        showCount++;
+    }
+    void clear() { memset(pixels, 0, sizeof(pixels)); }
+    void setBrightness(uint8_t b) { brightness = b; }
+    uint8_t getBrightness() const { return brightness; }
+    uint16_t numPixels() const { return count; }
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        if (n < count)
+            pixels[n] = c;
+    }
+    uint32_t getPixelColor(uint16_t n) const { return n < count ? pixels[n] : 0; }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+    // replay bookkeeping
+    uint32_t shownColor(uint16_t n) const { return n < count ? shown[n] : 0; }
+    uint32_t showCount;
+    uint32_t changedShows; // show() calls that sent a different picture than the one before
+
+private:
+    uint16_t count;
+    uint8_t brightness;
+    uint32_t pixels[NATIVE_MAX_PIXELS];
+    uint32_t shown[NATIVE_MAX_PIXELS];
+};
+
+#endif
@@ -0,0 +1,165 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/Arduino.h
+//
+// Just enough of the ESP32 Arduino core for the firmware to build and run on a PC (the
+// PlatformIO "native" environment). Time is the host's steady clock, pins read as idle
+// (pulled up, nothing pressed) unless the replay driver sets them, and Serial goes to stdout.
+// FreeRTOS tasks are host threads; there is no PSRAM.
+// ==========================================================================================
+
+#ifndef __NATIVE_ARDUINO__
+#define __NATIVE_ARDUINO__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define DEC 10
+#define HEX 16
+
+#define SCL 22
+#define SDA 21
+#define D0 0
+
+#define NATIVE_PIN_COUNT 40
+
+extern int nativePinLevel[NATIVE_PIN_COUNT]; // what digitalRead() returns, HIGH by default
+extern int nativeAnalogLevel;                // what analogRead() returns
+
+inline uint64_t nativeMicros()
+{
+    static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+inline unsigned long micros() { return (unsigned long)(uint32_t)nativeMicros(); }
+inline unsigned long millis() { return (unsigned long)(uint32_t)(nativeMicros() / 1000); }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return pin < NATIVE_PIN_COUNT ? nativePinLevel[pin] : HIGH; }
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+    if (pin < NATIVE_PIN_COUNT)
+        nativePinLevel[pin] = level;
+}
+inline uint16_t analogRead(uint8_t) { return (uint16_t)nativeAnalogLevel; }
+
+inline bool psramFound() { return false; }
+inline void *ps_malloc(size_t size) { return malloc(size); }
+
+// FreeRTOS, one tick per millisecond. A task handle carries the task's notification value
+struct NativeTask
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notified = 0;
+};
+typedef NativeTask *TaskHandle_t;
+typedef uint32_t TickType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdPASS 1
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFFu
+
+inline thread_local NativeTask *nativeCurrentTask = NULL;
+
+inline int xTaskCreatePinnedToCore(void (*task)(void *), const char *, uint32_t, void *param, unsigned int,
+                                   TaskHandle_t *handle, int)
+{
+    NativeTask *self = new NativeTask; // lives as long as the task, which never returns
+    std::thread([task, param, self]() {
+        nativeCurrentTask = self;
+        task(param);
+    }).detach();
+    if (handle)
+        *handle = self;
+    return pdPASS;
+}
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+inline void xTaskNotifyGive(TaskHandle_t task)
+{
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notified++;
+    task->wake.notify_one();
+}
+inline uint32_t ulTaskNotifyTake(int clearOnExit, TickType_t ticks)
+{
+    NativeTask *self = nativeCurrentTask;
+    std::unique_lock<std::mutex> guard(self->lock);
+    if (ticks == portMAX_DELAY)
+        self->wake.wait(guard, [self] { return self->notified != 0; });
+    else
+        self->wake.wait_for(guard, std::chrono::milliseconds(ticks), [self] { return self->notified != 0; });
+    uint32_t value = self->notified;
+    if (value)
+        self->notified = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+class String
+{
+public:
+    String(const char *s = "") : str(s) {}
+    String(int value) : str(std::to_string(value)) {}
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.size(); }
+
+private:
+    std::string str;
+};
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+
+    size_t print(const char *s) { return (size_t)fputs(s, stdout); }
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned long n, int base = DEC) { return (size_t)printf(base == HEX ? "%lX" : "%lu", n); }
+    size_t print(long n, int base = DEC) { return base == HEX ? print((unsigned long)n, HEX) : (size_t)printf("%ld", n); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double n) { return (size_t)printf("%.2f", n); }
+
+    size_t println() { return print("\n"); }
+    template <typename T> size_t println(const T &value) { return print(value) + println(); }
+    template <typename T> size_t println(const T &value, int base) { return print(value, base) + println(); }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ull; }
+    void restart() { exit(0); }
+};
+
+extern EspClass ESP;
+
+#endif
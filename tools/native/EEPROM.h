@@ -0,0 +1,20 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/EEPROM.h
+//
+// Native stand-in for the ESP32 EEPROM library. Nothing is persisted.
+// ==========================================================================================
+
+#ifndef __NATIVE_EEPROM__
+#define __NATIVE_EEPROM__
+
+class EEPROMClass
+{
+public:
+    bool begin(size_t) { return true; }
+    bool commit() { return true; }
+};
+
+static EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,126 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/LittleFS.h
+//
+// Native stand-in for the ESP32 LittleFS library: the file system is the directory
+// NATIVE_LITTLEFS_DIR (created on begin()) under the current directory, so whatever the
+// firmware saves during a replay can be inspected with the host tools afterwards.
+// ==========================================================================================
+
+#ifndef __NATIVE_LITTLEFS__
+#define __NATIVE_LITTLEFS__
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <memory>
+#include <string>
+
+#define NATIVE_LITTLEFS_DIR "littlefs"
+
+// Copies share the handle and the last one closes it, like the Arduino File
+class File
+{
+public:
+    File() {}
+    File(FILE *f, const std::string &p) : file(f, fclose), path(p) {}
+    File(DIR *d, const std::string &p) : dir(d, closedir), path(p) {}
+
+    explicit operator bool() const { return file || dir; }
+
+    size_t write(const uint8_t *buf, size_t size) { return file ? fwrite(buf, 1, size, file.get()) : 0; }
+    int read(uint8_t *buf, size_t size) { return file ? (int)fread(buf, 1, size, file.get()) : -1; }
+
+    size_t size() const
+    {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+    }
+
+    // Base name, as the 2.x cores return it
+    const char *name() const
+    {
+        size_t slash = path.rfind('/');
+        return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+
+    bool isDirectory() const { return dir != nullptr; }
+
+    File openNextFile()
+    {
+        if (!dir)
+            return File();
+        for (struct dirent *e = readdir(dir.get()); e; e = readdir(dir.get()))
+        {
+            std::string child = path + "/" + e->d_name;
+            struct stat st;
+            if (e->d_name[0] == '.' || stat(child.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                continue;
+            FILE *f = fopen(child.c_str(), "rb");
+            if (f)
+                return File(f, child);
+        }
+        return File();
+    }
+
+    void close()
+    {
+        if (file)
+            fflush(file.get());
+        file.reset();
+        dir.reset();
+    }
+
+private:
+    std::shared_ptr<FILE> file;
+    std::shared_ptr<DIR> dir;
+    std::string path;
+};
+
+class LittleFSFS
+{
+public:
+    bool begin(bool = false)
+    {
+        mkdir(NATIVE_LITTLEFS_DIR, 0755);
+        struct stat st;
+        return stat(NATIVE_LITTLEFS_DIR, &st) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    File open(const char *path, const char *mode = "r")
+    {
+        std::string full = hostPath(path);
+        struct stat st;
+        if (!strcmp(mode, "r") && stat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            DIR *d = opendir(full.c_str());
+            return d ? File(d, full) : File();
+        }
+        FILE *f = fopen(full.c_str(), !strcmp(mode, "w") ? "wb" : !strcmp(mode, "a") ? "ab" : "rb");
+        return f ? File(f, full) : File();
+    }
+
+    bool remove(const char *path) { return ::remove(hostPath(path).c_str()) == 0; }
+    bool exists(const char *path)
+    {
+        struct stat st;
+        return stat(hostPath(path).c_str(), &st) == 0;
+    }
+
+private:
+    static std::string hostPath(const char *path)
+    {
+        std::string full = NATIVE_LITTLEFS_DIR;
+        if (path[0] != '/')
+            full += '/';
+        full += path;
+        while (full.size() > 1 && full.back() == '/')
+            full.pop_back();
+        return full;
+    }
+};
+
+static LittleFSFS LittleFS;
+
+#endif
@@ -0,0 +1,260 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/U8g2lib.h
+//
+// Native stand-in for the SSD1306 U8g2 driver the firmware uses. There are no real fonts:
+// every character is a block the size of a glyph of the selected font, filled with a
+// pattern of its own, so the frame buffer changes where and when the real one would. The
+// glyphs are stored and decoded like U8g2's compressed fonts, so drawing costs about what
+// it does on the device. That is enough to measure what the firmware draws and sends
+// (sendBuffer() vs. tile transfers). The replay also gets the text of the last screen drawn.
+// ==========================================================================================
+
+#ifndef __NATIVE_U8G2LIB__
+#define __NATIVE_U8G2LIB__
+
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+// rows above the baseline, rows below, glyph width, draws its background (_mf fonts)
+static const uint8_t u8g2_font_logisoso16_tf[4] = {16, 0, 11, 0};
+static const uint8_t u8g2_font_logisoso38_tf[4] = {38, 0, 24, 0};
+static const uint8_t u8g2_font_profont12_mf[4] = {9, 3, 6, 1};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C;
+
+// u8x8 level of the driver: tiles straight from any buffer to the panel
+struct u8x8_t
+{
+    U8G2_SSD1306_128X64_NONAME_F_HW_I2C *display;
+};
+inline uint8_t u8x8_DrawTile(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t cnt, uint8_t *tile_ptr);
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C
+{
+public:
+    U8G2_SSD1306_128X64_NONAME_F_HW_I2C(int, uint8_t, uint8_t, uint8_t)
+        : sendCount(0), areaCount(0), drawCount(0), bytesSent(0), font(u8g2_font_profont12_mf), color(1)
+    {
+        u8x8.display = this;
+        clearBuffer();
+    }
+
+    bool begin() { return true; }
+    void clearBuffer()
+    {
+        memset(buffer, 0, sizeof(buffer));
+        text[0] = 0;
+        lines = 0;
+    }
+    void setFont(const uint8_t *f) { font = f; }
+    void setDrawColor(uint8_t c) { color = c; }
+    // Returns the summed advance of the glyphs, like U8g2
+    int drawStr(int x, int y, const char *s)
+    {
+        size_t used = strlen(text);
+        if (lines++ && used + 3 < sizeof(text))
+            strcat(text, " | ");
+        strncat(text, s, sizeof(text) - strlen(text) - 1);
+        drawCount++;
+
+        int start = x;
+        for (; *s; s++, x += font[2])
+            drawGlyph(x, y, (uint8_t)*s);
+        return x - start;
+    }
+    void drawBox(int x, int y, int w, int h)
+    {
+        for (int row = y; row < y + h; row++)
+            for (int col = x; col < x + w; col++)
+                setPixel(col, row, color != 0);
+    }
+    void drawFrame(int x, int y, int w, int h)
+    {
+        for (int col = x; col < x + w; col++)
+        {
+            setPixel(col, y, color != 0);
+            setPixel(col, y + h - 1, color != 0);
+        }
+        for (int row = y; row < y + h; row++)
+        {
+            setPixel(x, row, color != 0);
+            setPixel(x + w - 1, row, color != 0);
+        }
+    }
+    // Like U8g2: the advance of all but the last glyph, then the last one's ink only (the
+    // pattern leaves the glyph's last column blank as spacing)
+    int getStrWidth(const char *s)
+    {
+        int n = (int)strlen(s);
+        return n ? (n - 1) * font[2] + font[2] - 1 : 0;
+    }
+    uint8_t *getBufferPtr() { return buffer; }
+    u8x8_t *getU8x8() { return &u8x8; }
+    void sendBuffer()
+    {
+        sendCount++;
+        bytesSent += sizeof(buffer);
+    }
+    void updateDisplayArea(int, int, int tw, int th)
+    {
+        areaCount++;
+        bytesSent += tw * th * 8;
+    }
+    void drawTiles(int cnt) // u8x8_DrawTile(), possibly from another task
+    {
+        areaCount++;
+        bytesSent += cnt * 8;
+    }
+
+    // replay bookkeeping
+    const char *lastScreen() const { return text; } // drawStr() text of the last frame (not blitted glyphs)
+    uint32_t sendCount;
+    uint32_t areaCount; // updateDisplayArea() and u8x8_DrawTile() calls
+    uint32_t drawCount;
+    uint64_t bytesSent; // frame buffer bytes that went to the panel
+
+private:
+    // Glyphs are kept the way U8g2 keeps them, run length coded (4 bit runs of background
+    // then foreground pixels, a 1 bit repeats the pair, rows of the glyph box back to back),
+    // and decoded on every drawStr() like u8g2_font_decode_glyph() does. _tf fonts skip the
+    // background runs, _mf fonts paint them, over a box that includes the spacing column and
+    // the rows below the baseline.
+    struct Glyph
+    {
+        uint8_t width, height;
+        std::vector<uint8_t> code;
+    };
+
+    // The character's pattern on a 5x7 grid, stretched over the glyph
+    static bool glyphPixel(const uint8_t *f, uint8_t c, int col, int row)
+    {
+        uint64_t pattern = c == ' ' ? 0 : c * 0x9E3779B97F4A7C15ull;
+        pattern ^= pattern >> 29;
+        int above = f[0], width = f[2];
+        return col < width - 1 && row < above && (pattern >> ((row * 7 / above) * 5 + col * 5 / (width - 1))) & 1;
+    }
+
+    static const Glyph &glyph(const uint8_t *f, uint8_t c)
+    {
+        static std::map<const uint8_t *, std::map<uint8_t, Glyph>> fonts;
+        std::map<uint8_t, Glyph> &glyphs = fonts[f];
+        auto found = glyphs.find(c);
+        if (found != glyphs.end())
+            return found->second;
+
+        Glyph &g = glyphs[c];
+        g.width = f[3] ? f[2] : f[2] - 1;
+        g.height = f[3] ? f[0] + f[1] : f[0];
+        std::vector<bool> pixels;
+        for (int row = 0; row < g.height; row++)
+            for (int col = 0; col < g.width; col++)
+                pixels.push_back(glyphPixel(f, c, col, row));
+
+        int bits = 0;
+        auto put = [&g, &bits](unsigned value, int count) {
+            for (int i = 0; i < count; i++, bits++)
+            {
+                if ((bits & 7) == 0)
+                    g.code.push_back(0);
+                g.code.back() |= ((value >> i) & 1) << (bits & 7);
+            }
+        };
+        auto runs = [&pixels](size_t at, unsigned &zeros, unsigned &ones) {
+            size_t i = at;
+            for (zeros = 0; zeros < 15 && i < pixels.size() && !pixels[i]; zeros++)
+                i++;
+            for (ones = 0; ones < 15 && i < pixels.size() && pixels[i]; ones++)
+                i++;
+            return i - at;
+        };
+        for (size_t i = 0; i < pixels.size();)
+        {
+            unsigned zeros, ones, nextZeros, nextOnes;
+            i += runs(i, zeros, ones);
+            put(zeros, 4);
+            put(ones, 4);
+            for (;;)
+            {
+                size_t length = runs(i, nextZeros, nextOnes);
+                bool repeat = length && nextZeros == zeros && nextOnes == ones;
+                put(repeat, 1);
+                if (!repeat)
+                    break;
+                i += length;
+            }
+        }
+        return g;
+    }
+
+    // Glyph of the current font at (x, baseline y)
+    void drawGlyph(int x, int y, uint8_t c)
+    {
+        const Glyph &g = glyph(font, c);
+        int top = y - font[0] + 1, lx = 0, ly = 0, bits = 0, total = g.width * g.height, done = 0;
+        auto get = [&g, &bits](int count) {
+            unsigned value = 0;
+            for (int i = 0; i < count; i++, bits++)
+                value |= ((g.code[bits >> 3] >> (bits & 7)) & 1u) << i;
+            return value;
+        };
+        auto run = [&](unsigned length, bool on) {
+            done += length;
+            while (length)
+            {
+                unsigned segment = g.width - lx < (int)length ? g.width - lx : length;
+                if (on || font[3])
+                    for (unsigned i = 0; i < segment; i++)
+                        setPixel(x + lx + i, top + ly, on == (color != 0));
+                lx += segment;
+                length -= segment;
+                if (lx == g.width)
+                {
+                    lx = 0;
+                    ly++;
+                }
+            }
+        };
+        while (done < total)
+        {
+            unsigned zeros = get(4), ones = get(4);
+            do
+            {
+                run(zeros, false);
+                run(ones, true);
+            } while (get(1));
+        }
+    }
+
+    // Same layout as U8g2's full buffer: 8 pages of 128 bytes, bit n of a byte is row 8p + n
+    void setPixel(int x, int y, bool on)
+    {
+        if (x < 0 || x >= 128 || y < 0 || y >= 64)
+            return;
+        uint8_t &b = buffer[(y >> 3) * 128 + x];
+        if (on)
+            b |= 1 << (y & 7);
+        else
+            b &= ~(1 << (y & 7));
+    }
+
+    uint8_t buffer[1024];
+    char text[96];
+    int lines;
+    const uint8_t *font;
+    uint8_t color;
+    u8x8_t u8x8;
+};
+
+inline uint8_t u8x8_DrawTile(u8x8_t *u8x8, uint8_t, uint8_t, uint8_t cnt, uint8_t *)
+{
+    u8x8->display->drawTiles(cnt);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,6 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/Wire.h
+//
+// Empty native stand-in, the firmware includes it but uses nothing from it.
+// ==========================================================================================
@@ -0,0 +1,148 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/esp32_can.h
+//
+// Native stand-in for the built-in ESP32CAN driver. There is no controller and no RX task:
+// the replay hands every captured frame to receive(), which does what
+// ESP32CAN::processFrame() does with the library's own filter table, RX ring and
+// mailboxes, so the firmware reads them back through readBatch() / readLatest() exactly
+// as on the car. Callbacks are not modelled, the firmware registers none.
+// ==========================================================================================
+
+#ifndef __NATIVE_ESP32_CAN__
+#define __NATIVE_ESP32_CAN__
+
+#include "Arduino.h"
+#include <can_common.h>
+#include "can_ring.h"
+#include "can_filter_table.h"
+#include "can_mailbox_table.h"
+#include "can_stats.h"
+#include "can_id_profiler.h"
+
+#define BI_NUM_FILTERS 32
+#define BI_RX_BUFFER_SIZE 64
+
+#define BI_PRIORITY_NORMAL 0
+#define BI_PRIORITY_CRITICAL 1
+#define BI_PRIORITY_BULK 2
+
+#define CAN_BPS_500K 500000
+
+typedef enum
+{
+    GPIO_NUM_4 = 4,
+    GPIO_NUM_5 = 5,
+} gpio_num_t;
+
+class ESP32CAN
+{
+public:
+    ESP32CAN() : numFilters(0), mailboxMode(false), idProfiling(false), rawTap(NULL)
+    {
+        canStatsClear(stats);
+        rxRing.allocate(BI_RX_BUFFER_SIZE);
+    }
+
+    void setCANPins(gpio_num_t, gpio_num_t) {}
+    void setListenOnlyMode(bool) {}
+    void setMailboxMode(bool state) { mailboxMode = state; }
+    uint32_t begin(uint32_t baud) { return baud; }
+
+    // same filters CAN_COMMON::watchFor() would set up
+    int watchFor()
+    {
+        addFilter(0, 0, false);
+        return addFilter(0, 0, true);
+    }
+    int watchFor(uint32_t id)
+    {
+        return id > 0x7FF ? addFilter(id, 0x1FFFFFFF, true) : addFilter(id, 0x7FF, false);
+    }
+    void commitFilters() {}
+    void setFilterPriority(uint8_t, uint8_t) {}
+    void setInlineCallback(uint8_t, bool) {}
+
+    size_t readBatch(CAN_FRAME *out, size_t max, size_t *waiting = NULL)
+    {
+        if (waiting)
+            *waiting = rxRing.count();
+        return rxRing.popBatch(out, max);
+    }
+
+    bool readLatest(uint32_t id, bool extended, CAN_FRAME &msg, uint32_t *coalesced = NULL)
+    {
+        int slot = filterTable.match(id, extended);
+        return slot >= 0 && mailboxes.read(slot, msg, coalesced);
+    }
+
+    void getStats(CAN_DRIVER_STATS &out)
+    {
+        out = stats;
+        out.rxCapacity = rxRing.capacity();
+    }
+    void resetStats() { canStatsClear(stats); }
+
+    void setIdProfiling(bool state) { idProfiling = state; }
+    void setHardwareFiltering(bool) {} // no acceptance filter here, every frame reaches receive()
+    int getIdProfile(CAN_ID_PROFILE *out, int max, uint32_t *untracked = NULL)
+    {
+        if (untracked)
+            *untracked = idProfiler.untracked();
+        return idProfiler.snapshot(out, max);
+    }
+    void resetIdProfile() { idProfiler.requestClear(); }
+    void setRawTap(void (*tap)(const CAN_FRAME &frame)) { rawTap = tap; }
+
+    // The replay's side: a frame just came off the bus. Stamped with micros() like the
+    // real driver does, so the latency histograms measure the host pipeline.
+    bool receive(const CAN_FRAME &frame)
+    {
+        CAN_FRAME msg = frame;
+
+        msg.timestamp = micros();
+        stats.framesReceived++;
+        if (idProfiling)
+            idProfiler.record(msg);
+        if (rawTap)
+            rawTap(msg);
+        int i = filterTable.match(msg.id, msg.extended);
+        if (i < 0)
+        {
+            stats.filterMisses++;
+            return false;
+        }
+        stats.framesAccepted++;
+        if (mailboxMode)
+            mailboxes.write(i, msg);
+        else if (!rxRing.push(msg))
+            stats.rxDropped++;
+        else
+            canStatsHighWater(stats.rxHighWater, rxRing.count());
+        return true;
+    }
+
+private:
+    int addFilter(uint32_t id, uint32_t mask, bool extended)
+    {
+        if (numFilters >= BI_NUM_FILTERS)
+            return -1;
+        filterTable.add(numFilters, id & mask, mask, extended);
+        mailboxes.clearSlot(numFilters);
+        return numFilters++;
+    }
+
+    CANFrameRing rxRing;
+    CANFilterTable filterTable;
+    CANMailboxTable mailboxes;
+    CAN_DRIVER_STATS stats;
+    int numFilters;
+    bool mailboxMode;
+    bool idProfiling;
+    CANIdProfiler idProfiler;
+    void (*rawTap)(const CAN_FRAME &frame);
+};
+
+extern ESP32CAN CAN0;
+
+#endif
@@ -0,0 +1,440 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/render.cpp
+//
+// Second entry point of the native build: renders the firmware's screens headless, into the
+// frame buffer of the U8g2 stand-in (tools/native/U8g2lib.h) instead of the SSD1306, to
+// catch drawing regressions and measure the render paths without a car or a panel.
+//
+// Every scene sets up the firmware state (values, layout, menu, splash) and draws through
+// the same path loop() takes, sensorDeclareScreen() + refreshDue() + sensorUpdateDisplay(),
+// so SSD1306_ShowSplashScreen(), SSD1306_ShowDefaultScreen() and the menu pages all run.
+// Then, for each scene:
+//
+//   golden   the frame is compared with tools/native/golden/<scene>.pbm (plain PBM, one
+//            text row per pixel row, readable in a diff). -u writes them instead
+//   update   scenes of the home screen change some values and redraw: the result is
+//            compared with its own golden image and with a full redraw of the same values,
+//            since only the cells that changed are drawn again
+//   timing   ns per render, full and update, including the handoff to the panel
+//            (displaySend()), and the bytes one update sends to the panel
+//
+// -o writes every frame checked to a directory as PBM, to look at. -w saves the timings to
+// a file and -b compares against such a file, failing when a render path got more than -s
+// percent slower: run both on the same machine.
+//
+// Exits 1 when a frame differs from its golden image or a render path regressed.
+//
+// Usage: render [-u] [-g golden_dir] [-o dump_dir] [-n renders] [-w timings] [-b timings] [-s %]
+// ==========================================================================================
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "Adafruit_NeoPixel.h"
+#include "U8g2lib.h"
+#include "esp32_can.h"
+#include "values.h"
+
+#define RENDER_DEFAULT_RENDERS 1000
+#define RENDER_DEFAULT_SLACK 25 // percent
+#define RENDER_ROUNDS 5
+#define RENDER_WIDTH 128
+#define RENDER_HEIGHT 64
+
+// Arduino core and driver objects the firmware expects
+HardwareSerial Serial;
+EspClass ESP;
+ESP32CAN CAN0;
+int nativePinLevel[NATIVE_PIN_COUNT];
+int nativeAnalogLevel = 0;
+
+// The firmware
+extern int v[];
+extern int currentMenu;
+extern bool SCREEN_ACTIVE;
+extern bool ON_SPLASH_SCREEN;
+extern U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2;
+bool displayIdle();
+void setup();
+void sensorDeclareScreen();
+void sensorUpdateDisplay();
+void refreshRequest();
+bool refreshDue(uint32_t now);
+void refreshDone(uint32_t now);
+
+struct Scene
+{
+    const char *name;
+    int layout;  // home screen layout, -1 for the splash screen or a menu
+    int menu;    // menu item shown, -1 for the home screen
+    int display; // value chosen in DISPLAY
+    std::vector<std::pair<int, int>> values;  // {slot, value} set before drawing
+    std::vector<std::pair<int, int>> updates; // changed for the update, none for scenes without one
+};
+
+static const Scene scenes[] = {
+    {"splash", -1, -1, 0, {}, {}},
+    {"home_rpm", 0, -1, CURRENT_ENGINE_SPEED, {{CURRENT_ENGINE_SPEED, 4321}}, {{CURRENT_ENGINE_SPEED, 5678}}},
+    {"home_mph", 0, -1, CURRENT_VEHICLE_SPEED, {{CURRENT_VEHICLE_SPEED, 67}}, {{CURRENT_VEHICLE_SPEED, 108}}},
+    {"home_dual", 1, -1, 0, {{CURRENT_ENGINE_SPEED, 3456}, {CURRENT_VEHICLE_SPEED, 54}}, {{CURRENT_VEHICLE_SPEED, 61}}},
+    {"home_quad",
+     2,
+     -1,
+     0,
+     {{CURRENT_ENGINE_SPEED, 2345}, {CURRENT_VEHICLE_SPEED, 38}, {CURRENT_LIGHTLEVEL, 1234}},
+     {{CURRENT_ENGINE_SPEED, 6012}}},
+    {"home_bar", 3, -1, 0, {{CURRENT_ENGINE_SPEED, 4500}}, {{CURRENT_ENGINE_SPEED, 1500}}},
+    {"menu_settings", -1, MENU_ITEM_SETTINGS, 0, {}, {}},
+    {"menu_maxrpm", -1, MENU_ITEM_MAXRPM, 0, {}, {}},
+    {"menu_profile", -1, MENU_ITEM_BUS_PROFILE, 0, {}, {}},
+};
+
+struct Timing
+{
+    std::string name;
+    double ns;
+};
+
+// Clock of the scheduler: every pass a second later, so the frame rate cap never defers
+static uint32_t renderNow = 0;
+
+// What loop() does for the display. forced redraws the whole screen
+static void renderPass(bool forced)
+{
+    renderNow += 1000;
+    if (forced)
+        refreshRequest();
+    sensorDeclareScreen();
+    if (refreshDue(renderNow))
+    {
+        sensorUpdateDisplay();
+        refreshDone(renderNow);
+    }
+}
+
+static void setValues(const std::vector<std::pair<int, int>> &values)
+{
+    for (const std::pair<int, int> &value : values)
+        v[value.first] = value.second;
+}
+
+static bool hasUpdate(const Scene &scene)
+{
+    return !scene.updates.empty();
+}
+
+// Puts the firmware on the scene's screen with its values and draws it whole
+static void renderScene(const Scene &scene)
+{
+    SCREEN_ACTIVE = scene.layout < 0;
+    ON_SPLASH_SCREEN = scene.layout < 0 && scene.menu < 0;
+    if (scene.menu >= 0)
+        currentMenu = scene.menu;
+    if (scene.layout >= 0)
+        v[CURRENT_LAYOUT] = scene.layout;
+    v[CURRENT_DISPLAY] = scene.display;
+    setValues(scene.values);
+    renderPass(true);
+}
+
+static uint64_t panelBytes()
+{
+    while (!displayIdle()) // the flush task may still be sending
+        delay(1);
+    return u8g2.bytesSent;
+}
+
+static void writePbm(const char *path, const uint8_t *frame, const char *comment)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "Can't write %s\n", path);
+        exit(1);
+    }
+    fprintf(f, "P1\n# %s\n%d %d\n", comment, RENDER_WIDTH, RENDER_HEIGHT);
+    for (int y = 0; y < RENDER_HEIGHT; y++)
+    {
+        for (int x = 0; x < RENDER_WIDTH; x++)
+            fputc((frame[(y >> 3) * RENDER_WIDTH + x] >> (y & 7)) & 1 ? '1' : '0', f);
+        fputc('\n', f);
+    }
+    fclose(f);
+}
+
+// Plain PBM into the U8g2 page layout. false if missing or not a 128x64 image
+static bool readPbm(const char *path, uint8_t *frame)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    auto token = [f](char *s, int size) {
+        int c, n = 0;
+        while ((c = fgetc(f)) != EOF)
+        {
+            if (c == '#')
+                while ((c = fgetc(f)) != EOF && c != '\n')
+                    ;
+            else if (!isspace(c))
+                break;
+        }
+        for (; c != EOF && !isspace(c) && n < size - 1; c = fgetc(f))
+            s[n++] = (char)c;
+        s[n] = 0;
+        return n > 0;
+    };
+    char s[16], w[16], h[16];
+    bool ok = token(s, sizeof(s)) && !strcmp(s, "P1") && token(w, sizeof(w)) && token(h, sizeof(h)) &&
+              atoi(w) == RENDER_WIDTH && atoi(h) == RENDER_HEIGHT;
+
+    memset(frame, 0, RENDER_WIDTH * RENDER_HEIGHT / 8);
+    for (int i = 0; ok && i < RENDER_WIDTH * RENDER_HEIGHT; i++)
+    {
+        int c;
+        while ((c = fgetc(f)) != EOF && isspace(c))
+            ;
+        if (c != '0' && c != '1')
+            ok = false;
+        else if (c == '1')
+            frame[(i / RENDER_WIDTH >> 3) * RENDER_WIDTH + i % RENDER_WIDTH] |= 1 << (i / RENDER_WIDTH & 7);
+    }
+    fclose(f);
+    return ok;
+}
+
+static int differentPixels(const uint8_t *a, const uint8_t *b)
+{
+    int n = 0;
+    for (int i = 0; i < RENDER_WIDTH * RENDER_HEIGHT / 8; i++)
+        n += __builtin_popcount(a[i] ^ b[i]);
+    return n;
+}
+
+// Checks the frame in u8g2 against <golden>/<name>.pbm, or writes it there with -u
+static const char *checkGolden(const char *golden, const char *dump, const std::string &name, bool update,
+                               int &failures)
+{
+    static char result[32];
+    const uint8_t *frame = u8g2.getBufferPtr();
+    std::string path = std::string(golden) + "/" + name + ".pbm";
+
+    if (dump)
+        writePbm((std::string(dump) + "/" + name + ".pbm").c_str(), frame, name.c_str());
+    if (update)
+    {
+        writePbm(path.c_str(), frame, name.c_str());
+        return "written";
+    }
+
+    uint8_t expected[RENDER_WIDTH * RENDER_HEIGHT / 8];
+    if (!readPbm(path.c_str(), expected))
+    {
+        failures++;
+        return "missing";
+    }
+    int pixels = differentPixels(frame, expected);
+    if (!pixels)
+        return "ok";
+    failures++;
+    snprintf(result, sizeof(result), "%d px differ", pixels);
+    return result;
+}
+
+// ns per render of the scene, each one forced whole (update false) or, alternating between
+// the scene's values and its update, of just the changed cells. Best of RENDER_ROUNDS rounds,
+// the flush task shares the host with the renders
+static double timeRenders(const Scene &scene, long renders, bool update)
+{
+    double best = 0;
+
+    renderScene(scene);
+    for (int round = 0; round < RENDER_ROUNDS; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < renders; i++)
+        {
+            if (update)
+                setValues(i & 1 ? scene.values : scene.updates);
+            renderPass(!update);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (!round || ns < best)
+            best = ns;
+    }
+    return best / renders;
+}
+
+static bool readTimings(const char *path, std::vector<Timing> &timings)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    char name[64];
+    double ns;
+    while (fscanf(f, "%63s %lf", name, &ns) == 2)
+        timings.push_back({name, ns});
+    fclose(f);
+    return true;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: render [-u] [-g golden_dir] [-o dump_dir] [-n renders] [-w timings] [-b timings] [-s %%]\n"
+                    "  -u  write the golden images instead of checking them\n"
+                    "  -g  golden image directory (default tools/native/golden)\n"
+                    "  -o  also write every frame checked to this directory\n"
+                    "  -n  renders per timing round (default %d)\n"
+                    "  -w  save the timings to a file\n"
+                    "  -b  compare the timings with a file saved by -w\n"
+                    "  -s  slowdown over -b that fails, in percent (default %d)\n",
+            RENDER_DEFAULT_RENDERS, RENDER_DEFAULT_SLACK);
+}
+
+int main(int argc, char **argv)
+{
+    const char *golden = "tools/native/golden";
+    const char *dump = NULL;
+    const char *save = NULL;
+    const char *baseline = NULL;
+    bool update = false;
+    long renders = RENDER_DEFAULT_RENDERS;
+    double slack = RENDER_DEFAULT_SLACK;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ug:o:n:w:b:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'u':
+            update = true;
+            break;
+        case 'g':
+            golden = optarg;
+            break;
+        case 'o':
+            dump = optarg;
+            break;
+        case 'n':
+            renders = atol(optarg);
+            break;
+        case 'w':
+            save = optarg;
+            break;
+        case 'b':
+            baseline = optarg;
+            break;
+        case 's':
+            slack = atof(optarg);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (renders < 1 || slack < 0 || optind != argc)
+    {
+        usage();
+        return 2;
+    }
+
+    for (int i = 0; i < NATIVE_PIN_COUNT; i++)
+        nativePinLevel[i] = HIGH;
+    setup();
+
+    // pixels
+    int failures = 0;
+    printf("\nScene              golden          update          partial = full\n");
+    for (const Scene &scene : scenes)
+    {
+        renderScene(scene);
+        printf("  %-16s %-15s", scene.name, checkGolden(golden, dump, scene.name, update, failures));
+        if (!hasUpdate(scene))
+        {
+            printf("\n");
+            continue;
+        }
+
+        setValues(scene.updates);
+        renderPass(false);
+        uint8_t partial[RENDER_WIDTH * RENDER_HEIGHT / 8];
+        memcpy(partial, u8g2.getBufferPtr(), sizeof(partial));
+        printf(" %-15s", checkGolden(golden, dump, std::string(scene.name) + "-update", update, failures));
+        renderPass(true);
+        int pixels = differentPixels(partial, u8g2.getBufferPtr());
+        if (pixels)
+            failures++;
+        printf(" %s\n", pixels ? "no" : "yes");
+    }
+
+    // time
+    std::vector<Timing> timings;
+    printf("\nRender path        ns/render   panel bytes\n");
+    for (const Scene &scene : scenes)
+        for (int part = 0; part < (hasUpdate(scene) ? 2 : 1); part++)
+        {
+            double ns = timeRenders(scene, renders, part);
+            std::string name = std::string(scene.name) + (part ? "-update" : "");
+            timings.push_back({name, ns});
+            if (!part) // a forced redraw of the same frame sends nothing
+            {
+                printf("  %-16s %9.0f\n", name.c_str(), ns);
+                continue;
+            }
+
+            // one more update, alone, for what it sends to the panel
+            setValues(scene.values);
+            renderPass(false);
+            uint64_t before = panelBytes();
+            setValues(scene.updates);
+            renderPass(false);
+            printf("  %-16s %9.0f   %11llu\n", name.c_str(), ns, (unsigned long long)(panelBytes() - before));
+        }
+
+    if (save)
+    {
+        FILE *f = fopen(save, "w");
+        if (!f)
+        {
+            fprintf(stderr, "Can't write %s\n", save);
+            return 1;
+        }
+        for (const Timing &t : timings)
+            fprintf(f, "%s %.0f\n", t.name.c_str(), t.ns);
+        fclose(f);
+    }
+
+    if (baseline)
+    {
+        std::vector<Timing> before;
+        if (!readTimings(baseline, before))
+        {
+            fprintf(stderr, "Can't read %s\n", baseline);
+            return 1;
+        }
+        printf("\nAgainst %s (fails over +%.0f%%)\n", baseline, slack);
+        for (const Timing &t : timings)
+            for (const Timing &b : before)
+                if (t.name == b.name && b.ns > 0)
+                {
+                    double change = (t.ns / b.ns - 1) * 100;
+                    bool slower = change > slack;
+                    if (slower)
+                        failures++;
+                    printf("  %-16s %9.0f -> %9.0f ns  %+6.1f%%%s\n", t.name.c_str(), b.ns, t.ns, change,
+                           slower ? "  REGRESSION" : "");
+                }
+    }
+
+    printf("\n%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
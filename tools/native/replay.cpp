@@ -0,0 +1,254 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/native/replay.cpp
+//
+// Entry point of the PlatformIO "native" environment: runs the unmodified firmware
+// (src/main.cpp) on a PC and feeds it recorded captures through the CAN0 stand-in, so every
+// frame takes the same path as on the car: filters, RX ring, readBatch() in
+// sensorUpdateReadingsQuick(), sensorHandleFrame(), v[], shift light and display.
+//
+// Two ways to play a capture:
+//
+//   as fast as possible (default)  one frame per loop() pass, to profile the hot path
+//   original timing (-t)           frames are released when their capture time comes up and
+//                                  loop() spins in between, like on the device. Only the
+//                                  raw_candump log layout carries timestamps (one second
+//                                  resolution, frames of the same second are spread evenly);
+//                                  other captures are paced at -r frames/s
+//
+// At the end it reports frames/s, the values the firmware decoded (changes, min, max, last),
+// what the shift light and display did, and the firmware's own 's', 'l', 'r', 'o', 'w' and 'p'
+// reports (profiling is switched on with 'b' before the first frame).
+// A bus recorder window still open when the captures run out is closed and saved, so the
+// captures it wrote are in tools/native/LittleFS.h's directory for tools/recdump to read.
+//
+// Usage: pio run -e native && .pio/build/native/program [-t] [-r fps] [-p passes] [capture ...]
+//        (without captures: candump_*.csv, or raw_candump_*.csv with -t)
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "Adafruit_NeoPixel.h"
+#include "U8g2lib.h"
+#include "esp32_can.h"
+#include "capture_csv.h"
+
+#define REPLAY_VALUE_COUNT 30 // VALUE_COUNT in main.cpp
+#define REPLAY_DEFAULT_FPS 1000
+#define REPLAY_RECORDER_POST 2   // RECORDER_POST in recorder.h
+#define REPLAY_RECORDER_SAVING 3 // RECORDER_SAVING
+
+// Arduino core and driver objects the firmware expects
+HardwareSerial Serial;
+EspClass ESP;
+ESP32CAN CAN0;
+int nativePinLevel[NATIVE_PIN_COUNT];
+int nativeAnalogLevel = 0;
+
+// The firmware
+extern int v[];
+extern char l[][20];
+extern U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2;
+extern Adafruit_NeoPixel strip;
+extern int recorderState;
+void recorderFreeze();
+bool displayIdle();
+void setup();
+void loop();
+void sensorSerialCommand(char command);
+
+struct ValueTrace
+{
+    long changes;
+    int minimum;
+    int maximum;
+};
+
+// Release time of every frame in microseconds from the start of the replay
+static void replaySchedule(const std::vector<CAN_FRAME> &frames, size_t first, uint64_t origin, double fps,
+                           std::vector<uint64_t> &due)
+{
+    bool timed = false;
+    for (size_t i = first; i < frames.size(); i++)
+        if (frames[i].timestamp)
+            timed = true;
+
+    for (size_t i = first; i < frames.size();)
+    {
+        if (!timed)
+        {
+            due.push_back(origin + (uint64_t)((i - first) * 1e6 / fps));
+            i++;
+            continue;
+        }
+        size_t end = i;
+        while (end < frames.size() && frames[end].timestamp == frames[i].timestamp)
+            end++;
+        for (size_t k = i; k < end; k++)
+            due.push_back(origin + frames[i].timestamp + (uint64_t)((k - i) * 1e6 / (end - i)));
+        i = end;
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: program [-t] [-r fps] [-p passes] [capture.csv ...]\n"
+                    "  -t  original timing instead of as fast as possible\n"
+                    "  -r  pace of captures without timestamps in original timing (default %d)\n"
+                    "  -p  play the captures this many times (default 1)\n",
+            REPLAY_DEFAULT_FPS);
+}
+
+int main(int argc, char **argv)
+{
+    bool originalTiming = false;
+    double fps = REPLAY_DEFAULT_FPS;
+    long passes = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "tr:p:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            originalTiming = true;
+            break;
+        case 'r':
+            fps = atof(optarg);
+            break;
+        case 'p':
+            passes = atol(optarg);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (fps <= 0 || passes < 1)
+    {
+        usage();
+        return 2;
+    }
+
+    std::vector<const char *> files(argv + optind, argv + argc);
+    if (files.empty())
+    {
+        static const char *fast[] = {"candump_08-03-22-15-14.csv", "candump_08-03-22-18-12.csv",
+                                     "candump_08-04-22-13-43.csv"};
+        static const char *timed[] = {"raw_candump_08-03-22-15-14.csv", "raw_candump_08-03-22-18-12.csv",
+                                      "raw_candump_08-04-22-13-43.csv"};
+        files.assign(originalTiming ? timed : fast, (originalTiming ? timed : fast) + 3);
+    }
+
+    // captures are played back to back, each one starting a second after the previous one
+    std::vector<CAN_FRAME> frames;
+    std::vector<uint64_t> due;
+    for (const char *file : files)
+    {
+        size_t first = frames.size();
+        if (captureLoadFile(file, frames) < 0)
+        {
+            fprintf(stderr, "Can't read %s\n", file);
+            return 1;
+        }
+        replaySchedule(frames, first, due.empty() ? 0 : due.back() + 1000000, fps, due);
+    }
+    if (frames.empty())
+    {
+        fprintf(stderr, "No frames loaded. Run from the repository root or pass capture files.\n");
+        return 1;
+    }
+
+    for (int i = 0; i < NATIVE_PIN_COUNT; i++)
+        nativePinLevel[i] = HIGH;
+
+    setup();
+    sensorSerialCommand('b'); // profile the whole replay, as 'b' on the console would
+
+    int before[REPLAY_VALUE_COUNT];
+    ValueTrace trace[REPLAY_VALUE_COUNT];
+    for (int i = 0; i < REPLAY_VALUE_COUNT; i++)
+    {
+        before[i] = v[i];
+        trace[i] = {0, v[i], v[i]};
+    }
+
+    long loops = 0;
+    uint64_t start = nativeMicros();
+    for (long p = 0; p < passes; p++)
+    {
+        uint64_t passStart = nativeMicros();
+        size_t next = 0;
+        while (next < frames.size())
+        {
+            if (originalTiming)
+            {
+                uint64_t now = nativeMicros() - passStart;
+                while (next < frames.size() && due[next] <= now)
+                    CAN0.receive(frames[next++]);
+            }
+            else
+                CAN0.receive(frames[next++]);
+
+            loop();
+            loops++;
+
+            for (int i = 0; i < REPLAY_VALUE_COUNT; i++)
+            {
+                if (v[i] == before[i])
+                    continue;
+                before[i] = v[i];
+                trace[i].changes++;
+                if (v[i] < trace[i].minimum)
+                    trace[i].minimum = v[i];
+                if (v[i] > trace[i].maximum)
+                    trace[i].maximum = v[i];
+            }
+        }
+    }
+    loop(); // let the firmware pick up whatever is still queued
+    double seconds = (nativeMicros() - start) / 1e6;
+
+    if (__atomic_load_n(&recorderState, __ATOMIC_ACQUIRE) == REPLAY_RECORDER_POST)
+        recorderFreeze();
+    while (__atomic_load_n(&recorderState, __ATOMIC_ACQUIRE) == REPLAY_RECORDER_SAVING)
+        delay(1);
+
+    long total = (long)frames.size() * passes;
+    printf("\n%s replay of %zu frames from %zu capture(s), %ld pass(es)\n",
+           originalTiming ? "Original timing" : "As fast as possible", frames.size(), files.size(), passes);
+    printf("  %.3f s, %.0f frames/s, %.0f loop()/s, %.2f us/frame\n\n", seconds, total / seconds, loops / seconds,
+           seconds * 1e6 / total);
+
+    printf("Decoded values     changes        min        max       last\n");
+    for (int i = 0; i < REPLAY_VALUE_COUNT; i++)
+        if (trace[i].changes)
+            printf("  %-14s %9ld %10d %10d %10d\n", l[i], trace[i].changes, trace[i].minimum, trace[i].maximum, v[i]);
+
+    printf("\nShift light: %u show(), %u with a new picture\n", (unsigned int)strip.showCount,
+           (unsigned int)strip.changedShows);
+    while (!displayIdle()) // the flush task may still be sending the last frame
+        delay(1);
+    printf("Display: %u sendBuffer(), %u tile transfers, %llu bytes to the panel, last drawStr() text \"%s\"\n\n",
+           (unsigned int)u8g2.sendCount, (unsigned int)u8g2.areaCount, (unsigned long long)u8g2.bytesSent,
+           u8g2.lastScreen());
+
+    printf("CAN driver counters ('s')\n");
+    sensorSerialCommand('s');
+    printf("\nLatency ('l')\n");
+    sensorSerialCommand('l');
+    printf("\nBus recorder ('r')\n");
+    sensorSerialCommand('r');
+    printf("\nDisplay ('o')\n");
+    sensorSerialCommand('o');
+    printf("\nShift light ('w')\n");
+    sensorSerialCommand('w');
+    printf("\nBus profile ('p')\n");
+    sensorSerialCommand('p');
+    return 0;
+}
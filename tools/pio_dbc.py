@@ -0,0 +1,28 @@
+# ==========================================================================================
+# CANDISPLAY - a CANBUS display device
+# tools/pio_dbc.py
+#
+# PlatformIO pre-build script: regenerates include/dbc_<name>.h for every dbc/<name>.dbc
+# that is newer than its header, so the signal tables always follow the DBC files.
+# ==========================================================================================
+
+import os
+import sys
+
+Import("env")  # noqa: F821 - provided by PlatformIO
+
+project = env.subst("$PROJECT_DIR")  # noqa: F821
+sys.path.insert(0, os.path.join(project, "tools"))
+
+import dbc2header  # noqa: E402
+
+dbc_dir = os.path.join(project, "dbc")
+for name in sorted(os.listdir(dbc_dir)) if os.path.isdir(dbc_dir) else []:
+    if not name.endswith(".dbc"):
+        continue
+    dbc = os.path.join(dbc_dir, name)
+    header = os.path.join(project, "include", "dbc_%s.h" % os.path.splitext(name)[0].lower())
+    if os.path.exists(header) and os.path.getmtime(header) >= os.path.getmtime(dbc):
+        continue
+    if dbc2header.main([dbc, header]) != 0:
+        env.Exit(1)  # noqa: F821
@@ -0,0 +1,66 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/raw2candump.cpp
+//
+// Converts raw_candump_*.csv logs (either layout, see tools/host/raw_candump.h) into the
+// compact candump_*.csv layout, one frame per line with decimal data bytes:
+//
+//   0x0628A001,0,36,0,128,5,0,0,32
+//
+// The input is memory mapped and the output is formatted into a large buffer without
+// printf, so converting a multi gigabyte log is bound by the disk.
+//
+// Usage: raw2candump raw_candump.csv [candump.csv]      (stdout if no output is given)
+// ==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+
+#include "can_common.h"
+#include "raw_candump.h"
+
+#define OUTPUT_BUFFER (1 << 20)
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "usage: raw2candump raw_candump.csv [candump.csv]\n");
+        return 2;
+    }
+
+    RawCandumpReader reader;
+    if (!reader.open(argv[1]))
+    {
+        fprintf(stderr, "Can't read %s\n", argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "wb") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "Can't write %s\n", argv[2]);
+        return 1;
+    }
+
+    static char buffer[OUTPUT_BUFFER];
+    size_t used = 0;
+    unsigned long frames = 0;
+    for (const CAN_FRAME &frame : reader)
+    {
+        if (used > OUTPUT_BUFFER - 64)
+        {
+            fwrite(buffer, 1, used, out);
+            used = 0;
+        }
+        used += rawFormatCandump(frame, buffer + used);
+        frames++;
+    }
+    fwrite(buffer, 1, used, out);
+    if (out != stdout && fclose(out) != 0)
+    {
+        fprintf(stderr, "Error writing %s\n", argv[2]);
+        return 1;
+    }
+    fprintf(stderr, "%lu frames, %llu lines skipped\n", frames, (unsigned long long)reader.skippedLines());
+    return 0;
+}
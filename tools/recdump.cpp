@@ -0,0 +1,199 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/recdump.cpp
+//
+// Extracts the captures of the firmware's bus recorder (include/recorder.h) from a log of the
+// serial console after 'd': every REC BEGIN <name> <size> ... REC END <name> block is written
+// out as <name> (the binary capture, readable by cap2csv and captureBinLoadFile()) and as
+// <name>.csv, one frame per line:
+//
+//   micros,ms from trigger,0x0628A001,0,36,0,128,5,0,0,32
+//
+// The trigger time comes from the file name the recorder gave the capture. Anything else in
+// the log (other output, console echo) is ignored. A hex line that got garbled on the way,
+// or missing lines, leave a hole in the capture: decoding picks up again at the next key
+// record after it (can_capture.h), and the frames in between are lost.
+//
+// Usage: recdump serial.log [output directory]      (current directory if none is given)
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "can_common.h"
+#include "can_capture.h"
+#include "raw_candump.h"
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// Appends the bytes of one hex line, false if it isn't one
+static bool parseHexLine(const char *line, std::vector<uint8_t> &out)
+{
+    size_t len = strcspn(line, "\r\n");
+    if (len == 0 || len % 2)
+        return false;
+    for (size_t i = 0; i < len; i += 2)
+    {
+        int hi = hexValue(line[i]), lo = hexValue(line[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out.push_back((uint8_t)(hi << 4 | lo));
+    }
+    return true;
+}
+
+// rec<NNNN>-<trigger>-<micros>.cap
+static uint32_t triggerTime(const char *name)
+{
+    const char *dash = strrchr(name, '-');
+    return dash ? (uint32_t)strtoul(dash + 1, NULL, 10) : 0;
+}
+
+// gaps are the byte offsets where a line was missing, in ascending order
+static bool writeCapture(const std::string &dir, const char *name, const std::vector<uint8_t> &bytes,
+                         const std::vector<size_t> &gaps)
+{
+    std::string path = dir + "/" + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f || fwrite(bytes.data(), 1, bytes.size(), f) != bytes.size())
+    {
+        if (f)
+            fclose(f);
+        fprintf(stderr, "Can't write %s\n", path.c_str());
+        return false;
+    }
+    fclose(f);
+
+    std::string csvPath = path + ".csv";
+    FILE *csv = fopen(csvPath.c_str(), "wb");
+    if (!csv)
+    {
+        fprintf(stderr, "Can't write %s\n", csvPath.c_str());
+        return false;
+    }
+
+    CANCaptureReader reader;
+    uint32_t trigger = triggerTime(name);
+    size_t pos = CAN_CAPTURE_HEADER_SIZE, gap = 0;
+    long frames = 0, before = 0, holes = 0;
+    char line[64];
+    bool header = canCaptureIsHeader(bytes.data(), bytes.size());
+
+    while (header && pos < bytes.size())
+    {
+        while (gap < gaps.size() && gaps[gap] < pos)
+            gap++;
+        size_t end = gap < gaps.size() ? gaps[gap] : bytes.size(); // records don't run across a hole
+        CAN_FRAME frame;
+        bool isFrame;
+        int n = pos < end ? reader.next(&bytes[pos], end - pos, frame, isFrame) : CAN_CAPTURE_MORE;
+        if (n <= 0)
+        {
+            holes++;
+            size_t from = n == CAN_CAPTURE_ERROR || end == bytes.size() ? pos + 1 : end;
+            pos = from + canCaptureFindKey(&bytes[from], bytes.size() - from);
+            continue;
+        }
+        pos += n;
+        if (!isFrame)
+            continue;
+        int32_t offset = (int32_t)(frame.timestamp - trigger);
+        rawFormatCandump(frame, line);
+        fprintf(csv, "%u,%.3f,%s", (unsigned int)frame.timestamp, offset / 1000.0, line);
+        frames++;
+        if (offset < 0)
+            before++;
+    }
+    fclose(csv);
+
+    bool ok = header && !holes;
+    printf("%s: %ld frames, %ld before and %ld after the trigger", name, frames, before, frames - before);
+    if (!header)
+        printf(", not a capture\n");
+    else if (holes)
+        printf(", %ld hole(s): frames up to the next key record lost\n", holes);
+    else
+        printf("\n");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "usage: recdump serial.log [output directory]\n");
+        return 2;
+    }
+    FILE *log = fopen(argv[1], "rb");
+    if (!log)
+    {
+        fprintf(stderr, "Can't read %s\n", argv[1]);
+        return 1;
+    }
+    std::string dir = argc > 2 ? argv[2] : ".";
+
+    char line[512];
+    char name[64] = "";
+    unsigned long size = 0;
+    bool inside = false;
+    int extracted = 0, failed = 0;
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> gaps;
+
+    while (fgets(line, sizeof(line), log))
+    {
+        const char *rec = strstr(line, "REC ");
+        if (rec && sscanf(rec, "REC BEGIN %63s %lu", name, &size) == 2)
+        {
+            if (inside)
+            {
+                fprintf(stderr, "%s: no REC END, skipped\n", name);
+                failed++;
+            }
+            inside = !strchr(name, '/') && strcmp(name, "..") != 0;
+            bytes.clear();
+            gaps.clear();
+        }
+        else if (inside && rec && !strncmp(rec, "REC END", 7))
+        {
+            inside = false;
+            if (bytes.size() != size)
+            {
+                fprintf(stderr, "%s: %zu of %lu bytes, lines are missing\n", name, bytes.size(), size);
+                if (gaps.empty())
+                    gaps.push_back(CAN_CAPTURE_HEADER_SIZE); // somewhere, trust nothing before the first key
+            }
+            if (writeCapture(dir, name, bytes, gaps) && bytes.size() == size)
+                extracted++;
+            else
+                failed++;
+        }
+        else if (inside && !parseHexLine(line, bytes))
+        {
+            fprintf(stderr, "%s: ignoring \"%.*s\"\n", name, (int)strcspn(line, "\r\n"), line);
+            if (gaps.empty() || gaps.back() != bytes.size())
+                gaps.push_back(bytes.size());
+        }
+    }
+    fclose(log);
+    if (inside)
+    {
+        fprintf(stderr, "%s: log ends before REC END, skipped\n", name);
+        failed++;
+    }
+
+    printf("%d capture(s) extracted, %d failed\n", extracted, failed);
+    return failed ? 1 : 0;
+}
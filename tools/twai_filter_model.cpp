@@ -0,0 +1,121 @@
+// ==========================================================================================
+// CANDISPLAY - a CANBUS display device
+// tools/twai_filter_model.cpp
+//
+// Host model of the TWAI acceptance filter. Computes the hardware filter ESP32CAN derives
+// from a set of software filters (twaiCoverFilters) and replays the recorded captures
+// through it, reporting how much traffic the controller would reject before any software
+// runs. Also checks that nothing the software filters accept is lost in hardware.
+//
+// Usage: twai_filter_model [-f id[/mask]]... [capture.csv ...]
+//        default filter is the engine speed frame 0x0618A001, default captures are all the
+//        candump_*.csv and raw_candump_*.csv files in the current directory
+// ==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "can_common.h"
+#include "twai_filter_cover.h"
+#include "capture_csv.h"
+
+#define MAX_FILTERS 32
+
+static const char *defaultCaptures[] = {
+    "candump_08-03-22-15-14.csv", "candump_08-03-22-18-12.csv", "candump_08-04-22-13-43.csv",
+    "raw_candump_08-03-22-15-14.csv", "raw_candump_08-03-22-18-12.csv", "raw_candump_08-04-22-13-43.csv"};
+
+int main(int argc, char **argv)
+{
+    uint32_t ids[MAX_FILTERS], masks[MAX_FILTERS];
+    bool ext[MAX_FILTERS];
+    int count = 0;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-f") && i + 1 < argc && count < MAX_FILTERS)
+        {
+            char *slash;
+            ids[count] = (uint32_t)strtoul(argv[++i], &slash, 16);
+            ext[count] = ids[count] > 0x7FF;
+            masks[count] = *slash == '/' ? (uint32_t)strtoul(slash + 1, NULL, 16) : (ext[count] ? 0x1FFFFFFF : 0x7FF);
+            ids[count] &= masks[count];
+            count++;
+        }
+        else
+            files.push_back(argv[i]);
+    }
+    if (count == 0)
+    {
+        ids[0] = 0x0618A001;
+        masks[0] = 0x1FFFFFFF;
+        ext[0] = true;
+        count = 1;
+    }
+    if (files.empty())
+        files.assign(defaultCaptures, defaultCaptures + sizeof(defaultCaptures) / sizeof(defaultCaptures[0]));
+
+    TWAI_FILTER_COVER cover;
+    twaiCoverFilters(ids, masks, ext, count, cover);
+
+    printf("Software filters:\n");
+    for (int i = 0; i < count; i++)
+        printf("  %2d  id %08X mask %08X %s\n", i, ids[i], masks[i], ext[i] ? "ext" : "std");
+    printf("TWAI filter: code %08X mask %08X %s\n\n", cover.acceptance_code, cover.acceptance_mask,
+           cover.single_filter ? "single" : "dual");
+
+    printf("%-32s %8s %8s %8s %10s\n", "capture", "frames", "hw pass", "sw pass", "hw reject");
+    long totFrames = 0, totHw = 0, totSw = 0, lost = 0;
+    std::map<uint32_t, long> passedIds;
+
+    for (const std::string &file : files)
+    {
+        std::vector<CAN_FRAME> frames;
+        if (captureLoadFile(file.c_str(), frames) < 0)
+        {
+            fprintf(stderr, "Can't read %s\n", file.c_str());
+            continue;
+        }
+        long hw = 0, sw = 0;
+        for (const CAN_FRAME &f : frames)
+        {
+            bool hwPass = twaiFilterAccepts(cover, f.id, f.extended, f.rtr, f.length, f.data.byte);
+            bool swPass = false;
+            for (int i = 0; i < count && !swPass; i++)
+                swPass = (f.id & masks[i]) == ids[i] && (bool)f.extended == ext[i];
+            if (hwPass)
+            {
+                hw++;
+                passedIds[f.id]++;
+            }
+            if (swPass)
+                sw++;
+            if (swPass && !hwPass)
+                lost++;
+        }
+        printf("%-32s %8zu %8ld %8ld %9.1f%%\n", file.c_str(), frames.size(), hw, sw,
+               frames.empty() ? 0.0 : 100.0 * (frames.size() - hw) / frames.size());
+        totFrames += frames.size();
+        totHw += hw;
+        totSw += sw;
+    }
+
+    printf("%-32s %8ld %8ld %8ld %9.1f%%\n\n", "total", totFrames, totHw, totSw,
+           totFrames ? 100.0 * (totFrames - totHw) / totFrames : 0.0);
+
+    printf("IDs passed by the hardware filter:\n");
+    for (auto &p : passedIds)
+        printf("  %08X %8ld\n", p.first, p.second);
+
+    if (lost)
+    {
+        printf("\nERROR: %ld frames accepted by the software filters were rejected in hardware\n", lost);
+        return 1;
+    }
+    return 0;
+}